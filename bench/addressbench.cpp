@@ -0,0 +1,59 @@
+#include "bench.h"
+
+// address lookups written the ways a user would type them, with and without snapping to a road
+static int addressBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 10000 : stoul(args[0]);
+    const vector<AddressIndex::Address> &addresses = model.getAddressIndex().addresses();
+    report("addresses", addresses.size(), "addresses");
+    report("streets", model.getAddressIndex().streetCount(), "streets");
+    if(addresses.empty())
+        return 0;
+
+    vector<string> queries;
+    mt19937 gen(42);
+    for(size_t i = 0; i < count; i ++)
+    {
+        const AddressIndex::Address &a = addresses[gen() % addresses.size()];
+        switch(i % 3)
+        {
+        case 0:
+            queries.emplace_back(a.housenumber + " " + a.street);
+            break;
+        case 1:
+            queries.emplace_back(a.housenumber + ", " + a.street + " " + a.postcode + " Le Creusot");
+            break;
+        default:
+            queries.emplace_back(a.street + " " + a.housenumber);
+        }
+    }
+
+    size_t exact = 0;
+    vector<double> samples;
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+    {
+        benchTimer timer;
+        AddressIndex::Result result = model.getAddressIndex().lookup(*it);
+        samples.emplace_back(timer.elapsed());
+        exact += result.exactNumber;
+    }
+    report("exact number found", double(exact) / count, "ratio");
+    report("lookup p50", percentile(samples, 50), "us");
+    report("lookup p99", percentile(samples, 99), "us");
+
+    size_t snapped = 0;
+    samples.clear();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+    {
+        benchTimer timer;
+        AddressIndex::Result result = model.geocodeAddress(*it);
+        samples.emplace_back(timer.elapsed());
+        snapped += result.node != 0;
+    }
+    report("snapped to a road", double(snapped) / count, "ratio");
+    report("lookup and snap p50", percentile(samples, 50), "us");
+    report("lookup and snap p99", percentile(samples, 99), "us");
+    return 0;
+}
+
+static benchRegister addressRegister("address", "[queries] forward geocoding of the addresses of the file", addressBench);
@@ -0,0 +1,75 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <QRectF>
+#include "model.h"
+
+using namespace std;
+
+// a benchmark gets the loaded model and the remaining command line arguments
+typedef function<int(Model &, const vector<string> &)> benchFunction;
+
+struct benchCommand
+{
+    string name;
+    string help;
+    benchFunction run;
+};
+
+// every bench file registers its commands in this list (see mapbench.cpp)
+vector<benchCommand> &benchCommands();
+
+struct benchRegister
+{
+    benchRegister(string name, string help, benchFunction run)
+    {
+        benchCommands().push_back(benchCommand{name, help, run});
+    }
+};
+
+class benchTimer
+{
+    chrono::steady_clock::time_point m_start;
+
+public:
+    benchTimer() : m_start(chrono::steady_clock::now()) {}
+
+    void restart()
+    {
+        m_start = chrono::steady_clock::now();
+    }
+
+    // elapsed time in micro seconds
+    double elapsed() const
+    {
+        return chrono::duration<double, micro>(chrono::steady_clock::now() - m_start).count();
+    }
+};
+
+// value at the given percentile (0-100) of the samples, the vector gets sorted
+double percentile(vector<double> &samples, double p);
+
+// random squares inside the bounds of the model, with a side between minSide and maxSide
+vector<QRectF> randomRects(const QRectF &bounds, size_t count, double minSide, double maxSide, unsigned seed = 42);
+
+vector<QPointF> randomPoints(const QRectF &bounds, size_t count, unsigned seed = 42);
+
+// resident memory of the process in kB (VmRSS of /proc/self/status), 0 where it is unknown
+double residentMemory();
+
+// highest resident memory of the process so far in kB (VmHWM)
+double peakMemory();
+
+// report() prints one JSON object per line instead of text (mapbench --json ...)
+void setJsonOutput(bool json);
+
+// print one result line, "name: value unit"
+void report(const string &name, double value, const string &unit);
+
+#endif // BENCH_H
@@ -0,0 +1,75 @@
+#include "bench.h"
+#include <thread>
+
+// a GPS log: a random walk of 5 m steps inside the bounds of the model
+static vector<QPointF> randomTrack(const QRectF &bounds, size_t count, unsigned seed = 42)
+{
+    vector<QPointF> track;
+    mt19937 gen(seed);
+    normal_distribution<double> step(0, 5);
+    QPointF pos = bounds.center();
+    for(size_t i = 0; i < count; i ++)
+    {
+        pos += QPointF(step(gen), step(gen));
+        pos.setX(min(max(pos.x(), bounds.left()), bounds.right()));
+        pos.setY(min(max(pos.y(), bounds.top()), bounds.bottom()));
+        track.emplace_back(pos);
+    }
+    return track;
+}
+
+// single lookups and batches against the thread count
+static int geocodeBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 100000 : stoul(args[0]);
+    QRectF bounds = model.getBounds();
+    vector<QPointF> points = randomPoints(bounds, count);
+    vector<QPointF> track = randomTrack(bounds, count);
+
+    size_t found[3] = {0, 0, 0};
+    vector<double> samples;
+    for(auto it = points.begin(); it != points.end(); it ++)
+    {
+        benchTimer timer;
+        ReverseGeocoder::Result result = model.reverseGeocode(*it);
+        samples.emplace_back(timer.elapsed());
+        found[0] += result.poi.id != 0;
+        found[1] += result.area.id != 0;
+        found[2] += result.street.id != 0;
+    }
+    report("lookup p50", percentile(samples, 50), "us");
+    report("lookup p99", percentile(samples, 99), "us");
+    report("place found", double(found[0]) / count, "ratio");
+    report("area found", double(found[1]) / count, "ratio");
+    report("street found", double(found[2]) / count, "ratio");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    vector<ReverseGeocoder::Result> reference;
+    size_t mismatch = 0;
+    for(unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? min(threads * 2, maxThreads) : threads + 1)
+    {
+        benchTimer timer;
+        vector<ReverseGeocoder::Result> results = model.reverseGeocode(points, threads);
+        report("random points, " + to_string(threads) + " threads", count / timer.elapsed() * 1e6, "lookups/s");
+
+        timer.restart();
+        model.reverseGeocode(track, threads);
+        report("gps track, " + to_string(threads) + " threads", count / timer.elapsed() * 1e6, "lookups/s");
+
+        if(threads == 1)
+            reference.swap(results);
+        else
+        {
+            for(size_t i = 0; i < count; i ++)
+            {
+                if(results[i].poi.id != reference[i].poi.id || results[i].area.id != reference[i].area.id
+                        || results[i].street.id != reference[i].street.id)
+                    mismatch ++;
+            }
+        }
+    }
+    report("batch results different from one thread", mismatch, "lookups");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister geocodeRegister("geocode", "[lookups] reverse geocoding latency and batch throughput", geocodeBench);
@@ -0,0 +1,174 @@
+#include "bench.h"
+#include "rtree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// the text-then-filter search the spatial queries replace: every match of the file, then the area
+static vector<idType> floodSearch(Model &model, const string &text, const QRectF &rect)
+{
+    vector<catagoryData> all;
+    if(model.isAmenityTypeExist(text))
+        all = model.searchAmenityByType(text);
+    vector<catagoryData> byName = model.searchAmenityByName(text);
+    all.insert(all.end(), byName.begin(), byName.end());
+
+    vector<idType> result;
+    for(auto it = all.begin(); it != all.end(); it ++)
+    {
+        if(rect.contains(it->position))
+            result.emplace_back(it->id);
+    }
+    sort(result.begin(), result.end());
+    result.erase(unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+static vector<idType> sortedIds(const vector<catagoryData> &result)
+{
+    vector<idType> ids;
+    for(auto it = result.begin(); it != result.end(); it ++)
+        ids.emplace_back(it->id);
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+// the catalog of the loaded file: text + view queries against searching everything then filtering
+static void modelGeoSearch(Model &model, size_t count)
+{
+    model.buildAmenityCatalog();
+    const vector<catagoryData> &catalog = model.getAmenityCatalog();
+    report("catalog size", catalog.size(), "entries");
+    if(catalog.empty())
+        return;
+
+    vector<QRectF> views = randomRects(model.getBounds(), count, 1000, 5000);
+    vector<string> texts;
+    mt19937 gen(7);
+    for(size_t i = 0; i < count; i ++)
+    {
+        const catagoryData &data = catalog[gen() % catalog.size()];
+        texts.emplace_back(data.name.empty() || gen() % 2 ? data.type : data.name.front());
+    }
+
+    size_t mismatch = 0;
+    for(size_t i = 0; i < count; i ++)
+    {
+        if(sortedIds(model.searchAmenityInRect(texts[i], views[i], numeric_limits<size_t>::max())) != floodSearch(model, texts[i], views[i]))
+            mismatch ++;
+    }
+    report("results different from search then filter", mismatch, "queries");
+
+    vector<double> samples;
+    for(size_t i = 0; i < count; i ++)
+    {
+        benchTimer timer;
+        model.searchAmenityInRect(texts[i], views[i], 50);
+        samples.emplace_back(timer.elapsed());
+    }
+    report("view search p50", percentile(samples, 50), "us");
+    report("view search p99", percentile(samples, 99), "us");
+
+    samples.clear();
+    for(size_t i = 0; i < count; i ++)
+    {
+        benchTimer timer;
+        model.searchAmenityNear(texts[i], views[i].center(), 2000, 50);
+        samples.emplace_back(timer.elapsed());
+    }
+    report("2 km radius search p50", percentile(samples, 50), "us");
+    report("2 km radius search p99", percentile(samples, 99), "us");
+
+    samples.clear();
+    for(size_t i = 0; i < count; i ++)
+    {
+        benchTimer timer;
+        floodSearch(model, texts[i], views[i]);
+        samples.emplace_back(timer.elapsed());
+    }
+    report("search then filter p50", percentile(samples, 50), "us");
+    report("search then filter p99", percentile(samples, 99), "us");
+}
+
+// a synthetic country: places spread over 1000 km, types with a skewed frequency
+// (a common type like "restaurant" and rare ones), same R-tree walk as the model
+static void syntheticGeoSearch(size_t maxSize, size_t count)
+{
+    const double side = 1e6;
+    const unsigned typeCount = 200;
+    for(size_t size = 10000; size <= maxSize; size *= 10)
+    {
+        mt19937 gen(42);
+        uniform_real_distribution<double> coordinate(0, side);
+        vector<QPointF> positions(size);
+        vector<uint16_t> types(size);
+        vector<RTree::Entry> entries(size);
+        for(size_t i = 0; i < size; i ++)
+        {
+            positions[i] = QPointF(coordinate(gen), coordinate(gen));
+            // type t has a frequency in 1 / (t + 1)
+            double u = uniform_real_distribution<double>(0, 1)(gen);
+            types[i] = min<unsigned>(typeCount - 1, static_cast<unsigned>(exp(u * log(double(typeCount))) - 1));
+            entries[i].box = QRectF(positions[i], positions[i]);
+            entries[i].id = i;
+        }
+        benchTimer timer;
+        RTree index;
+        index.bulkLoad(entries);
+        string prefix = to_string(size) + " places, ";
+        report(prefix + "index build", timer.elapsed() / 1000, "ms");
+
+        vector<QRectF> views = randomRects(QRectF(0, 0, side, side), count, 2000, 5000);
+        for(unsigned type = 0; type < typeCount; type += typeCount / 2 - 1)
+        {
+            size_t found = 0;
+            timer.restart();
+            for(auto view = views.begin(); view != views.end(); view ++)
+            {
+                double radius = sqrt(view->width() * view->width() + view->height() * view->height()) / 2;
+                size_t hits = 0;
+                index.visitNearest(view->center(), radius, [&](idType id, double)
+                {
+                    if(types[id] == type && view->contains(positions[id]))
+                        hits ++;
+                    return hits < 50;
+                });
+                found += hits;
+            }
+            string name = prefix + "type " + to_string(type);
+            report(name + " view search", timer.elapsed() / count, "us/query");
+            report(name + " hits", double(found) / count, "places/query");
+
+            // a full scan per query, a few of them are enough
+            size_t scans = min<size_t>(count, 20);
+            timer.restart();
+            for(auto view = views.begin(); view != views.begin() + scans; view ++)
+            {
+                vector<pair<double, size_t>> hits;
+                for(size_t i = 0; i < size; i ++)
+                {
+                    if(types[i] == type && view->contains(positions[i]))
+                    {
+                        QPointF d = positions[i] - view->center();
+                        hits.emplace_back(QPointF::dotProduct(d, d), i);
+                    }
+                }
+                sort(hits.begin(), hits.end());
+            }
+            report(name + " scan then filter", timer.elapsed() / scans, "us/query");
+        }
+    }
+}
+
+// text + area queries, on the loaded file and on synthetic catalogs up to country size
+static int geoSearchBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.size() > 0 ? stoul(args[0]) : 1000;
+    size_t maxSize = args.size() > 1 ? stoul(args[1]) : 10000000;
+    modelGeoSearch(model, count);
+    syntheticGeoSearch(maxSize, count);
+    return 0;
+}
+
+static benchRegister geoSearchRegister("geosearch", "[queries] [max places] text search in the view and around a point", geoSearchBench);
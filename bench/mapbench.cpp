@@ -0,0 +1,144 @@
+/*
+ * command line benchmarks of the model and the scene
+ * usage: mapbench [--json] <command> <file.pbf> [arguments]
+ */
+#include "bench.h"
+#include <algorithm>
+#include <fstream>
+#include <QApplication>
+
+vector<benchCommand> &benchCommands()
+{
+    static vector<benchCommand> commands;
+    return commands;
+}
+
+double percentile(vector<double> &samples, double p)
+{
+    if(samples.empty())
+        return 0;
+    sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[min(rank, samples.size() - 1)];
+}
+
+vector<QRectF> randomRects(const QRectF &bounds, size_t count, double minSide, double maxSide, unsigned seed)
+{
+    mt19937 gen(seed);
+    uniform_real_distribution<double> side(minSide, maxSide);
+    uniform_real_distribution<double> x(bounds.left(), bounds.right());
+    uniform_real_distribution<double> y(bounds.top(), bounds.bottom());
+    vector<QRectF> rects;
+    rects.reserve(count);
+    for(size_t i = 0; i < count; i ++)
+    {
+        double s = side(gen);
+        rects.emplace_back(QRectF(x(gen) - s / 2, y(gen) - s / 2, s, s));
+    }
+    return rects;
+}
+
+vector<QPointF> randomPoints(const QRectF &bounds, size_t count, unsigned seed)
+{
+    mt19937 gen(seed);
+    uniform_real_distribution<double> x(bounds.left(), bounds.right());
+    uniform_real_distribution<double> y(bounds.top(), bounds.bottom());
+    vector<QPointF> points;
+    points.reserve(count);
+    for(size_t i = 0; i < count; i ++)
+        points.emplace_back(QPointF(x(gen), y(gen)));
+    return points;
+}
+
+static double procStatus(const string &field)
+{
+    ifstream status("/proc/self/status");
+    string line;
+    while(getline(status, line))
+    {
+        if(line.compare(0, field.size(), field) == 0)
+            return stod(line.substr(field.size()));
+    }
+    return 0;
+}
+
+double residentMemory()
+{
+    return procStatus("VmRSS:");
+}
+
+double peakMemory()
+{
+    return procStatus("VmHWM:");
+}
+
+static bool jsonOutput = false;
+
+void setJsonOutput(bool json)
+{
+    jsonOutput = json;
+}
+
+// the names are made by the benchmarks, only quotes and backslashes need escaping
+static string jsonString(const string &text)
+{
+    string result = "\"";
+    for(auto it = text.begin(); it != text.end(); it ++)
+    {
+        if(*it == '"' || *it == '\\')
+            result += '\\';
+        result += *it;
+    }
+    return result + "\"";
+}
+
+void report(const string &name, double value, const string &unit)
+{
+    if(jsonOutput)
+        std::cout << "{\"name\": " << jsonString(name) << ", \"value\": " << value << ", \"unit\": " << jsonString(unit) << "}" << std::endl;
+    else
+        std::cout << name << ": " << value << " " << unit << std::endl;
+}
+
+static void usage()
+{
+    std::cout << "usage: mapbench [--json] <command> <file.pbf> [arguments]" << std::endl;
+    for(auto it = benchCommands().begin(); it != benchCommands().end(); it ++)
+        std::cout << "  " << it->name << "\t" << it->help << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // the scene needs a QApplication, but there is no display on a build machine
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    // one JSON object per result, for the build machines
+    if(argc > 1 && string(argv[1]) == "--json")
+    {
+        setJsonOutput(true);
+        argv ++;
+        argc --;
+    }
+
+    if(argc < 3)
+    {
+        usage();
+        return 1;
+    }
+
+    string name = argv[1];
+    auto command = find_if(benchCommands().begin(), benchCommands().end(),
+                           [&](const benchCommand &c) { return c.name == name; });
+    if(command == benchCommands().end())
+    {
+        usage();
+        return 1;
+    }
+
+    Model model;
+    model.setFilePath(argv[2]);
+    vector<string> args(argv + 3, argv + argc);
+    return command->run(model, args);
+}
@@ -0,0 +1,563 @@
+#include "bench.h"
+#include "SceneBuilder.h"
+#include "mapview.h"
+#include "tilecache.h"
+#include <QImage>
+#include <QPainter>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsTextItem>
+#include <fstream>
+#include <sstream>
+
+// time to draw one frame of the given part of the scene into an image of the view size
+static double frameTime(QGraphicsScene *scene, const QRectF &source, QImage &image, int frames)
+{
+    vector<double> samples;
+    for(int i = 0; i < frames; i ++)
+    {
+        image.fill(QColor(230, 230, 230));
+        QPainter painter(&image);
+        benchTimer timer;
+        scene->render(&painter, QRectF(image.rect()), source);
+        painter.end();
+        samples.emplace_back(timer.elapsed());
+    }
+    return percentile(samples, 50);
+}
+
+// frame time from the closest zoom to the farthest, with and without the simplified geometry
+static int lodBench(Model &model, const vector<string> &args)
+{
+    int frames = args.empty() ? 5 : stoi(args[0]);
+    const int width = 1280;
+    const int height = 800;
+
+    SceneBuilder builder(&model);
+    benchTimer timer;
+    builder.addAllItem();
+    report("scene build with simplification", timer.elapsed() / 1000, "ms");
+
+    QGraphicsScene *scene = builder.getScene();
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    QPointF center = model.getBounds().center();
+
+    // four wheel steps between two measures
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP * ZOOM_STEP * ZOOM_STEP)
+    {
+        QRectF source(0, 0, width / scale, height / scale);
+        source.moveCenter(center);
+        builder.cullToViewport(source);
+
+        LevelOfDetail::setEnabled(false);
+        double full = frameTime(scene, source, image, frames);
+        LevelOfDetail::setEnabled(true);
+        double simplified = frameTime(scene, source, image, frames);
+
+        string name = "scale " + to_string(scale);
+        report(name + " full resolution", full / 1000, "ms/frame");
+        report(name + " simplified", simplified / 1000, "ms/frame");
+    }
+    return 0;
+}
+
+static benchRegister lodRegister("lod", "[frames] frame time at each zoom level, full and simplified geometry", lodBench);
+
+// the scene as it was before the batches: one item per way, each one with its own pen or brush
+static size_t buildPerWayScene(Model &model, QGraphicsScene *scene)
+{
+    const map<idType, wayData> wayMap = model.getWayMap();
+    size_t items = 0;
+    for(auto it = wayMap.begin(); it != wayMap.end(); it ++)
+    {
+        QPolygonF polygon;
+        for(auto node = it->second.nodeRefList.begin(); node != it->second.nodeRefList.end(); node ++)
+            polygon << projection(model.getNodeLoaction(*node));
+        if(polygon.isEmpty())
+            continue;
+        QGraphicsItem *item;
+        if(it->second.isPolygon)
+        {
+            QGraphicsPolygonItem *area = new QGraphicsPolygonItem(polygon);
+            area->setBrush(getPolygonColor(it->second.pType));
+            area->setZValue(it->second.pType);
+            item = area;
+        }
+        else
+        {
+            QPainterPath path;
+            path.addPolygon(polygon);
+            QGraphicsPathItem *road = new QGraphicsPathItem(path);
+            QPen pen(getPathColor(it->second.rType));
+            pen.setWidth(getPathWidth(it->second.rType) + 3.0);
+            pen.setCapStyle(Qt::RoundCap);
+            road->setPen(pen);
+            road->setZValue(leisure + static_cast<int>(it->second.rType) * 0.1);
+            item = road;
+        }
+        scene->addItem(item);
+        items ++;
+    }
+    return items;
+}
+
+// one item per way against the batches of SceneBuilder: items, memory and frame time
+static int batchBench(Model &model, const vector<string> &args)
+{
+    int frames = args.empty() ? 5 : stoi(args[0]);
+    const int width = 1280;
+    const int height = 800;
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    QPointF center = model.getBounds().center();
+
+    double memory = residentMemory();
+    benchTimer timer;
+    QGraphicsScene *perWay = new QGraphicsScene;
+    perWay->setItemIndexMethod(QGraphicsScene::NoIndex);
+    size_t items = buildPerWayScene(model, perWay);
+    report("one item per way build", timer.elapsed() / 1000, "ms");
+    report("one item per way items", items, "items");
+    report("one item per way memory", (residentMemory() - memory) / 1024, "MB");
+
+    memory = residentMemory();
+    timer.restart();
+    SceneBuilder builder(&model);
+    builder.addAllItem();
+    report("batches build", timer.elapsed() / 1000, "ms");
+    report("batches items", builder.batchCount(), "items");
+    report("batches memory", (residentMemory() - memory) / 1024, "MB");
+
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP * ZOOM_STEP * ZOOM_STEP)
+    {
+        QRectF source(0, 0, width / scale, height / scale);
+        source.moveCenter(center);
+        builder.cullToViewport(source);
+
+        string name = "scale " + to_string(scale);
+        report(name + " one item per way", frameTime(perWay, source, image, frames) / 1000, "ms/frame");
+        report(name + " batches", frameTime(builder.getScene(), source, image, frames) / 1000, "ms/frame");
+    }
+    delete perWay;
+    return 0;
+}
+
+static benchRegister batchRegister("batch", "[frames] scene of one item per way against the batched scene", batchBench);
+
+// the shared point buffer of the model against one QPolygonF per way, then the scene built on it
+static int geometryBench(Model &model, const vector<string> &args)
+{
+    (void)args;
+    const GeometryStore &geometry = model.getGeometry();
+    report("geometry store ways", geometry.wayCount(), "ways");
+    report("geometry store points", geometry.pointCount(), "points");
+    report("geometry store memory", geometry.memory() / 1024.0 / 1024, "MB");
+
+    // what every item and the tiles used to keep: a projected copy of each way
+    double memory = residentMemory();
+    benchTimer timer;
+    vector<LevelOfDetail> copies;
+    const map<idType, wayData> wayMap = model.getWayMap();
+    copies.reserve(wayMap.size());
+    for(auto it = wayMap.begin(); it != wayMap.end(); it ++)
+    {
+        QPolygonF polygon;
+        polygon.reserve(it->second.nodeRefList.size());
+        for(auto node = it->second.nodeRefList.begin(); node != it->second.nodeRefList.end(); node ++)
+            polygon << projection(model.getNodeLoaction(*node));
+        copies.emplace_back();
+        copies.back().build(polygon, it->second.isPolygon);
+    }
+    report("copied ways build", timer.elapsed() / 1000, "ms");
+    report("copied ways memory", (residentMemory() - memory) / 1024, "MB");
+
+    memory = residentMemory();
+    timer.restart();
+    vector<LevelOfDetail> spans;
+    spans.reserve(wayMap.size());
+    for(auto it = wayMap.begin(); it != wayMap.end(); it ++)
+    {
+        spans.emplace_back();
+        spans.back().build(geometry.points(it->first), it->second.isPolygon);
+    }
+    report("shared ways build", timer.elapsed() / 1000, "ms");
+    report("shared ways memory", (residentMemory() - memory) / 1024, "MB");
+    copies.clear();
+    spans.clear();
+
+    memory = residentMemory();
+    timer.restart();
+    SceneBuilder builder(&model);
+    builder.addAllItem();
+    report("scene build", timer.elapsed() / 1000, "ms");
+    report("scene memory", (residentMemory() - memory) / 1024, "MB");
+    return 0;
+}
+
+static benchRegister geometryRegister("geometry", "shared geometry buffer against one copy of the points per way", geometryBench);
+
+// the batches as items of a scene with the BSP index against the static layer: build, frames,
+// and the pins added after load (the scene rect was saved and set again for each of them)
+static int staticBench(Model &model, const vector<string> &args)
+{
+    int frames = args.empty() ? 5 : stoi(args[0]);
+    const int width = 1280;
+    const int height = 800;
+    const int pins = 200;
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    QPointF center = model.getBounds().center();
+    const GeometryStore &geometry = model.getGeometry();
+
+    // same batches as SceneBuilder, each one added to the scene
+    benchTimer timer;
+    QGraphicsScene *indexed = new QGraphicsScene;
+    indexed->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+    map<tuple<bool, int, int, int>, WayBatch *> batches;
+    const map<idType, wayData> wayMap = model.getWayMap();
+    for(auto it = wayMap.begin(); it != wayMap.end(); it ++)
+    {
+        const wayData &way = it->second;
+        PointSpan points = geometry.points(it->first);
+        if(points.size == 0)
+            continue;
+        QRectF bound = geometry.bounds(it->first);
+        auto key = make_tuple(way.isPolygon, way.isPolygon ? static_cast<int>(way.pType) : static_cast<int>(way.rType),
+                              static_cast<int>(floor(bound.center().x() / BATCH_CELL)), static_cast<int>(floor(bound.center().y() / BATCH_CELL)));
+        WayBatch *&batch = batches[key];
+        if(batch == nullptr)
+        {
+            batch = way.isPolygon ? new WayBatch(way.pType) : new WayBatch(way.rType);
+            indexed->addItem(batch);
+        }
+        batch->addWay(it->first, points, bound);
+    }
+    // the BSP tree is built on the first query
+    indexed->items(QRectF(center, QSizeF(1, 1)));
+    report("scene items build", timer.elapsed() / 1000, "ms");
+
+    timer.restart();
+    SceneBuilder builder(&model);
+    builder.addAllItem();
+    report("static layer build", timer.elapsed() / 1000, "ms");
+    report("batches", builder.batchCount(), "items");
+
+    vector<QPointF> positions = randomPoints(model.getBounds(), pins);
+    timer.restart();
+    for(auto it = positions.begin(); it != positions.end(); it ++)
+    {
+        Pin *pin = new Pin(0);
+        pin->setPos(*it);
+        auto rect = indexed->sceneRect();
+        indexed->addItem(pin);
+        indexed->setSceneRect(rect);
+        indexed->items(QRectF(*it, QSizeF(1, 1)));
+    }
+    report("scene items pin", timer.elapsed() / pins, "us/pin");
+    timer.restart();
+    for(auto it = positions.begin(); it != positions.end(); it ++)
+    {
+        Pin *pin = new Pin(0);
+        pin->setPos(*it);
+        builder.getScene()->addItem(pin);
+        builder.getScene()->items(QRectF(*it, QSizeF(1, 1)));
+    }
+    report("static layer pin", timer.elapsed() / pins, "us/pin");
+
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP * ZOOM_STEP * ZOOM_STEP)
+    {
+        QRectF source(0, 0, width / scale, height / scale);
+        source.moveCenter(center);
+        builder.cullToViewport(source);
+
+        string name = "scale " + to_string(scale);
+        report(name + " scene items", frameTime(indexed, source, image, frames) / 1000, "ms/frame");
+        report(name + " static layer", frameTime(builder.getScene(), source, image, frames) / 1000, "ms/frame");
+    }
+    delete indexed;
+    return 0;
+}
+
+static benchRegister staticRegister("static", "[frames] way batches as indexed scene items against the static layer", staticBench);
+
+// raster tiles: rendering one tile, filling a view on the worker threads, then reading the cache
+static int tileBench(Model &model, const vector<string> &args)
+{
+    unsigned threads = args.empty() ? 0 : stoul(args[0]);
+    const int width = 1280;
+    const int height = 800;
+    QPointF center = model.getBounds().center();
+
+    TileCache cache(256 << 20, threads);
+    benchTimer timer;
+    cache.build(model);
+    report("tile geometry build", timer.elapsed() / 1000, "ms");
+
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP * ZOOM_STEP * ZOOM_STEP)
+    {
+        QRectF view(0, 0, width / scale, height / scale);
+        view.moveCenter(center);
+        int z = TileCache::zoomFor(scale);
+        vector<TileKey> keys = TileCache::tilesIn(view, z);
+        string name = "zoom " + to_string(z);
+
+        vector<double> samples;
+        for(auto it = keys.begin(); it != keys.end(); it ++)
+        {
+            timer.restart();
+            cache.render(*it);
+            samples.emplace_back(timer.elapsed());
+        }
+        report(name + " tile render p50", percentile(samples, 50) / 1000, "ms");
+        report(name + " tile render p95", percentile(samples, 95) / 1000, "ms");
+
+        // the view and the ring of tiles around it
+        timer.restart();
+        cache.request(view, scale);
+        cache.waitForIdle();
+        report(name + " view and prefetch on the workers", timer.elapsed() / 1000, "ms");
+
+        timer.restart();
+        size_t hits = 0;
+        for(auto it = keys.begin(); it != keys.end(); it ++)
+            hits += cache.tile(*it).isNull() ? 0 : 1;
+        report(name + " cached view lookup", timer.elapsed(), "us");
+        report(name + " cached tiles of the view", hits, "tiles");
+    }
+    report("tile cache memory", cache.memoryUsed() / double(1 << 20), "MB");
+    report("tile cache tiles", cache.tileCount(), "tiles");
+    return 0;
+}
+
+static benchRegister tileRegister("tiles", "[threads] raster tile rendering and cache at each zoom level", tileBench);
+
+// labels: one text item per named node as before, against the label engine at each zoom
+static int labelBench(Model &model, const vector<string> &args)
+{
+    int frames = args.empty() ? 5 : stoi(args[0]);
+    const int width = 1280;
+    const int height = 800;
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    QPointF center = model.getBounds().center();
+
+    double memory = residentMemory();
+    benchTimer timer;
+    QGraphicsScene *perNode = new QGraphicsScene;
+    perNode->setItemIndexMethod(QGraphicsScene::NoIndex);
+    const map<idType, nodeData> nodeMap = model.getNodeMap();
+    size_t items = 0;
+    for(auto it = nodeMap.begin(); it != nodeMap.end(); it ++)
+    {
+        for(auto tag = it->second.tagList.begin(); tag != it->second.tagList.end(); tag ++)
+        {
+            if(tag->first == "name")
+            {
+                QGraphicsTextItem *text = new QGraphicsTextItem;
+                text->setPlainText(QString::fromStdString(tag->second));
+                text->setPos(projection(model.getNodeLoaction(it->first)));
+                perNode->addItem(text);
+                items ++;
+                break;
+            }
+        }
+    }
+    report("one text item per name build", timer.elapsed() / 1000, "ms");
+    report("one text item per name items", items, "items");
+    report("one text item per name memory", (residentMemory() - memory) / 1024, "MB");
+
+    memory = residentMemory();
+    timer.restart();
+    SceneBuilder builder(&model);
+    builder.drawPointText();
+    report("label engine build", timer.elapsed() / 1000, "ms");
+    report("label engine memory", (residentMemory() - memory) / 1024, "MB");
+
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP * ZOOM_STEP * ZOOM_STEP)
+    {
+        QRectF source(0, 0, width / scale, height / scale);
+        source.moveCenter(center);
+        builder.cullToViewport(source);
+
+        string name = "scale " + to_string(scale);
+        report(name + " one text item per name", frameTime(perNode, source, image, frames) / 1000, "ms/frame");
+        // the first frame places the labels, the next ones only draw them
+        report(name + " label engine", frameTime(builder.getScene(), source, image, frames) / 1000, "ms/frame");
+        report(name + " placed labels", builder.labelLayer()->placedCount(), "labels");
+    }
+    delete perNode;
+    return 0;
+}
+
+static benchRegister labelRegister("labels", "[frames] one text item per named node against the label engine", labelBench);
+
+struct viewStep
+{
+    QPointF center;     // scene position
+    double scale;       // pixels per scene unit, as MapView
+};
+
+// "lon lat scale" per line, # starts a comment
+static vector<viewStep> readScript(const string &path)
+{
+    vector<viewStep> steps;
+    ifstream file(path);
+    string line;
+    while(getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+        istringstream words(line);
+        double lon, lat, scale;
+        if(words >> lon >> lat >> scale)
+            steps.push_back(viewStep{projection(lon, lat), scale});
+    }
+    return steps;
+}
+
+// without a script: zoom in on the center of the file, pan around, then zoom out
+static vector<viewStep> defaultScript(Model &model)
+{
+    vector<viewStep> steps;
+    QPointF center = model.getBounds().center();
+    for(double scale = MIN_SCALE; scale <= MAX_SCALE; scale *= ZOOM_STEP * ZOOM_STEP)
+        steps.push_back(viewStep{center, scale});
+    const double scale = 0.01;
+    const double step = 640 / scale;
+    QPointF moves[] = {QPointF(step, 0), QPointF(0, step), QPointF(-step, 0), QPointF(-step, 0),
+                       QPointF(0, -step), QPointF(0, -step), QPointF(step, 0), QPointF(step, 0)};
+    QPointF pos = center;
+    for(auto it = begin(moves); it != end(moves); it ++)
+    {
+        pos += *it;
+        steps.push_back(viewStep{pos, scale});
+    }
+    for(double scale = MAX_SCALE; scale >= MIN_SCALE; scale /= ZOOM_STEP * ZOOM_STEP)
+        steps.push_back(viewStep{center, scale});
+    return steps;
+}
+
+// items drawn for a frame: the overlays of the scene in the view, the batches of the static layer
+// in the view, and the ways inside them
+static void countPainted(SceneBuilder &builder, const QRectF &source, size_t &items, size_t &ways)
+{
+    items = 0;
+    ways = 0;
+    auto inView = builder.getScene()->items(source);
+    for(auto it = inView.begin(); it != inView.end(); it ++)
+    {
+        if((*it)->isVisible() && qgraphicsitem_cast<StaticLayer *>(*it) == nullptr)
+            items ++;
+    }
+    vector<WayBatch *> batches = builder.staticLayer()->batchesIn(source);
+    items += batches.size();
+    for(auto it = batches.begin(); it != batches.end(); it ++)
+        ways += (*it)->wayCount();
+}
+
+// a scripted sequence of views rendered offscreen, like the frames of MapView
+static int renderBench(Model &model, const vector<string> &args)
+{
+    vector<viewStep> steps = args.size() > 0 && args[0] != "-" ? readScript(args[0]) : defaultScript(model);
+    int frames = args.size() > 1 ? stoi(args[1]) : 3;
+    const int width = args.size() > 2 ? stoi(args[2]) : 1280;
+    const int height = args.size() > 3 ? stoi(args[3]) : 800;
+    report("views", steps.size(), "views");
+    report("memory after load", residentMemory() / 1024, "MB");
+
+    benchTimer timer;
+    SceneBuilder builder(&model);
+    builder.addAllItem();
+    builder.drawPointText();
+    report("scene build", timer.elapsed() / 1000, "ms");
+    report("memory after scene build", residentMemory() / 1024, "MB");
+
+    QGraphicsScene *scene = builder.getScene();
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    vector<double> all;
+    double painted = 0;
+    for(size_t i = 0; i < steps.size(); i ++)
+    {
+        QRectF source(0, 0, width / steps[i].scale, height / steps[i].scale);
+        source.moveCenter(steps[i].center);
+        builder.cullToViewport(source);
+
+        vector<double> samples;
+        for(int f = 0; f < frames; f ++)
+        {
+            image.fill(QColor(230, 230, 230));
+            QPainter painter(&image);
+            timer.restart();
+            scene->render(&painter, QRectF(image.rect()), source);
+            painter.end();
+            samples.emplace_back(timer.elapsed() / 1000);
+        }
+        all.insert(all.end(), samples.begin(), samples.end());
+
+        size_t items, ways;
+        countPainted(builder, source, items, ways);
+        painted += items;
+        string name = "view " + to_string(i) + " scale " + to_string(steps[i].scale);
+        report(name + " frame p50", percentile(samples, 50), "ms");
+        report(name + " items painted", items, "items");
+        report(name + " ways painted", ways, "ways");
+    }
+    report("frame p50", percentile(all, 50), "ms");
+    report("frame p95", percentile(all, 95), "ms");
+    report("frame p99", percentile(all, 99), "ms");
+    report("items painted per view", steps.empty() ? 0 : painted / steps.size(), "items");
+    report("peak memory", peakMemory() / 1024, "MB");
+    return 0;
+}
+
+static benchRegister renderRegister("render", "[script|-] [frames] [width] [height] scripted views rendered offscreen, \"lon lat scale\" per script line", renderBench);
+
+// import of the file into a chunk store, then the views of the default script drawn from the
+// chunks paged in under a memory limit, against the memory of the loaded model
+static int chunkBench(Model &model, const vector<string> &args)
+{
+    string dir = args.size() > 0 ? args[0] : "mapbench_chunks";
+    size_t limit = (args.size() > 1 ? stoul(args[1]) : 64) << 20;
+    const int width = 1280;
+    const int height = 800;
+    report("memory with the model", residentMemory() / 1024, "MB");
+
+    benchTimer timer;
+    if(!ChunkStore::import(model.getFilePath(), dir))
+    {
+        std::cout << "import failed: " << dir << std::endl;
+        return 1;
+    }
+    report("import", timer.elapsed() / 1000, "ms");
+
+    ChunkStore store(limit);
+    timer.restart();
+    store.open(dir);
+    report("open", timer.elapsed() / 1000, "ms");
+    report("chunks", store.chunkCount(), "chunks");
+
+    SceneBuilder builder(&model);
+    builder.setChunkStore(&store);
+    vector<viewStep> steps = defaultScript(model);
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    vector<double> paging;
+    vector<double> frames;
+    size_t highest = 0;
+    for(auto it = steps.begin(); it != steps.end(); it ++)
+    {
+        QRectF source(0, 0, width / it->scale, height / it->scale);
+        source.moveCenter(it->center);
+        timer.restart();
+        builder.cullToViewport(source);
+        paging.emplace_back(timer.elapsed() / 1000);
+        frames.emplace_back(frameTime(builder.getScene(), source, image, 1) / 1000);
+        highest = max(highest, store.memoryUsed());
+    }
+    report("page in p50", percentile(paging, 50), "ms");
+    report("page in p95", percentile(paging, 95), "ms");
+    report("frame p50", percentile(frames, 50), "ms");
+    report("chunks read", store.readCount(), "chunks");
+    report("chunks in memory", store.loadedCount(), "chunks");
+    report("highest chunk memory", highest / double(1 << 20), "MB");
+    builder.clear();
+    return 0;
+}
+
+static benchRegister chunkRegister("chunks", "[dir] [memory MB] region import, then the views paged in from the chunks", chunkBench);
@@ -0,0 +1,512 @@
+#include "bench.h"
+#include "myalgorithm.h"
+#include "turnalgorithm.h"
+#include "weightoverlay.h"
+#include "distancematrix.h"
+#include "isochrone.h"
+#include <atomic>
+#include <thread>
+#include "projection.h"
+
+// random pairs of graph nodes, the same ones for every routing bench
+static vector<pair<idType, idType>> randomPairs(const GraphMap &graphMap, size_t count, unsigned seed = 42)
+{
+    vector<idType> nodes;
+    nodes.reserve(graphMap.size());
+    for(auto it = graphMap.begin(); it != graphMap.end(); it ++)
+        nodes.push_back(it->first);
+    mt19937 random(seed);
+    uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+    vector<pair<idType, idType>> pairs;
+    for(size_t i = 0; i < count; i ++)
+        pairs.emplace_back(nodes[pick(random)], nodes[pick(random)]);
+    return pairs;
+}
+
+// the mode named by the argument, car when there is none
+static bool benchMode(const vector<string> &args, size_t position, travelMode &mode)
+{
+    mode = CarMode;
+    if(args.size() <= position || modeFromName(args[position], mode))
+        return true;
+    cerr << "unknown mode " << args[position] << ", car bicycle or foot" << endl;
+    return false;
+}
+
+// unpacking a path into node ids projected again by the scene, against the route geometry
+// read from the graph while the path is unpacked
+static int routeBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20 : stoul(args[0]);
+    travelMode mode;
+    if(!benchMode(args, 1, mode))
+        return 1;
+
+    benchTimer timer;
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    report("graph build", timer.elapsed() / 1000, "ms");
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+    double search = 0, nodes = 0, geometry = 0;
+    size_t found = 0, points = 0, mismatch = 0;
+    double length = 0;
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+    {
+        timer.restart();
+        MyAlgorithm algo(builder.getGraph(), graphMap, builder.getWeights(mode), it->first);
+        search += timer.elapsed();
+
+        // what drawing a node list costs: the path, then a location lookup per node
+        timer.restart();
+        Path path = algo.getShortPath(graphMap, it->second);
+        vector<QPointF> projected;
+        projected.reserve(path.size());
+        for(auto node = path.begin(); node != path.end(); node ++)
+            projected.push_back(projection(model.getNodeLoaction(*node)));
+        nodes += timer.elapsed();
+
+        timer.restart();
+        RouteGeometry route = algo.getRoute(graphMap, it->second);
+        geometry += timer.elapsed();
+
+        if(route.empty())
+            continue;
+        found ++;
+        points += route.points.size();
+        length += route.length();
+        if(route.nodes != path || route.points != projected)
+            mismatch ++;
+    }
+    report("routes found", found, "routes");
+    report("route points", found == 0 ? 0 : double(points) / found, "points/route");
+    report("route length", found == 0 ? 0 : length / found / 1000, "km/route");
+    report("dijkstra", search / count / 1000, "ms/route");
+    report("node path and projection", nodes / count, "us/route");
+    report("route geometry", geometry / count, "us/route");
+    report("geometries different from the node path", mismatch, "routes");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister routeRegister("route", "[routes] [car|bicycle|foot] route as node ids projected again against the precomputed geometry", routeBench);
+
+// the same searches with the d-ary heap of boost and with the radix heap on the integer costs
+static int dijkstraBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20 : stoul(args[0]);
+    travelMode mode;
+    if(!benchMode(args, 1, mode))
+        return 1;
+
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    report("graph vertices", num_vertices(builder.getGraph()), "vertices");
+    report("graph edges", num_edges(builder.getGraph()), "edges");
+
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+    vector<double> dary, radix;
+    size_t mismatch = 0;
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+    {
+        // the graph is copied once, then both searches run on the same copy
+        MyAlgorithm algo(builder.getGraph(), graphMap, builder.getWeights(mode), it->first, DaryQueue);
+
+        benchTimer timer;
+        algo.run(DaryQueue);
+        dary.push_back(timer.elapsed() / 1000);
+        vector<costType> reference = algo.getDistances();
+
+        timer.restart();
+        algo.run(RadixQueue);
+        radix.push_back(timer.elapsed() / 1000);
+        if(algo.getDistances() != reference)
+            mismatch ++;
+    }
+    report("d-ary heap p50", percentile(dary, 50), "ms/search");
+    report("d-ary heap p95", percentile(dary, 95), "ms/search");
+    report("radix heap p50", percentile(radix, 50), "ms/search");
+    report("radix heap p95", percentile(radix, 95), "ms/search");
+    report("searches with different costs", mismatch, "searches");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister dijkstraRegister("dijkstra", "[searches] [car|bicycle|foot] one to all searches, boost d-ary heap against the radix heap", dijkstraBench);
+
+// size of the shared graph and what each profile can take of it
+static int profileBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20 : stoul(args[0]);
+
+    benchTimer timer;
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    report("graph build", timer.elapsed() / 1000, "ms");
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    size_t edges = num_edges(builder.getGraph());
+    report("graph vertices", num_vertices(builder.getGraph()), "vertices");
+    report("graph edges", edges, "edges");
+
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+    for(int m = 0; m < MODE_COUNT; m++)
+    {
+        travelMode mode = static_cast<travelMode>(m);
+        string name = modeName(mode);
+        const vector<costType> &weights = builder.getWeights(mode);
+        size_t open = 0;
+        for(auto it = weights.begin(); it != weights.end(); it ++)
+            open += *it != COST_INFINITE;
+        report(name + " open edges", edges == 0 ? 0 : 100.0 * open / edges, "%");
+
+        // route between nodes snapped to the roads of the mode, like ShortPath does
+        size_t found = 0;
+        double seconds = 0, meters = 0;
+        for(auto it = pairs.begin(); it != pairs.end(); it ++)
+        {
+            idType source = model.snapToRoad(projection(model.getNodeLoaction(it->first)), mode);
+            idType destination = model.snapToRoad(projection(model.getNodeLoaction(it->second)), mode);
+            MyAlgorithm algo(builder.getGraph(), graphMap, weights, source);
+            RouteGeometry route = algo.getRoute(graphMap, destination);
+            if(route.empty())
+                continue;
+            found ++;
+            seconds += algo.getDistances()[graphMap.at(destination)] / 1000.0;
+            meters += route.length();
+        }
+        report(name + " routes found", found, "routes");
+        report(name + " average speed", seconds == 0 ? 0 : meters / seconds * 3.6, "km/h");
+    }
+    return 0;
+}
+
+static benchRegister profileRegister("profiles", "[routes] open edges, routes found and average speed of each profile", profileBench);
+
+// the search over the edges with the turn restrictions and costs, against the one over the vertices
+static int turnBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20 : stoul(args[0]);
+    travelMode mode;
+    if(!benchMode(args, 1, mode))
+        return 1;
+
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    const vector<costType> &weights = builder.getWeights(mode);
+
+    double before = residentMemory();
+    benchTimer timer;
+    TurnGraph turns;
+    turns.build(builder.getGraph(), graphMap, model);
+    report("turn graph build", timer.elapsed() / 1000, "ms");
+    report("turn graph memory", turns.memoryUsed() / 1024.0, "kB");
+    report("turn graph resident memory", residentMemory() - before, "kB");
+    // one target and one weight per turn at least, if the turns were stored
+    report("expanded graph estimate", turns.getTurnCount() * 2 * sizeof(unsigned int) / 1024.0, "kB");
+    report("forbidden turns", turns.getRestrictionCount(mode), "turns");
+    report("unsupported restrictions", turns.getUnsupportedCount(), "relations");
+
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+    vector<double> nodeAll, turnAll, turnOne;
+    size_t found = 0, changed = 0;
+    double nodeCost = 0, turnCost = 0;
+    TurnAlgorithm search(turns, weights, mode);
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+    {
+        idType source = model.snapToRoad(projection(model.getNodeLoaction(it->first)), mode);
+        idType destination = model.snapToRoad(projection(model.getNodeLoaction(it->second)), mode);
+        MyAlgorithm algo(builder.getGraph(), graphMap, weights, source);
+        if(!algo.getFlag())
+            continue;
+
+        timer.restart();
+        algo.run(RadixQueue);
+        nodeAll.push_back(timer.elapsed() / 1000);
+
+        timer.restart();
+        search.run(graphMap, source, 0);
+        turnAll.push_back(timer.elapsed() / 1000);
+
+        timer.restart();
+        costType cost = search.run(graphMap, source, destination);
+        turnOne.push_back(timer.elapsed() / 1000);
+
+        RouteGeometry nodeRoute = algo.getRoute(graphMap, destination);
+        if(nodeRoute.empty() || cost == COST_INFINITE)
+            continue;
+        found ++;
+        nodeCost += algo.getDistances()[graphMap.at(destination)];
+        turnCost += cost;
+        if(search.getRoute().nodes != nodeRoute.nodes)
+            changed ++;
+    }
+    report("node search to all p50", percentile(nodeAll, 50), "ms/search");
+    report("edge search to all p50", percentile(turnAll, 50), "ms/search");
+    report("edge search to one p50", percentile(turnOne, 50), "ms/search");
+    report("edge search to one p95", percentile(turnOne, 95), "ms/search");
+    report("routes found by both", found, "routes");
+    report("routes changed by the turns", changed, "routes");
+    report("travel time added by the turns", nodeCost == 0 ? 0 : 100 * (turnCost / nodeCost - 1), "%");
+    return 0;
+}
+
+static benchRegister turnRegister("turns", "[searches] [car|bicycle|foot] edge search with turn restrictions and costs against the node search", turnBench);
+
+// random updates of the ways of the overlay, one in twenty closes the way
+static vector<WeightUpdate> randomUpdates(const MyGraphBuilder &builder, size_t count, unsigned seed)
+{
+    vector<idType> ways;
+    const graph_t &graph = builder.getGraph();
+    graph_traits<graph_t>::edge_iterator e, end;
+    for(tie(e, end) = edges(graph); e != end; ++e)
+        ways.push_back(graph[*e].way);
+    sort(ways.begin(), ways.end());
+    ways.erase(unique(ways.begin(), ways.end()), ways.end());
+    mt19937 random(seed);
+    uniform_int_distribution<size_t> pick(0, ways.size() - 1);
+    uniform_real_distribution<double> factor(0.5, 3);
+    vector<WeightUpdate> updates;
+    for(size_t i = 0; i < count; i ++)
+        updates.push_back(WeightUpdate{ways[pick(random)], factor(random), random() % 20 == 0});
+    return updates;
+}
+
+// time to apply a batch of updates, and the latency of the queries with and without a writer
+static int overlayBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 10000 : stoul(args[0]);
+    size_t queries = args.size() > 1 ? stoul(args[1]) : 50;
+    travelMode mode = CarMode;
+
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    TurnGraph turns;
+    turns.build(builder.getGraph(), graphMap, model);
+
+    benchTimer timer;
+    WeightOverlay overlay;
+    overlay.build(builder);
+    report("overlay build", timer.elapsed() / 1000, "ms");
+    report("overlay ways", overlay.getWayCount(), "ways");
+
+    // a graph built again is what an update cost before the overlay
+    timer.restart();
+    MyGraphBuilder rebuilt(model);
+    rebuilt.generateGraph();
+    report("graph rebuild", timer.elapsed() / 1000, "ms");
+
+    vector<double> applyTimes;
+    for(unsigned i = 0; i < 5; i ++)
+    {
+        vector<WeightUpdate> updates = randomUpdates(builder, count, i);
+        timer.restart();
+        overlay.apply(updates);
+        applyTimes.push_back(timer.elapsed() / 1000);
+    }
+    report("apply " + to_string(count) + " updates p50", percentile(applyTimes, 50), "ms");
+
+    // the queries between snapped nodes, each on the snapshot it took
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, queries);
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+    {
+        it->first = model.snapToRoad(projection(model.getNodeLoaction(it->first)), mode);
+        it->second = model.snapToRoad(projection(model.getNodeLoaction(it->second)), mode);
+    }
+    auto latency = [&](size_t &versions)
+    {
+        vector<double> samples;
+        unsigned long long last = ~0ull;
+        versions = 0;
+        for(auto it = pairs.begin(); it != pairs.end(); it ++)
+        {
+            benchTimer query;
+            std::shared_ptr<const WeightSet> weights = overlay.snapshot();
+            TurnAlgorithm search(turns, weights->weights[mode], mode);
+            search.run(graphMap, it->first, it->second);
+            samples.push_back(query.elapsed() / 1000);
+            if(weights->version != last)
+                versions ++;
+            last = weights->version;
+        }
+        return samples;
+    };
+
+    size_t versions = 0;
+    vector<double> idle = latency(versions);
+    report("query alone p50", percentile(idle, 50), "ms");
+    report("query alone p95", percentile(idle, 95), "ms");
+
+    // a writer applying batches for as long as the queries run
+    atomic<bool> stop(false);
+    size_t batches = 0;
+    thread writer([&]()
+    {
+        unsigned seed = 100;
+        while(!stop)
+        {
+            overlay.apply(randomUpdates(builder, count, seed ++));
+            batches ++;
+        }
+    });
+    vector<double> busy = latency(versions);
+    stop = true;
+    writer.join();
+    report("query with updates p50", percentile(busy, 50), "ms");
+    report("query with updates p95", percentile(busy, 95), "ms");
+    report("batches applied meanwhile", batches, "batches");
+    report("versions seen by the queries", versions, "versions");
+    return 0;
+}
+
+static benchRegister overlayRegister("overlay", "[updates] [queries] weight updates applied in place, and the query latency meanwhile", overlayBench);
+
+// a points x points table with one search per source on 1 to every thread, against a MyAlgorithm
+// run per cell (measured on a sample of the cells, the whole table would take hours)
+static int matrixBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 200 : stoul(args[0]);
+    size_t samples = args.size() > 1 ? stoul(args[1]) : 20;
+    travelMode mode;
+    if(!benchMode(args, 2, mode))
+        return 1;
+
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    const vector<costType> &weights = builder.getWeights(mode);
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+    vector<idType> points;
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+        points.push_back(it->first);
+    double cells = double(count) * count;
+
+    DistanceMatrix matrix;
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for(unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? min(threads * 2, maxThreads) : threads + 1)
+    {
+        benchTimer timer;
+        matrix.compute(builder, weights, points, points, threads);
+        double elapsed = timer.elapsed();
+        report("matrix, " + to_string(threads) + " threads", elapsed / 1000, "ms");
+        report("matrix, " + to_string(threads) + " threads", cells / elapsed * 1e6, "cells/s");
+    }
+    report("settled by the matrix", double(matrix.getSettledCount()) / count, "vertices/source");
+    size_t unreachable = count_if(matrix.getTimes().begin(), matrix.getTimes().end(),
+                                  [](costType time) { return time == COST_INFINITE; });
+    report("unreachable cells", unreachable, "cells");
+
+    // a cell at a time like a caller without the matrix, each run checked against its cell
+    mt19937 random(7);
+    uniform_int_distribution<size_t> pick(0, count - 1);
+    double search = 0;
+    size_t mismatch = 0;
+    for(size_t i = 0; i < samples; i ++)
+    {
+        size_t row = pick(random), column = pick(random);
+        benchTimer timer;
+        MyAlgorithm algo(builder.getGraph(), graphMap, weights, points[row]);
+        Path path = algo.getShortPath(graphMap, points[column]);
+        search += timer.elapsed();
+        if(algo.getDistances()[graphMap.at(points[column])] != matrix.getTime(row, column))
+            mismatch ++;
+    }
+    double perCell = samples == 0 ? 0 : search / samples;
+    report("MyAlgorithm per cell", perCell / 1000, "ms/cell");
+    report("MyAlgorithm per cell", perCell == 0 ? 0 : 1e6 / perCell, "cells/s");
+    report("MyAlgorithm for the whole table", perCell * cells / 1e6, "s");
+    report("cells different from MyAlgorithm", mismatch, "cells");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister matrixRegister("matrix", "[points] [samples] [car|bicycle|foot] many to many table on 1 to every thread, against a search per cell", matrixBench);
+
+// searches bounded by increasing budgets against the search to the end of MyAlgorithm, the budgets
+// in one search against one search each, and the outline of each budget
+static int isochroneBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20 : stoul(args[0]);
+    travelMode mode;
+    if(!benchMode(args, 1, mode))
+        return 1;
+    const vector<double> minutes = {1, 2, 5, 10, 15, 30, 60};
+    const double cell = 50;
+
+    MyGraphBuilder builder(model);
+    builder.generateGraph();
+    const GraphMap &graphMap = builder.getGraphMap();
+    if(graphMap.empty())
+        return 1;
+    const vector<costType> &weights = builder.getWeights(mode);
+    vector<costType> budgets;
+    for(auto it = minutes.begin(); it != minutes.end(); it ++)
+        budgets.push_back(static_cast<costType>(*it * 60000));
+    vector<pair<idType, idType>> pairs = randomPairs(graphMap, count);
+
+    vector<double> full, together, separate;
+    vector<vector<double>> bounded(budgets.size()), outlines(budgets.size());
+    vector<double> settled(budgets.size(), 0), rings(budgets.size(), 0);
+    size_t mismatch = 0;
+    Isochrone isochrone;
+    for(auto it = pairs.begin(); it != pairs.end(); it ++)
+    {
+        MyAlgorithm algo(builder.getGraph(), graphMap, weights, it->first);
+        benchTimer timer;
+        algo.run(RadixQueue);
+        full.push_back(timer.elapsed() / 1000);
+
+        double sum = 0;
+        for(size_t b = 0; b < budgets.size(); b ++)
+        {
+            timer.restart();
+            isochrone.compute(builder.getGraph(), graphMap, weights, it->first, vector<costType>(1, budgets[b]));
+            bounded[b].push_back(timer.elapsed() / 1000);
+            sum += bounded[b].back();
+            settled[b] += isochrone.getSettledCount();
+            // the vertices within the budget are the ones the full search reached as cheaply
+            const vector<costType> &distances = algo.getDistances();
+            if(size_t(count_if(distances.begin(), distances.end(), [&](costType d) { return d <= budgets[b]; })) != isochrone.getReachedCount(0))
+                mismatch ++;
+        }
+        separate.push_back(sum);
+
+        timer.restart();
+        isochrone.compute(builder.getGraph(), graphMap, weights, it->first, budgets);
+        together.push_back(timer.elapsed() / 1000);
+        for(size_t b = 0; b < budgets.size(); b ++)
+        {
+            timer.restart();
+            rings[b] += isochrone.outline(b, cell).size();
+            outlines[b].push_back(timer.elapsed() / 1000);
+        }
+    }
+    report("graph vertices", num_vertices(builder.getGraph()), "vertices");
+    report("search to the end p50", percentile(full, 50), "ms");
+    for(size_t b = 0; b < budgets.size(); b ++)
+    {
+        string name = to_string(int(minutes[b])) + " min";
+        report(name + " search p50", percentile(bounded[b], 50), "ms");
+        report(name + " settled", settled[b] / count, "vertices");
+        report(name + " outline p50", percentile(outlines[b], 50), "ms");
+        report(name + " outline rings", rings[b] / count, "rings");
+    }
+    report("every budget in one search p50", percentile(together, 50), "ms");
+    report("one search per budget p50", percentile(separate, 50), "ms");
+    report("budgets different from the full search", mismatch, "budgets");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister isochroneRegister("isochrone", "[sources] [car|bicycle|foot] reachable vertices and outlines for budgets of 1 to 60 min", isochroneBench);
@@ -0,0 +1,347 @@
+#include "bench.h"
+#include "fuzzyindex.h"
+#include "textnormalize.h"
+#include <set>
+#include <thread>
+#include <limits>
+
+// substrings of the catalog names, what a user would type in the search dialog
+static vector<string> sampleQueries(const vector<catagoryData> &catalog, size_t count, unsigned seed = 42)
+{
+    vector<string> queries;
+    mt19937 gen(seed);
+    if(catalog.empty())
+        return queries;
+    uniform_int_distribution<size_t> pick(0, catalog.size() - 1);
+    uniform_int_distribution<size_t> length(3, 8);
+    while(queries.size() < count)
+    {
+        const catagoryData &data = catalog[pick(gen)];
+        const string &text = data.name.empty() ? data.type : data.name[gen() % data.name.size()];
+        if(text.size() < 3)
+            continue;
+        size_t len = min(length(gen), text.size());
+        size_t start = gen() % (text.size() - len + 1);
+        queries.emplace_back(text.substr(start, len));
+    }
+    return queries;
+}
+
+static vector<idType> linearSearchByName(const vector<catagoryData> &catalog, const string &name)
+{
+    vector<idType> result;
+    for(auto it = catalog.begin(); it != catalog.end(); it ++)
+    {
+        for(auto it2 = it->name.begin(); it2 != it->name.end(); it2 ++)
+        {
+            if(it2->find(name) != string::npos)
+            {
+                result.emplace_back(it->id);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static vector<idType> ids(const vector<catagoryData> &result)
+{
+    vector<idType> out;
+    for(auto it = result.begin(); it != result.end(); it ++)
+        out.emplace_back(it->id);
+    return out;
+}
+
+// queries per second of the name search, trigram index against the linear scan
+static int searchBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 2000 : stoul(args[0]);
+
+    benchTimer timer;
+    model.buildAmenityCatalog();
+    report("catalog build", timer.elapsed() / 1000, "ms");
+
+    const vector<catagoryData> &catalog = model.getAmenityCatalog();
+    report("catalog size", catalog.size(), "entries");
+    vector<string> queries = sampleQueries(catalog, count);
+
+    size_t mismatch = 0;
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+    {
+        if(ids(model.searchAmenityByName(*it)) != linearSearchByName(catalog, *it))
+            mismatch ++;
+    }
+    report("results different from the linear scan", mismatch, "queries");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        model.searchAmenityByName(*it);
+    double indexed = timer.elapsed();
+    report("trigram name search", queries.size() / indexed * 1e6, "queries/s");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        linearSearchByName(catalog, *it);
+    double linear = timer.elapsed();
+    report("linear name search", queries.size() / linear * 1e6, "queries/s");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        model.searchAmenityByType(*it);
+    report("type search", queries.size() / timer.elapsed() * 1e6, "queries/s");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister searchRegister("search", "[queries] amenity name search, trigram index against linear scan", searchBench);
+
+// the type lookups before the hash buckets: substring over the distinct types, then a full scan
+// an exact type only matches itself, as in the model
+static bool linearTypeExist(const set<string> &types, const string &name)
+{
+    for(auto it = types.begin(); it != types.end(); it ++)
+    {
+        if(it->find(name) != string::npos)
+            return true;
+    }
+    return false;
+}
+
+static vector<idType> linearSearchByType(const vector<catagoryData> &catalog, const set<string> &types, const string &name)
+{
+    vector<idType> result;
+    bool exact = types.count(name) > 0;
+    for(auto it = catalog.begin(); it != catalog.end(); it ++)
+    {
+        if(exact ? it->type == name : it->type.find(name) != string::npos)
+            result.emplace_back(it->id);
+    }
+    return result;
+}
+
+// type checks and type searches, hash buckets against the linear scans
+static int typeBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 20000 : stoul(args[0]);
+
+    benchTimer timer;
+    model.buildAmenityCatalog();
+    report("catalog build", timer.elapsed() / 1000, "ms");
+
+    const vector<catagoryData> &catalog = model.getAmenityCatalog();
+    set<string> types;
+    for(auto it = catalog.begin(); it != catalog.end(); it ++)
+        types.insert(it->type);
+    report("distinct types", types.size(), "types");
+    if(catalog.empty())
+        return 0;
+
+    // mostly exact types as typed in the dialog, some partial ones and some misses
+    vector<string> queries;
+    mt19937 gen(42);
+    uniform_int_distribution<size_t> pick(0, catalog.size() - 1);
+    while(queries.size() < count)
+    {
+        const string &type = catalog[pick(gen)].type;
+        switch(gen() % 4)
+        {
+        case 0:
+            queries.emplace_back(type.substr(0, max<size_t>(3, type.size() / 2)));
+            break;
+        case 1:
+            queries.emplace_back(type + "x");
+            break;
+        default:
+            queries.emplace_back(type);
+        }
+    }
+
+    size_t mismatch = 0;
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+    {
+        if(model.isAmenityTypeExist(*it) != linearTypeExist(types, *it)
+                || ids(model.searchAmenityByType(*it)) != linearSearchByType(catalog, types, *it))
+            mismatch ++;
+    }
+    report("results different from the linear scan", mismatch, "queries");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        model.isAmenityTypeExist(*it);
+    report("hashed type check", queries.size() / timer.elapsed() * 1e6, "queries/s");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        linearTypeExist(types, *it);
+    report("linear type check", queries.size() / timer.elapsed() * 1e6, "queries/s");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        model.searchAmenityByType(*it);
+    report("bucket type search", queries.size() / timer.elapsed() * 1e6, "queries/s");
+
+    timer.restart();
+    for(auto it = queries.begin(); it != queries.end(); it ++)
+        linearSearchByType(catalog, types, *it);
+    report("linear type search", queries.size() / timer.elapsed() * 1e6, "queries/s");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister typeRegister("types", "[queries] amenity type check and search, hash buckets against linear scan", typeBench);
+
+// latency of every keystroke while typing names of the catalog, by importance and by distance
+static int autocompleteBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 500 : stoul(args[0]);
+    model.buildAmenityCatalog();
+
+    const vector<catagoryData> &catalog = model.getAmenityCatalog();
+    mt19937 gen(42);
+    vector<string> typed;
+    while(typed.size() < count && !catalog.empty())
+    {
+        const catagoryData &data = catalog[gen() % catalog.size()];
+        if(!data.name.empty())
+            typed.emplace_back(data.name[0].substr(0, 12));
+    }
+
+    QPointF center = model.getBounds().center();
+    vector<double> byImportance, byDistance;
+    for(auto it = typed.begin(); it != typed.end(); it ++)
+    {
+        for(size_t len = 1; len <= it->size(); len ++)
+        {
+            string prefix = it->substr(0, len);
+            benchTimer timer;
+            model.autocomplete(prefix, 10);
+            byImportance.emplace_back(timer.elapsed());
+            timer.restart();
+            model.autocompleteNear(prefix, 10, center);
+            byDistance.emplace_back(timer.elapsed());
+        }
+    }
+    report("keystrokes", byImportance.size(), "");
+    report("autocomplete p50", percentile(byImportance, 50), "us");
+    report("autocomplete p95", percentile(byImportance, 95), "us");
+    report("autocomplete p99", percentile(byImportance, 99), "us");
+    report("autocomplete near p50", percentile(byDistance, 50), "us");
+    report("autocomplete near p95", percentile(byDistance, 95), "us");
+    report("autocomplete near p99", percentile(byDistance, 99), "us");
+    return 0;
+}
+
+static benchRegister autocompleteRegister("autocomplete", "[names] per keystroke latency of the top 10 suggestions", autocompleteBench);
+
+// one random edit: substitution, deletion, insertion or transposition
+static string addTypo(string text, mt19937 &gen)
+{
+    if(text.size() < 2)
+        return text;
+    size_t pos = gen() % (text.size() - 1);
+    char letter = 'a' + gen() % 26;
+    switch(gen() % 4)
+    {
+    case 0: text[pos] = letter; break;
+    case 1: text.erase(pos, 1); break;
+    case 2: text.insert(pos, 1, letter); break;
+    default: swap(text[pos], text[pos + 1]);
+    }
+    return text;
+}
+
+// latency, recall and memory of the typo tolerant search on misspelled names of the catalog
+static int fuzzyBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 2000 : stoul(args[0]);
+    model.buildAmenityCatalog();
+    const vector<catagoryData> &catalog = model.getAmenityCatalog();
+
+    // the same index as the catalog, built here to measure it alone
+    benchTimer timer;
+    FuzzyIndex index;
+    for(uint32_t i = 0; i < catalog.size(); i ++)
+    {
+        for(auto it = catalog[i].name.begin(); it != catalog[i].name.end(); it ++)
+            index.add(i, *it);
+        index.add(i, catalog[i].type);
+    }
+    report("fuzzy index build", timer.elapsed() / 1000, "ms");
+    report("fuzzy index words", index.wordCount(), "");
+    report("fuzzy index memory", index.memoryUsage() / 1024.0 / 1024.0, "MB");
+
+    mt19937 gen(42);
+    vector<double> latency;
+    size_t found = 0, tried = 0;
+    while(tried < count && !catalog.empty())
+    {
+        uint32_t doc = gen() % catalog.size();
+        if(catalog[doc].name.empty())
+            continue;
+        string query = normalizeText(catalog[doc].name[0]);
+        if(query.size() < 5)
+            continue;
+        query = addTypo(query, gen);
+        if(gen() % 2)
+            query = addTypo(query, gen);
+        tried ++;
+
+        timer.restart();
+        vector<FuzzyIndex::Match> matches = index.search(query);
+        latency.emplace_back(timer.elapsed());
+        for(auto it = matches.begin(); it != matches.end(); it ++)
+        {
+            if(it->doc == doc)
+            {
+                found ++;
+                break;
+            }
+        }
+    }
+    report("fuzzy queries", tried, "");
+    report("fuzzy recall", tried ? double(found) / tried : 0, "ratio");
+    report("fuzzy search p50", percentile(latency, 50), "us");
+    report("fuzzy search p95", percentile(latency, 95), "us");
+    report("fuzzy search p99", percentile(latency, 99), "us");
+    return 0;
+}
+
+static benchRegister fuzzyRegister("fuzzy", "[queries] typo tolerant search, latency recall and memory", fuzzyBench);
+
+// catalog build time against the number of threads, every catalog must equal the one thread one
+static int catalogBench(Model &model, const vector<string> &args)
+{
+    unsigned maxThreads = args.empty() ? max(1u, thread::hardware_concurrency()) : stoul(args[0]);
+    int repeat = 3;
+
+    vector<pair<idType, uint32_t>> reference;
+    size_t mismatch = 0;
+    double single = 0;
+    for(unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? min(threads * 2, maxThreads) : threads + 1)
+    {
+        // best of a few runs, the first one also warms the allocator
+        double best = numeric_limits<double>::max();
+        for(int i = 0; i < repeat; i ++)
+        {
+            benchTimer timer;
+            model.buildAmenityCatalog(threads);
+            best = min(best, timer.elapsed());
+        }
+        if(threads == 1)
+            single = best;
+
+        vector<pair<idType, uint32_t>> catalog;
+        const vector<catagoryData> &data = model.getAmenityCatalog();
+        for(auto it = data.begin(); it != data.end(); it ++)
+            catalog.emplace_back(it->id, it->typeId);
+        if(threads == 1)
+            reference.swap(catalog);
+        else if(catalog != reference)
+            mismatch ++;
+
+        report("catalog build, " + to_string(threads) + " threads", best / 1000, "ms");
+        report("speedup, " + to_string(threads) + " threads", single / best, "x");
+    }
+    report("catalogs different from one thread", mismatch, "builds");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister catalogRegister("catalog", "[max threads] amenity catalog build time against the thread count", catalogBench);
@@ -0,0 +1,104 @@
+#include "bench.h"
+#include "SceneBuilder.h"
+
+// latency of the R-tree of the model against the BSP index of QGraphicsScene
+static int rtreeBench(Model &model, const vector<string> &args)
+{
+    size_t count = args.empty() ? 10000 : stoul(args[0]);
+
+    SceneBuilder builder(&model);
+    builder.addAllItem();
+    QGraphicsScene *scene = builder.getScene();
+    // the scene builder culls with the R-tree, compare with the default index of Qt
+    scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+
+    QRectF bounds = model.getBounds();
+    vector<QRectF> rects = randomRects(bounds, count, 200, 5000);
+    vector<QPointF> points = randomPoints(bounds, count);
+
+    // the first query builds the BSP tree, keep it out of the measure
+    scene->items(rects[0], Qt::IntersectsItemBoundingRect);
+
+    size_t hits = 0;
+    benchTimer timer;
+    for(auto it = rects.begin(); it != rects.end(); it ++)
+        hits += model.searchWayInRect(*it).size();
+    report("rtree box query", timer.elapsed() / count, "us/query");
+    report("rtree box hits", double(hits) / count, "items/query");
+
+    hits = 0;
+    timer.restart();
+    for(auto it = rects.begin(); it != rects.end(); it ++)
+        hits += scene->items(*it, Qt::IntersectsItemBoundingRect).size();
+    report("scene box query", timer.elapsed() / count, "us/query");
+    report("scene box hits", double(hits) / count, "items/query");
+
+    hits = 0;
+    timer.restart();
+    for(auto it = points.begin(); it != points.end(); it ++)
+        hits += model.searchPolygonAt(*it) != 0;
+    report("rtree point in polygon", timer.elapsed() / count, "us/query");
+    report("rtree point hits", double(hits) / count, "ratio");
+
+    hits = 0;
+    timer.restart();
+    for(auto it = points.begin(); it != points.end(); it ++)
+        hits += scene->itemAt(*it, QTransform()) != nullptr;
+    report("scene itemAt", timer.elapsed() / count, "us/query");
+    report("scene itemAt hits", double(hits) / count, "ratio");
+
+    timer.restart();
+    for(auto it = points.begin(); it != points.end(); it ++)
+        model.searchNearestWay(*it, 5);
+    report("rtree 5 nearest ways", timer.elapsed() / count, "us/query");
+    return 0;
+}
+
+static benchRegister rtreeRegister("rtree", "[queries] box, point and nearest queries against QGraphicsScene", rtreeBench);
+
+// multipolygon relations assembled into areas, build time against the thread count
+static int areaBench(Model &model, const vector<string> &args)
+{
+    unsigned maxThreads = args.empty() ? max(1u, thread::hardware_concurrency()) : stoul(args[0]);
+    int repeat = 3;
+
+    vector<pair<idType, size_t>> reference;
+    size_t mismatch = 0;
+    double single = 0;
+    for(unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? min(threads * 2, maxThreads) : threads + 1)
+    {
+        double best = numeric_limits<double>::max();
+        vector<MultipolygonArea> areas;
+        for(int i = 0; i < repeat; i ++)
+        {
+            benchTimer timer;
+            areas = model.assembleAreas(threads);
+            best = min(best, timer.elapsed());
+        }
+        if(threads == 1)
+            single = best;
+
+        vector<pair<idType, size_t>> result;
+        size_t points = 0;
+        for(auto it = areas.begin(); it != areas.end(); it ++)
+        {
+            result.emplace_back(it->id, it->points.size());
+            points += it->points.size();
+        }
+        if(threads == 1)
+        {
+            reference.swap(result);
+            report("areas", areas.size(), "areas");
+            report("area points", points, "points");
+        }
+        else if(result != reference)
+            mismatch ++;
+
+        report("area assembly, " + to_string(threads) + " threads", best / 1000, "ms");
+        report("speedup, " + to_string(threads) + " threads", single / best, "x");
+    }
+    report("assemblies different from one thread", mismatch, "builds");
+    return mismatch == 0 ? 0 : 1;
+}
+
+static benchRegister areaRegister("areas", "[max threads] multipolygon relation assembly time against the thread count", areaBench);
@@ -14,15 +14,29 @@
 #include <vector>
 #include "RenderEnum.h"
 #include "renderitem.h"
+#include "chunkstore.h"
+#include "routegeometry.h"
 #include <QLine>
 #include "projection.h"
 #include <QGraphicsItem>
 #include <QString>
 #include <QObject>
 #include <QFont>
+#include <unordered_map>
+#include <unordered_set>
+#include <tuple>
 
 using namespace std;
 
+// at most this number of places are pinned by a search
+#define SEARCH_RESULTS 50
+
+// side of the square cells the ways of a style are batched by, in scene units
+#define BATCH_CELL 5000.0
+
+// width of the map paged in on each side of a route, in scene units
+#define ROUTE_CORRIDOR 500.0
+
 class SceneBuilder : public QObject
 {
     Q_OBJECT
@@ -30,18 +44,38 @@ class SceneBuilder : public QObject
     QGraphicsScene *m_scene;
     //    QGraphicsView *veiw;
     Model *m_model;
-    vector<Multipolygon *> m_polygonList;
-    vector<Road *> m_RoadList;
-    vector<QGraphicsTextItem *> m_textContainer;
+    map<tuple<bool, int, int, int>, WayBatch *> m_batches;   // (area, style, cell x, cell y) -> batch
+    StaticLayer *m_staticLayer;  // owned by the scene, holds every batch
+    LabelEngine m_labels;
+    LabelLayer *m_labelLayer;  // owned by the scene, created with the first label
     vector<QGraphicsEllipseItem *> m_Point;
     Road *m_route;
+    vector<QGraphicsPathItem *> m_isochrones;  // one per budget, under the route
     Pin *m_source;
     Pin *m_dest;
     vector<Pin *> m_pinContainer; // a container for pin object, release them when cancel is triggered
+    unordered_map<idType, WayBatch *> m_wayItems;  // way id -> batch drawing it
+    QRectF m_viewRect;      // visible area, the searches look there first
+    bool m_showBatches;     // false when the map is drawn from raster tiles
+    ChunkStore *m_chunks;   // the base map comes from it instead of the model when set
+    // chunk id -> its layers, one per z-value of its batches, so the ways of every chunk in
+    // memory are stacked together (a landuse read later stays under the roads shown before)
+    unordered_map<int, vector<StaticLayer *>> m_chunkLayers;
+
+    // add the way to the batch of its style and cell
+    void buildWay(const wayData &way, idType wayId);
+
+    // same for the area of a multipolygon relation
+    void buildArea(idType relationId, polygonType type);
+
+    WayBatch *getBatch(bool isPolygon, int type, QPointF center);
 
-    void buildMutipolygon(wayData way, idType wayId);
+    void addPolyItem();
+
+    void addRoadItem();
 
-    void buildRoad(wayData way, idType wayId);
+    // the static layers with the batches of the ways of a chunk in memory
+    void addChunkLayer(int id);
 
     void getBoundingRectCenter();
 
@@ -52,6 +86,9 @@ class SceneBuilder : public QObject
 
     void drawPin(idType, QPointF);
 
+    // the route item on top of the map, and the chunks along it
+    void showRoute(const QPolygonF &line);
+
 public:
     SceneBuilder(Model *model);
 
@@ -59,25 +96,59 @@ public:
 
     void clear();
 
+    // the base map, loaded once into the static layer, the scene rect is set to it here
+    // and is not changed by the overlays added later
     void addAllItem();
 
-    void addPolyItem();
-
     QGraphicsScene *getScene();
 
-    void addRoadItem();
+    StaticLayer *staticLayer();
 
+    // looks up and projects every node, drawRoute(RouteGeometry) draws the points as they are
     void drawRoute(std::vector<idType> refList);
+
+    void drawRoute(const RouteGeometry &route);
+
+    // the outlines of the budgets of an isochrone, from the smallest budget, each filled with the
+    // odd-even rule so its holes stay empty; replaces the ones drawn before
+    void drawIsochrones(const vector<vector<QPolygonF>> &outlines);
+
+    // labels of the named nodes, the label engine decides which ones are shown
     void drawPointText();
 
+    // the item drawing every label, made on first use
+    LabelLayer *labelLayer();
+
+    // picking through the spatial index of the model instead of QGraphicsScene::itemAt
+    // returns 0 outside of any polygon
+    idType polygonAt(QPointF pos);
+
+    polygonType polygonTypeOf(idType wayId);
+
+    size_t batchCount() const;
+
+    // hide the base map, when the view draws the tiles of a TileCache instead
+    void setBatchesVisible(bool visible);
+
+    // draw the chunks of the store under the view instead of the ways of the model, the scene
+    // rect is the box of the store, nullptr goes back to the model
+    void setChunkStore(ChunkStore *store);
+
+    size_t chunkLayerCount() const;
+
 public slots:
-    void setSource(Multipolygon *item);
-    void setDest(Multipolygon *item);
+    void setSource(idType wayId);
+    void setDest(idType wayId);
 
     bool searchPlace(QString name);
     void cancel();
     void getSrcDestId();
     void slotDrawRoute(vector<idType> route);
+    // the static layer only paints what is exposed, the view is kept for the labels and the searches
+    void cullToViewport(QRectF rect);
+
+    // remove the layer of a chunk, before the store frees its points
+    void removeChunk(int id);
 
 signals:
     void routeSrcAndDest(idType src, idType dest);
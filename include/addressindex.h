@@ -0,0 +1,86 @@
+#ifndef ADDRESSINDEX_H
+#define ADDRESSINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <QPointF>
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// forward geocoding of postal addresses (addr:street, addr:housenumber, addr:postcode)
+// normalized street -> house number -> addresses, both levels are hash maps, so resolving
+// "12 rue de la gare 71200" costs a few lookups whatever the size of the file
+class AddressIndex
+{
+public:
+    struct Address
+    {
+        idType id;              // node or way carrying the address
+        string street;          // as in the file
+        string housenumber;
+        string postcode;
+        QPointF position;       // projected
+    };
+
+    // a query split into its parts, the words left after the postcode (the city) are dropped
+    struct Query
+    {
+        string housenumber;
+        string street;          // normalized
+        string postcode;
+    };
+
+    struct Result
+    {
+        bool found = false;
+        bool exactNumber = false;   // false when the number is missing or unknown on the street
+        string label;               // "12 Rue de la Gare 71200"
+        QPointF position;
+        idType address = 0;         // id of the feature with the address, 0 for a street alone
+        idType node = 0;            // closest road node, the start or end of a route (set by the model)
+    };
+
+    AddressIndex(){}
+
+    void clear();
+
+    void addAddress(const Address &address);
+
+    // a street known without any house number, to be found with the street name only
+    void addStreet(const string &name, QPointF position);
+
+    Result lookup(const string &query) const;
+
+    static Query parse(const string &query);
+
+    // normalized street name, abbreviations expanded ("av." -> "avenue")
+    static string streetKey(const string &street);
+
+    const vector<Address> &addresses() const;
+
+    size_t streetCount() const;
+
+private:
+    struct Street
+    {
+        string name;
+        QPointF position;       // of the street itself or of its first address
+        unordered_map<string, vector<uint32_t>> numbers;   // normalized number -> positions in m_addresses
+    };
+
+    vector<Address> m_addresses;
+    vector<Street> m_streets;
+    unordered_map<string, uint32_t> m_streetIds;
+
+    uint32_t streetId(const string &key, const string &name, QPointF position);
+
+    // "12 b", "12B" and "12 bis" give "12b" and "12bis"
+    static string numberKey(const string &number);
+
+    Result result(const Street &street, const vector<uint32_t> &candidates, const Query &query, bool exact) const;
+};
+
+#endif // ADDRESSINDEX_H
@@ -0,0 +1,127 @@
+#ifndef CHUNKSTORE_H
+#define CHUNKSTORE_H
+
+#include <QObject>
+#include <QRectF>
+#include <QPointF>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <cstdint>
+#include "rtree.h"
+#include "geometrystore.h"
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// side of the square cells the ways are grouped by on disk, in scene units
+#define CHUNK_SIZE 10000.0
+// chunks kept around the view, as a fraction of its size on each side
+#define CHUNK_MARGIN 0.5
+
+// the ways of a whole region cut in chunks on disk, so that only the part under the view is
+// in memory: import() reads the osm file once with the node locations in a file and writes the
+// projected ways grouped by the cell of their center, then open() only reads the chunk table
+// the chunks are read when a view or a route corridor needs them, and the least recently
+// used ones are dropped above the memory limit
+//
+// files of a store directory:
+//   index.bin   "MAPCHNK1", chunk size, chunk count, then per chunk: cell, offset, bytes, ways, box
+//   chunks.bin  per chunk, per way: id, area flag, style, point count, projected points
+class ChunkStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Way
+    {
+        idType id;
+        bool isPolygon;
+        uint8_t type;   // polygonType of an area, roadType of a line
+    };
+
+    // one chunk in memory, the points of the ways stay in place until it is evicted
+    struct Chunk
+    {
+        GeometryStore geometry;
+        vector<Way> ways;
+    };
+
+    // memoryLimit in bytes
+    ChunkStore(size_t memoryLimit = 512 << 20);
+
+    // read the osm file and write the store into dir (made if missing), false on failure
+    static bool import(const string &osmFile, const string &dir, double chunkSize = CHUNK_SIZE);
+
+    // the chunk table of a store made by import(), no chunk is read yet
+    bool open(const string &dir);
+
+    // drop every chunk, chunkEvicted is emitted for each one in memory
+    void close();
+
+    bool isOpen() const;
+
+    // box of every way of the store
+    QRectF bounds() const;
+
+    // read the chunks touching the rect and the margin around it, the closest to its center first
+    // and no more than the memory limit holds, then evict the least recently used ones above the
+    // limit (never the ones of this call), returns these chunks
+    vector<int> request(const QRectF &rect);
+
+    // same for the chunks within margin of the line, the surroundings of a route, from its start
+    vector<int> requestCorridor(const vector<QPointF> &line, double margin);
+
+    // nullptr when the chunk is not in memory
+    const Chunk *chunk(int id) const;
+
+    QRectF chunkBounds(int id) const;
+
+    void setMemoryLimit(size_t bytes);
+
+    size_t memoryUsed() const;
+
+    size_t chunkCount() const;
+
+    size_t loadedCount() const;
+
+    // chunks read from disk since open()
+    size_t readCount() const;
+
+signals:
+    // emitted before the points of the chunk are freed, the items drawing them must go
+    void chunkEvicted(int id);
+
+private:
+    struct Entry
+    {
+        QRectF box;
+        uint64_t offset;
+        uint64_t bytes;
+        uint32_t ways;
+        unique_ptr<Chunk> data;
+        size_t memory;
+        list<int>::iterator position;
+    };
+
+    string m_dir;
+    vector<Entry> m_chunks;
+    RTree m_index;              // ids are positions in m_chunks
+    QRectF m_bounds;
+    size_t m_memoryLimit;
+    size_t m_memory;
+    size_t m_reads;
+    list<int> m_lru;            // chunks in memory, most recently used first
+
+    bool load(int id);
+
+    // ids of the chunks to keep are the ones just requested
+    void evict(const vector<int> &keep);
+
+    // the chunks in the order given, until the next one would take the set over the limit
+    // (the first one is always read)
+    vector<int> touch(const vector<idType> &ids);
+};
+
+#endif // CHUNKSTORE_H
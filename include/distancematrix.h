@@ -0,0 +1,69 @@
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+// Generic Libraries
+//===============================================
+#include <ostream>
+#include <string>
+#include <vector>
+//===============================================
+#include <mygraphbuilder.h>
+#include <radixheap.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// travel times and lengths between every source and every target, for the distance tables
+// one search per source, stopped once every target is settled, the sources are shared between
+// threads; each thread keeps its labels between its searches and only resets what it touched
+// the cells are row-major, a row per source: the fastest route in milliseconds (COST_INFINITE
+// when there is none) and its length in meters
+class DistanceMatrix
+{
+private:
+  vector <idType> Sources;
+  vector <idType> Targets;
+  vector <costType> Times;
+  vector <float> Meters;
+  size_t Settled;
+  // the labels of one thread
+  struct Search
+  {
+    vector <costType> distances;
+    vector <double> lengths;
+    vector <unsigned int> touched;    // vertices whose labels are not reset
+    RadixHeap Queue;
+  };
+  // Target columns of each target vertex: TargetColumns[TargetFirst[v]] to TargetColumns[TargetFirst[v + 1] - 1]
+  vector <unsigned int> TargetFirst;
+  vector <unsigned int> TargetColumns;
+  size_t TargetVertices;
+  size_t sweep(graph_t const&, vector<costType> const&, unsigned int, size_t, Search &);
+  //===============================================
+public:
+  DistanceMatrix();
+  // the sources and targets are nodes of the graph, a node off it gets an unreachable row or column
+  // threads 0 uses every core
+  void compute(MyGraphBuilder const&, vector<costType> const&, vector<idType> const&, vector<idType> const&, unsigned int = 0);
+
+  // a table of seconds (or meters), the target nodes on the first line and a source node first on
+  // the others, an unreachable cell is empty
+  void writeCsv(ostream &, bool = false) const;
+  // "DMX1", rows and columns as uint32, the source then target nodes as uint64, the times as uint32
+  // then the meters as float32, all row-major and in the byte order of the machine
+  void writeBinary(ostream &) const;
+  // binary unless the name ends with .csv
+  bool save(string const&) const;
+  //===============================================
+  //Accessors
+  size_t getRowCount() const;
+  size_t getColumnCount() const;
+  costType getTime(size_t, size_t) const;
+  double getMeters(size_t, size_t) const;
+  vector <costType> const& getTimes() const;
+  vector <float> const& getMeters() const;
+  // vertices the searches of the last compute settled
+  size_t getSettledCount() const;
+};
+
+#endif // DISTANCEMATRIX_H
@@ -0,0 +1,62 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+// typo tolerant search over the words of the catalog (SymSpell, symmetric delete)
+// every word of the dictionary is stored under all the strings obtained by deleting up to
+// maxDistance characters of its prefix; a query word generates its own deletions and the
+// words sharing one of them are the only ones checked with the real edit distance
+class FuzzyIndex
+{
+public:
+    struct Match
+    {
+        uint32_t doc;
+        unsigned distance;  // sum over the words of the query
+    };
+
+    FuzzyIndex(unsigned maxDistance = 2, unsigned prefixLength = 7);
+
+    void clear();
+
+    // the text is normalized and split into words, documents must come with increasing ids
+    void add(uint32_t doc, const string &text);
+
+    // documents where every word of the query matches one of their words, closest first
+    vector<Match> search(const string &query) const;
+
+    // words of the dictionary close to the word, with their distance
+    vector<pair<uint32_t, unsigned>> searchWord(const string &word) const;
+
+    const string &word(uint32_t id) const;
+
+    size_t wordCount() const;
+
+    // approximate heap memory used by the index, in bytes
+    size_t memoryUsage() const;
+
+    // optimal string alignment distance (Damerau-Levenshtein without substring moves),
+    // returns bound + 1 as soon as the distance is known to be larger than bound
+    static unsigned editDistance(const string &a, const string &b, unsigned bound);
+
+private:
+    unsigned m_maxDistance;
+    unsigned m_prefixLength;
+    vector<string> m_words;
+    unordered_map<string, uint32_t> m_wordIds;
+    vector<vector<uint32_t>> m_wordDocs;        // sorted documents of every word
+    unordered_map<size_t, vector<uint32_t>> m_deletes;  // hash of a deletion -> words
+
+    // allowed distance for a word, short words get less typos
+    unsigned allowedDistance(const string &word) const;
+
+    static void deletions(const string &word, unsigned distance, vector<string> &result);
+};
+
+#endif // FUZZYINDEX_H
@@ -0,0 +1,100 @@
+#ifndef GEOMETRYSTORE_H
+#define GEOMETRYSTORE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <QPointF>
+#include <QRectF>
+#include <QPolygonF>
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// points of a geometry stored somewhere else, QPainter draws them without a copy
+struct PointSpan
+{
+    const QPointF *data = nullptr;
+    int size = 0;
+};
+
+// projected coordinates of every way in one buffer, a way is an offset and a length in it
+// the model, the scene items and the tiles read the same points instead of keeping their own
+// QPolygonF, the bounding box and the centroid are computed once when the way is added
+// the buffer never moves once built, until clear()
+// an area of a multipolygon relation is one way whose points are its rings one after the other,
+// with a table of the length of each ring
+class GeometryStore
+{
+public:
+    struct Way
+    {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t firstRing; // in m_rings, for an area of several rings
+        uint32_t ringCount; // 0 for a way
+        QRectF bound;
+        QPointF centroid;   // of the area for a closed way, the middle of the line otherwise
+    };
+
+    GeometryStore();
+
+    void clear();
+
+    void reserve(size_t ways, size_t points);
+
+    // key of the area of a multipolygon relation, relation ids would collide with the way ids
+    static idType areaKey(idType relationId)
+    {
+        return relationId | (idType(1) << 63);
+    }
+
+    // the points of a way are added one by one, then the way is closed with its id
+    void addPoint(QPointF point);
+
+    void finishWay(idType id, bool closed);
+
+    // the points added since the last ring are a closed ring of the area being added,
+    // the points left when the way is finished are its last ring
+    void finishRing();
+
+    bool contains(idType id) const;
+
+    PointSpan points(idType id) const;
+
+    // one span per ring of an area, the points of a way as one span
+    vector<PointSpan> rings(idType id) const;
+
+    QRectF bounds(idType id) const;
+
+    QPointF centroid(idType id) const;
+
+    // a copy, for the Qt calls that need a QPolygonF
+    QPolygonF polygon(idType id) const;
+
+    size_t wayCount() const;
+
+    size_t pointCount() const;
+
+    // bytes used by the buffer and the tables
+    size_t memory() const;
+
+    // odd-even rule, as QPolygonF::containsPoint with Qt::OddEvenFill
+    static bool containsPoint(PointSpan points, QPointF pos);
+
+    // distance from the point to the closest segment
+    static double distanceToLine(PointSpan points, QPointF pos);
+
+private:
+    vector<QPointF> m_points;
+    vector<Way> m_ways;
+    vector<uint32_t> m_rings;                   // points of each ring of the areas
+    unordered_map<idType, uint32_t> m_index;   // way id -> position in m_ways
+    uint32_t m_wayStart;                        // first point of the way being added
+    uint32_t m_ringStart;                       // first point of the ring being added
+    uint32_t m_wayRings;                        // first ring of the way being added
+
+    const Way *find(idType id) const;
+};
+
+#endif // GEOMETRYSTORE_H
@@ -0,0 +1,54 @@
+#ifndef ISOCHRONE_H
+#define ISOCHRONE_H
+
+// Generic Libraries
+//===============================================
+#include <vector>
+// Qt Libraries
+//===============================================
+#include <QPointF>
+#include <QPolygonF>
+//===============================================
+#include <mygraphbuilder.h>
+#include <radixheap.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// what can be reached from a node within one or more costs: a Dijkstra stopped at the largest
+// budget, the vertices are kept in the order they are settled so each budget is a prefix of them
+// the labels stay between searches and only the vertices touched are reset
+class Isochrone
+{
+private:
+  graph_t const* Graph;
+  vector <costType> const* Weights;
+  vector <costType> Budgets;          // sorted
+  vector <size_t> Counts;             // vertices within each budget
+  vector <unsigned int> Reached;      // settled vertices, by cost
+  vector <costType> distances;        // cost from the source, COST_INFINITE beyond the budgets
+  vector <unsigned int> touched;
+  RadixHeap Queue;
+  //===============================================
+public:
+  Isochrone();
+  // budgets in milliseconds in any order, false when the source is not in the graph
+  // the graph and the weights must outlive the result
+  bool compute(graph_t const&, GraphMap const&, vector<costType> const&, idType, vector<costType> const&);
+
+  // the outline of a budget on a grid of square cells (scene units): a cell is in when a reached
+  // vertex or a reached part of an edge goes through it; the rings are the outer borders and the
+  // holes, to fill with the odd-even rule
+  vector <QPolygonF> outline(size_t, double) const;
+  //===============================================
+  //Accessors
+  size_t getBudgetCount() const;
+  costType getBudget(size_t) const;
+  size_t getReachedCount(size_t) const;
+  vector <idType> getReachedNodes(size_t) const;
+  vector <QPointF> getReachedPoints(size_t) const;
+  // vertices the last search settled, the ones of the largest budget
+  size_t getSettledCount() const;
+};
+
+#endif // ISOCHRONE_H
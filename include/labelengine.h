@@ -0,0 +1,78 @@
+#ifndef LABELENGINE_H
+#define LABELENGINE_H
+
+#include <QString>
+#include <QPointF>
+#include <QRectF>
+#include <QFont>
+#include <QStaticText>
+#include <vector>
+#include <unordered_map>
+#include "rtree.h"
+
+using namespace std;
+
+// at most this number of labels on the screen
+#define MAX_LABELS 300
+// side of the cells of the collision grid, in pixels
+#define LABEL_CELL 64.0
+// free space kept around a label, in pixels
+#define LABEL_PADDING 3.0
+// glyph layouts kept between frames
+#define LABEL_LAYOUT_CACHE 4096
+
+// picks the labels shown in a view: most important first, each one kept only when its box
+// on the screen doesn't touch a label already placed (grid of the placed boxes)
+// the glyph layouts (QStaticText) are made the first time a label is measured and kept
+class LabelEngine
+{
+public:
+    struct Label
+    {
+        QString text;
+        QPointF pos;        // scene position of the center of the text
+        int priority;       // higher first
+        qreal minScale;     // hidden below this scale (pixels per scene unit)
+        bool emphasized;    // search results, bigger font
+    };
+
+    LabelEngine();
+
+    void clear();
+
+    void addLabel(const QString &text, QPointF pos, int priority, qreal minScale = 0);
+
+    // sort the labels by priority and index their positions, call it once every label is added
+    // and before any temporary label
+    void build();
+
+    // labels added after build(), always shown before the others and removed by clearTemporary
+    void addTemporary(const QString &text, QPointF pos);
+
+    void clearTemporary();
+
+    // positions in m_labels of the labels placed in the view at the scale
+    vector<size_t> place(const QRectF &view, qreal scale);
+
+    const Label &label(size_t i) const;
+
+    const QFont &font(size_t i) const;
+
+    // laid out once, then taken from the cache
+    const QStaticText &layout(size_t i);
+
+    size_t size() const;
+
+    // box of every label position
+    QRectF bounds() const;
+
+private:
+    vector<Label> m_labels;     // by decreasing priority after build(), then the temporary ones
+    size_t m_indexed;           // labels in m_index
+    RTree m_index;              // ids are positions in m_labels
+    unordered_map<size_t, QStaticText> m_layouts;
+    QFont m_font;
+    QFont m_emphasizedFont;
+};
+
+#endif // LABELENGINE_H
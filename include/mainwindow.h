@@ -8,7 +8,15 @@
 #include <mapview.h>
 #include <QVBoxLayout>
 #include "SceneBuilder.h"
+#include "tilecache.h"
+#include "chunkstore.h"
 #include <shortpath.h>
+#include <distancematrix.h>
+#include <isochrone.h>
+#define SEARCH_SUGGESTIONS 10
+// side of the grid cells of the reachability outlines, in scene units
+#define ISOCHRONE_CELL 50.0
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
@@ -25,19 +33,33 @@ private:
   //Start
   vector<pair<QString,idType>> MyPlaces ;
   void fill_MyPlaces();
+  // a name of MyPlaces or an address typed in the combo box, to a node of the road graph
+  bool resolvePlace(const QString &text, idType &node);
   //Initilaization of the Sourse Node, and Destination Node
   idType SourceS = 1545694404;
   idType DestinationD = 1545694404;
+  // profile of the next route, chosen in Mode_QB
+  travelMode Mode = CarMode;
+  // the road graph of the file, built on the first route and kept for the next ones
+  MyGraphBuilder *m_graph = nullptr;
+  TurnGraph *m_turns = nullptr;
+  WeightOverlay *m_weights = nullptr;
+  void buildRoutingGraph();
+  void clearRoutingGraph();
   //End
   //=============================================
   bool m_leftMousePressed;
   Ui::MainWindow *ui;
   MapView *m_mapView;
   SceneBuilder *m_sceneBuilder;
+  TileCache *m_tileCache;
+  ChunkStore *m_chunks;
   //    QVBoxLayout *m_layoutView;
   Model *m_model;
   qreal m_scale;
   void loadFile(string );
+  // the base map of a store made by ChunkStore::import, paged in as the view moves
+  void openRegion(QString dir);
   void resizeEvent(QResizeEvent *event);
   void viewSizeAdjust(QResizeEvent *event);
   void sendCancelRoute();
@@ -55,13 +77,21 @@ signals:
 public slots:
   void getRoutePath(idType src, idType dest);
   void getSearchName();
+  void showDetail(QPointF scenePos);
 
 private slots:
   void on_Source_QB_activated(const QString &arg1);
   void on_Destination_QB_activated(const QString &arg1);
+  void on_Mode_QB_activated(int index);
   void on_Navigate_Button_clicked();
   void on_actionQuit_triggered();
   void on_action_Open_File_triggered();
+  void on_actionRaster_Tiles_toggled(bool checked);
+  void on_actionImport_Region_triggered();
+  void on_actionOpen_Region_triggered();
+  void on_actionTraffic_Updates_triggered();
+  void on_actionPlaces_Matrix_triggered();
+  void on_actionReachability_triggered();
   void on_Cancel_Navigation_clicked();
 };
 #endif // MAINWINDOW_H
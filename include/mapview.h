@@ -19,6 +19,9 @@
 #include <QObject>
 #include <QWidget>
 
+class SceneBuilder;
+class TileCache;
+
 class MapView : public QGraphicsView
 {
     Q_OBJECT
@@ -30,14 +33,30 @@ public:
 
     ~MapView();
 
+    // picking goes through the spatial index of the scene builder, nothing is picked without it
+    void setSceneBuilder(SceneBuilder *builder);
+
+    // the part of the scene currently shown in the viewport
+    QRectF visibleSceneRect();
+
+    // with the tiles enabled the map is drawn from the raster tiles of the cache in the background,
+    // the scene only draws what is on top of it (route, pins and texts)
+    void setTileCache(TileCache *cache);
+
+    void setTilesEnabled(bool enabled);
+
 private:
     qreal m_scale;
-    Multipolygon* m_selectedItem;
+    idType m_selectedId;    // polygon under the last right click
     bool m_isBuilding;
     userState m_state;
     QPoint m_pressPos;
+    QPointF m_detailPos;    // scene position of the last right click
     idType m_srcId;
     idType m_destId;
+    SceneBuilder *m_sceneBuilder;
+    TileCache *m_tileCache;
+    bool m_tilesEnabled;
 
     void mousePressEvent(QMouseEvent *event);
 
@@ -45,18 +64,29 @@ private:
 
     void wheelEvent(QWheelEvent *event);
 
+    void scrollContentsBy(int dx, int dy);
+
+    void resizeEvent(QResizeEvent *event);
+
+    void drawBackground(QPainter *painter, const QRectF &rect);
+
 signals:
-    void setSource(Multipolygon *item);
-    void setDest(Multipolygon *item);
+    void setSource(idType wayId);
+    void setDest(idType wayId);
     void searchPlace();
     void canecl(); //delete all temporary render item
     void makeRoute();
+    void viewportChanged(QRectF rect);
+    void showDetail(QPointF scenePos);
 
 public slots:
     void changeToSearch();
     void changeToInit();
     void changeToRoute();
+    // nothing to pick, search or route, like before the first file
+    void changeToNull();
     userState getUserState();
+    void tileReady();
 
 };
 
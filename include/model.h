@@ -56,6 +56,10 @@ class Model
 
         osmium::apply(reader, handler);
         reader.close();
+
+        m_Data->buildSpatialIndex();
+        m_Data->buildReverseGeocoder();
+        m_Data->buildAddressIndex();
     }
 
 
@@ -78,6 +82,22 @@ public:
         }
     }
 
+    // back to no file, when the map comes from a region store instead
+    void unload()
+    {
+        if(m_isFileLoaded)
+            m_Data->clear();
+        m_isFileLoaded = false;
+        m_filePath = "";
+        m_bottomLeft = QPointF();
+        m_topRight = QPointF();
+    }
+
+    string getFilePath()
+    {
+        return m_filePath;
+    }
+
     const osmium::Location getNodeLoaction(idType id)
     {
         return m_Data->getNodeLoaction(id);
@@ -113,14 +133,25 @@ public:
         return m_Data->getRelationMap();
     }
 
+    const map<idType, polygonType> getAreaMap()
+    {
+        return m_Data->getAreaMap();
+    }
+
+    vector<MultipolygonArea> assembleAreas(unsigned threads = 0)
+    {
+        return m_Data->assembleAreas(threads);
+    }
+
     const map<idType,vector<idType>> getMPMap()
     {
         return m_Data->getMultipolygon();
     }
 
-    void buildAmenityCatalog()
+    // threads = 0 uses every core
+    void buildAmenityCatalog(unsigned threads = 0)
     {
-        m_Data->buildAmenityCatagory();
+        m_Data->buildAmenityCatagory(threads);
     }
 
     vector<catagoryData> searchAmenityByName(string name)
@@ -128,6 +159,36 @@ public:
         return m_Data->searchAmenityByName(name);
     }
 
+    vector<string> autocomplete(const string &prefix, size_t k)
+    {
+        return m_Data->autocomplete(prefix, k);
+    }
+
+    vector<string> autocompleteNear(const string &prefix, size_t k, QPointF center)
+    {
+        return m_Data->autocompleteNear(prefix, k, center);
+    }
+
+    vector<catagoryData> searchAmenityFuzzy(string name)
+    {
+        return m_Data->searchAmenityFuzzy(name);
+    }
+
+    vector<string> suggestFuzzy(const string &name, size_t k)
+    {
+        return m_Data->suggestFuzzy(name, k);
+    }
+
+    size_t fuzzyIndexMemory()
+    {
+        return m_Data->fuzzyIndexMemory();
+    }
+
+    const vector<catagoryData> &getAmenityCatalog()
+    {
+        return m_Data->getAmenityCatalog();
+    }
+
     vector<catagoryData> searchAmenityByType(string name)
     {
         return m_Data->searchAmenityByType(name);
@@ -138,6 +199,94 @@ public:
         return m_Data->isAmenityTypeExist(name);
     }
 
+    // places matching the text around a point, closest first
+    vector<catagoryData> searchAmenityNear(const string &text, QPointF center, double radius, size_t limit)
+    {
+        return m_Data->searchAmenityNear(text, center, radius, limit);
+    }
+
+    // places matching the text inside a rect (the view), closest to its center first
+    vector<catagoryData> searchAmenityInRect(const string &text, const QRectF &rect, size_t limit)
+    {
+        return m_Data->searchAmenityInRect(text, rect, limit);
+    }
+
+    vector<idType> searchWayInRect(const QRectF &rect)
+    {
+        return m_Data->searchWayInRect(rect);
+    }
+
+    // top-most polygon under a scene position, 0 if there is none
+    idType searchPolygonAt(QPointF pos)
+    {
+        return m_Data->searchPolygonAt(pos);
+    }
+
+    vector<idType> searchNearestWay(QPointF pos, size_t k)
+    {
+        return m_Data->searchNearestWay(pos, k);
+    }
+
+    QRectF getWayBounds(idType id)
+    {
+        return m_Data->getWayBounds(id);
+    }
+
+    QPointF getWayCentroid(idType id)
+    {
+        return m_Data->getWayCentroid(id);
+    }
+
+    // projected points of every way, shared by the scene items and the tiles
+    const GeometryStore &getGeometry()
+    {
+        return m_Data->getGeometry();
+    }
+
+    // nearest named place, enclosing area and nearest street of a scene position
+    ReverseGeocoder::Result reverseGeocode(QPointF pos)
+    {
+        return m_Data->getReverseGeocoder().lookup(pos);
+    }
+
+    ReverseGeocoder::Result reverseGeocode(const osmium::Location &location)
+    {
+        return m_Data->getReverseGeocoder().lookup(location);
+    }
+
+    // a whole track at once (a GPS log for instance), on every core
+    vector<ReverseGeocoder::Result> reverseGeocode(const vector<QPointF> &positions, unsigned threads = 0)
+    {
+        return m_Data->getReverseGeocoder().lookup(positions, 500, threads);
+    }
+
+    // "12 rue de la gare 71200" to a position and the closest road node
+    AddressIndex::Result geocodeAddress(const string &query)
+    {
+        return m_Data->geocodeAddress(query);
+    }
+
+    const AddressIndex &getAddressIndex()
+    {
+        return m_Data->getAddressIndex();
+    }
+
+    idType snapToRoad(QPointF pos)
+    {
+        return m_Data->snapToRoad(pos);
+    }
+
+    idType snapToRoad(QPointF pos, travelMode mode)
+    {
+        return m_Data->snapToRoad(pos, mode);
+    }
+
+    // bounding box of all the ways in scene coordinates
+    QRectF getBounds()
+    {
+        return m_Data->getBounds();
+    }
+
     QPointF getCenter()
     {
 
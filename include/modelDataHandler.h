@@ -28,87 +28,96 @@ class modelDataHandler : public osmium::handler::Handler
         }
     }
 
+public:
     // using tons of if-else to filter the data, it's stupid but it works
-    void getTagsAndType(std::vector<tagPair>& tagStore, const osmium::TagList& tagList, wayData& wayD)
+    // one tag at a time, the multipolygon relations are styled with it too
+    static void classifyTag(const string &tempKey, const string &tempValue, wayData& wayD, bool &nonPolyFlag)
     {
-        bool nonPolyFlag = false;
-        for(const auto& tag:tagList)
+        if(tempKey == "highway")
         {
-            string tempKey = tag.key();
-            string tempValue = tag.value();
-
-            if(tempKey == "highway")
-            {
-                nonPolyFlag = true;
-                wayD.isPolygon = false;
-                if (tempValue == "footway")
-                    wayD.rType = Footway;
-                else if(tempValue == "motorway")
-                    wayD.rType = Motorway;
-                else if(tempValue == "trunk")
-                    wayD.rType = Trunk;
-                else if(tempValue == "primary")
-                    wayD.rType = Primary;
-                else if(tempValue == "secondary")
-                    wayD.rType = Secondary;
-                else if (tempValue == "tertiary")
-                    wayD.rType = Tertiary;
-                else if (tempValue == "service")
-                    wayD.rType = Service;
-                else if (tempValue == "residential")
-                    wayD.rType = Residential;
-                else if (tempValue == "unclassified")
-                    wayD.rType = Unclassified;
-                else
-                    wayD.rType = Invalid;
-            }
-            else if(tempKey == "railway")
-            {
-                wayD.isPolygon = false;
-                nonPolyFlag = true;
-                wayD.rType = Railway;
-            }
-            else if(tempKey == "boundary" || tempKey == "barrier")
+            nonPolyFlag = true;
+            wayD.isPolygon = false;
+            if (tempValue == "footway")
+                wayD.rType = Footway;
+            else if(tempValue == "motorway")
+                wayD.rType = Motorway;
+            else if(tempValue == "trunk")
+                wayD.rType = Trunk;
+            else if(tempValue == "primary")
+                wayD.rType = Primary;
+            else if(tempValue == "secondary")
+                wayD.rType = Secondary;
+            else if (tempValue == "tertiary")
+                wayD.rType = Tertiary;
+            else if (tempValue == "service")
+                wayD.rType = Service;
+            else if (tempValue == "residential")
+                wayD.rType = Residential;
+            else if (tempValue == "unclassified")
+                wayD.rType = Unclassified;
+            else
+                wayD.rType = Invalid;
+        }
+        else if(tempKey == "railway")
+        {
+            wayD.isPolygon = false;
+            nonPolyFlag = true;
+            wayD.rType = Railway;
+        }
+        else if(tempKey == "boundary" || tempKey == "barrier")
+        {
+            wayD.isPolygon = false;
+            nonPolyFlag = true;
+        }
+        else if(wayD.isClosed)
+        {
+            if(!nonPolyFlag)
+                wayD.isPolygon = true;
+            if(tempKey == "building" || tempKey == "tourism" || tempKey == "man_made" || tempKey == "area" || tempKey == "old_building")
+                wayD.pType = building;
+            else if(tempKey == "leisure" || tempKey == "amenity")
+                wayD.pType = leisure;
+            else if(tempKey == "waterway")
+                wayD.pType = water;
+            else if(tempKey == "landuse")
             {
-                wayD.isPolygon = false;
-                nonPolyFlag = true;
+                if(tempValue == "water")
+                    wayD.pType = water;
+                else if(tempValue == "grass" || tempValue == "grassland" || tempValue == "wood" || tempValue == "heath" || tempValue == "farmland")
+                    wayD.pType = grass;
+                else if(tempValue == "industrial")
+                    wayD.pType = industrial;
+                else if(tempValue == "residential")
+                    wayD.pType = residential;
+                else if(tempValue == "retail")
+                    wayD.pType = commercial;
+                else if(tempValue == "meadow" || tempValue == "forest")
+                    wayD.pType = forest;
             }
-            else if(wayD.isClosed)
+            else if(tempKey == "natural")
             {
-                if(!nonPolyFlag)
-                    wayD.isPolygon = true;
-                if(tempKey == "building" || tempKey == "tourism" || tempKey == "man_made" || tempKey == "area" || tempKey == "old_building")
-                    wayD.pType = building;
-                else if(tempKey == "leisure" || tempKey == "amenity")
-                    wayD.pType = leisure;
-                else if(tempKey == "waterway")
+                if(tempValue == "water")
                     wayD.pType = water;
-                else if(tempKey == "landuse")
-                {
-                    if(tempValue == "water")
-                        wayD.pType = water;
-                    else if(tempValue == "grass" || tempValue == "grassland" || tempValue == "wood" || tempValue == "heath" || tempValue == "farmland")
-                        wayD.pType = grass;
-                    else if(tempValue == "industrial")
-                        wayD.pType = industrial;
-                    else if(tempValue == "residential")
-                        wayD.pType = residential;
-                    else if(tempValue == "retail")
-                        wayD.pType = commercial;
-                    else if(tempValue == "meadow" || tempValue == "forest")
-                        wayD.pType = forest;
-                }
-                else if(tempKey == "natural")
-                {
-                    if(tempValue == "water")
-                        wayD.pType = water;
-                    if(tempValue == "scrub" || tempValue == "heath")
-                        wayD.pType = grass;
-                }
+                if(tempValue == "scrub" || tempValue == "heath")
+                    wayD.pType = grass;
             }
+        }
+    }
+
+    // static, the import of a ChunkStore styles the ways with it too
+    static void getTagsAndType(std::vector<tagPair>& tagStore, const osmium::TagList& tagList, wayData& wayD)
+    {
+        bool nonPolyFlag = false;
+        for(const auto& tag:tagList)
+        {
+            string tempKey = tag.key();
+            string tempValue = tag.value();
+            classifyTag(tempKey, tempValue, wayD, nonPolyFlag);
             tagStore.emplace_back(std::make_pair(tempKey,tempValue));
         }
     }
+
+private:
     modelData* m_modelData;
 
 public:
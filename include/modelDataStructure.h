@@ -5,6 +5,7 @@
 #include <vector>
 #include "osmium/osm.hpp"
 #include <Qt>
+#include <QPointF>
 #include "RenderEnum.h"
 
 using namespace std;
@@ -51,6 +52,8 @@ struct catagoryData
     osmium::item_type itemType;
     vector<string> name;
     string type;
+    uint32_t typeId;    // position of the type in the type table of the catalog
+    QPointF position;   // projected, the node itself or the center of the way
 };
 
 #endif // MODELDATASTRUCTURE_H
@@ -9,6 +9,21 @@
 #include <osmium/index/map/flex_mem.hpp>
 //#include <modelDataHandler.h>
 #include <set>
+#include <unordered_map>
+#include <thread>
+#include <QPointF>
+#include <QRectF>
+#include <QPolygonF>
+#include "rtree.h"
+#include "trigramindex.h"
+#include "prefixindex.h"
+#include "fuzzyindex.h"
+#include "reversegeocoder.h"
+#include "addressindex.h"
+#include "geometrystore.h"
+#include "multipolygon.h"
+#include "routingprofile.h"
+#include <functional>
 
 using namespace std;
 
@@ -22,17 +37,53 @@ class modelData
     map<idType, wayData> m_WayMap;
     map<idType, relationData> m_RelationMap;
     map<idType, vector<idType>> m_Multipolygon;
+    map<idType, polygonType> m_AreaMap;    // assembled multipolygon relations, in m_Geometry
     vector<catagoryData> m_Amenity;
-    set<string> m_AmenityType;
+    // type table of the catalog: lower case type -> id -> positions in m_Amenity (sorted)
+    unordered_map<string, uint32_t> m_AmenityTypeId;
+    vector<string> m_AmenityTypeName;
+    vector<vector<uint32_t>> m_AmenityTypeBucket;
+    TrigramIndex m_AmenityNameIndex;    // document = position in m_Amenity
+    PrefixIndex m_AmenityPrefixIndex;   // names and types for the autocompletion
+    FuzzyIndex m_AmenityFuzzyIndex;     // words of the names and types, up to 2 typos
+    RTree m_AmenityIndex;               // position of the places, id = position in m_Amenity
+    RTree m_WayIndex;
+    GeometryStore m_Geometry;           // projected points, box and centroid of every way
+    ReverseGeocoder m_Geocoder;
+    AddressIndex m_Addresses;
 
     friend class modelDataHandler;
 
 
-    vector<string> findName(vector<tagPair> &tags);
+    vector<string> findName(const vector<tagPair> &tags);
 
+    uint32_t getTypeId(const string &type);
 
+    // ids of the types equal to the name, or containing it when there is none
+    vector<uint32_t> matchTypes(const string &name);
+
+
+    // catalog entries of a range of the node or way map, only reads the model
+    template <typename Iterator>
+    void collectCatagory(Iterator first, Iterator last, vector<catagoryData> &result);
+
+    // the map is split in one range per thread, the ranges are merged back in map order
     template <typename T>
-    void buildCatagory(const T &map);
+    void buildCatagory(const T &map, unsigned threads);
+
+    // places matching the text closer than radius to the center (and inside the rect if any),
+    // closest first, the text is looked up first when it is rare, the area otherwise
+    vector<catagoryData> searchAmenitySpatial(const string &text, QPointF center, double radius, const QRectF *rect, size_t limit);
+
+    // distance from a point to the outline of a way, 0 inside a polygon
+    double distanceToWay(QPointF pos, idType id, const wayData &way);
+
+    // rings of a type=multipolygon relation, false when it has no closed outer ring
+    // or no area style (the outer way is then drawn as a way)
+    bool assembleArea(idType id, const relationData &relation, MultipolygonArea &area);
+
+    // node closest to the point among the ways accepted, 0 if there is none
+    idType snapToWay(QPointF pos, const function<bool(const wayData &)> &accept);
 
 
 public:
@@ -58,20 +109,95 @@ public:
 
     const map<idType, vector<idType>> getMultipolygon();
 
+    // styles of the multipolygon relations assembled into areas, their rings are in the
+    // geometry store under GeometryStore::areaKey(relation id)
+    const map<idType, polygonType> getAreaMap();
+
+    // areas of the type=multipolygon relations, the relations are split in one range per thread
+    // (threads = 0 uses every core), only reads the model
+    vector<MultipolygonArea> assembleAreas(unsigned threads = 0);
+
 
-    void buildAmenityCatagory();
+    // threads = 0 uses every core, the catalog is the same whatever the number of threads
+    void buildAmenityCatagory(unsigned threads = 0);
 
 
 
     //return a vector of catagory data
     vector<catagoryData> searchAmenityByName(string name);
 
+    const vector<catagoryData> &getAmenityCatalog();
+
+    // k names or types starting with the prefix (at any word), the most important first
+    vector<string> autocomplete(const string &prefix, size_t k);
+
+    // same, the closest to the center first
+    vector<string> autocompleteNear(const string &prefix, size_t k, QPointF center);
+
+    // places whose names or type match every word of the query with a few typos,
+    // only the ones with the smallest number of typos are returned
+    vector<catagoryData> searchAmenityFuzzy(string name);
+
+    // names of the k closest fuzzy matches, for the search dialog
+    vector<string> suggestFuzzy(const string &name, size_t k);
+
+    size_t fuzzyIndexMemory();
+
 
     bool isAmenityTypeExist(string name);
 
 
     vector<catagoryData> searchAmenityByType(string name);
 
+    // places whose type or name matches the text (as the two searches above) at most radius
+    // away from the center, closest first, at most limit of them
+    vector<catagoryData> searchAmenityNear(const string &text, QPointF center, double radius, size_t limit);
+
+    // same inside the rect, closest to its center first
+    vector<catagoryData> searchAmenityInRect(const string &text, const QRectF &rect, size_t limit);
+
+
+    // project every way into the geometry store and bulk load their boxes into the R-tree,
+    // then add the areas of the multipolygon relations to the store, called once the file is loaded
+    void buildSpatialIndex();
+
+    const GeometryStore &getGeometry();
+
+    // ways whose bounding box intersects the rect (scene coordinates)
+    vector<idType> searchWayInRect(const QRectF &rect);
+
+    // the top-most polygon containing the point, 0 if there is none
+    idType searchPolygonAt(QPointF pos);
+
+    // the k ways closest to the point, closest first
+    vector<idType> searchNearestWay(QPointF pos, size_t k);
+
+    QRectF getWayBounds(idType id);
+
+    // center of the area of a polygon, middle of a line
+    QPointF getWayCentroid(idType id);
+
+    // named nodes and ways, areas and named streets for the reverse geocoder, called once the file is loaded
+    void buildReverseGeocoder();
+
+    const ReverseGeocoder &getReverseGeocoder();
+
+    // addresses of the nodes and ways, and the named streets, called once the file is loaded
+    void buildAddressIndex();
+
+    const AddressIndex &getAddressIndex();
+
+    // "12 rue de la gare 71200", the result carries the closest road node for the routing
+    AddressIndex::Result geocodeAddress(const string &query);
+
+    // node of a road (a way with a highway tag) closest to the point, 0 if there is none
+    idType snapToRoad(QPointF pos);
+
+    // same among the ways the mode can take, where its routes start and end
+    idType snapToRoad(QPointF pos, travelMode mode);
+
+    QRectF getBounds();
+
 };
 
 #endif // MODELDATA_H
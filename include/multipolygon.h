@@ -0,0 +1,32 @@
+#ifndef MULTIPOLYGON_H
+#define MULTIPOLYGON_H
+
+#include <vector>
+#include <cstdint>
+#include <QPointF>
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// area of a type=multipolygon relation, ready for the geometry store
+struct MultipolygonArea
+{
+    idType id;              // relation id
+    polygonType type;
+    vector<QPointF> points; // every ring in one sequence, see appendRings
+    vector<uint32_t> rings; // points of each ring
+};
+
+// the member ways joined end to end into closed rings (reversed when needed),
+// the pieces that don't close are dropped
+vector<vector<idType>> joinRings(const vector<const vector<idType> *> &ways);
+
+// signed shoelace area of a closed ring, the sign gives the direction it turns
+double ringArea(const vector<QPointF> &ring);
+
+// the closed rings one after the other and their lengths, the outer rings turn one way and
+// the inner ones the other so that the shoelace areas of the rings add up to the area without
+// the holes; a ring is drawn as its own subpath, the holes stay empty with an odd-even fill
+void appendRings(vector<QPointF> &points, vector<uint32_t> &rings, vector<vector<QPointF>> &outer, vector<vector<QPointF>> &inner);
+
+#endif // MULTIPOLYGON_H
@@ -12,40 +12,55 @@
 #include <boost/graph/dag_shortest_paths.hpp>
 //===============================================
 #include <mygraphbuilder.h>
+#include <routegeometry.h>
+#include <radixheap.h>
 //===============================================
 using namespace boost;
 using namespace std;
 using Path = vector <idType>;
+// priority queue of the search: the radix heap uses the integer costs, the d-ary heap is
+// the one of boost::dijkstra_shortest_paths
+enum searchQueue { RadixQueue, DaryQueue };
 //===============================================
 
 class MyAlgorithm
 {
 private:
   graph_t MyGraph2;
+  vector <costType> Weights; // Edge weights of the profile of the search
   unsigned int src;
   bool emptyFlag = 1;
   vector <unsigned int> predecessors; // Vector to Store predecessors
-  vector <double> distances;    // Vector of Edge Weights(Distances)
+  vector <Edge> edgePredecessors; // Vector of the Edges reaching each Vertex
+  vector <costType> distances;  // Vector of route costs from the source
   vector <idType> ShortPath;   // My Shortest Path is a Vector of Vertices
+  RadixHeap Queue;             // kept between runs for its buckets
+  void radixDijkstra();
   //===============================================
 public:
   MyAlgorithm();//Default Constructor
-  MyAlgorithm(graph_t const&,GraphMap,idType);//,Vertex);//Parameters Constructor
+  // the weights of a profile of the builder, the flag is down when the source is not in the graph
+  MyAlgorithm(graph_t const&,GraphMap const&,vector<costType> const&,idType,searchQueue = RadixQueue);//Parameters Constructor
   ~MyAlgorithm();//Default Destructor
 
   //===============================================
   //Accessors
   // function to call the Shortest path as Vector of Nodes
-  Path getShortPath(GraphMap , idType);
+  Path getShortPath(GraphMap const&, idType);
+  // function to call the Shortest path with its geometry, empty when unreachable
+  RouteGeometry getRoute(GraphMap const&, idType);
   // function to get the Graph
   graph_t getGraph();
   bool getFlag();
+  vector <costType> const& getDistances() const;
   //===============================================
   // Mutators
   void setGraph(graph_t);
   // function to assign Shortest path Vertex by Vertex (Overloaded Function)
   void setShortPath(idType);
   //===============================================
+  // function to run the search again from the source, the constructor runs it once
+  void run(searchQueue);
   // function to Reset Shortest path Vector
   void ResetShortPath();
   // function to Print Out The Results
@@ -20,6 +20,7 @@
 #include <modelDataHandler.h>
 #include <modeldata.h>
 #include <model.h>
+#include <routingprofile.h>
 // Osmium Libraries
 //===============================================
 #include <osmium/osm.hpp>
@@ -28,6 +29,7 @@
 #include <osmium/osm/location.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <osmium/geom/haversine.hpp>
 //===============================================
 using namespace std;
 using namespace boost;
@@ -35,12 +37,31 @@ using namespace boost;
 typedef osmium::unsigned_object_id_type idType ;
 //==================================================
 typedef map<idType, wayData> WayMap;
+// route costs are fixed-point integers, milliseconds of travel time: up to 49 days
+typedef uint32_t costType;
+// cost of an edge a profile can't take
+#define COST_INFINITE UINT32_MAX
+// what the route needs of a vertex and of an edge, stored when the graph is built
+// so that unpacking a path does no lookup in the model
+struct VertexInfo
+{
+  idType node = 0;  // OSM node
+  QPointF point;    // projected position
+};
+struct EdgeInfo
+{
+  unsigned int index; // position of the edge in the weights of the profiles, the two
+                      // directions of a segment are 2k (along the way) and 2k + 1
+  double length;      // meters
+  idType way;         // OSM way the edge comes from
+  roadType road;      // road class of that way
+};
 typedef adjacency_list<
     boost::vecS,
     boost::vecS,
     boost::directedS,
-    boost::property<boost::vertex_name_t, idType>,
-    boost::property<boost::edge_weight_t, double>> graph_t;
+    VertexInfo,
+    EdgeInfo> graph_t;
 typedef graph_traits < graph_t >::vertex_descriptor Vertex; // Vertex declaration
 typedef graph_traits < graph_t >::edge_descriptor Edge; // Edge as link between two Nodes specified by ID
 typedef map<idType, unsigned int> GraphMap;
@@ -51,15 +72,19 @@ class MyGraphBuilder
 private:               // This Line is Useless just for clarity
   graph_t MyGraph;
   GraphMap MyGraphMap;
+  // one weight per edge and per profile, the topology is shared by the profiles
+  vector<costType> MyWeights[MODE_COUNT];
   Model* OurModel;
   /////////////////////////////////////////////////////////
 
 public:
   MyGraphBuilder(); // default Constructor
-  MyGraphBuilder(Model); // Parameters Constructor
+  MyGraphBuilder(Model &); // Parameters Constructor, the model must outlive the builder
   ~MyGraphBuilder(); // Destructor
   void generateGraph();
-  double distance(Vertex,Vertex); // function to calculate the distance between 2 Verices
+  double distance(Vertex,Vertex); // function to calculate the distance in meters between 2 Verices
+  double distance(osmium::Location,osmium::Location); // same between 2 locations
+  static costType cost(double,double); // fixed-point travel time of a length in meters at a speed in km/h
   //===============================================
   //Accessors
   // functions to get the Graph
@@ -69,6 +94,9 @@ public:
   // functions to get the Mapping between Nodes ID's and Graph Vertices
   GraphMap const& getGraphMap() const;
   GraphMap        getGraphMap() ;
+  //-------------------------------------------------------------------
+  // function to get the Edge weights of a profile, indexed by EdgeInfo::index
+  vector<costType> const& getWeights(travelMode) const;
   //===============================================
   // Mutators
   void setGraph(graph_t);
@@ -0,0 +1,85 @@
+#ifndef PREFIXINDEX_H
+#define PREFIXINDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <QPointF>
+
+using namespace std;
+
+// autocompletion over a set of terms (names and types of the catalog)
+// every word start of a normalized term is an entry of a sorted array, so "carr" finds
+// "hyper carrefour" too; a prefix is a range of this array, and the best weights of the
+// range come from a sparse table, so a keystroke costs the same for "c" and for "carrefour"
+class PrefixIndex
+{
+public:
+    struct Suggestion
+    {
+        string text;
+        uint32_t doc;
+        uint32_t weight;
+        double distance;    // to the closest position of the term, 0 for the terms without position
+    };
+
+    PrefixIndex(){}
+
+    void clear();
+
+    // the term is normalized here, text is what is shown to the user
+    void add(const string &text, uint32_t doc, uint32_t weight);
+
+    void add(const string &text, uint32_t doc, uint32_t weight, QPointF position);
+
+    // a term found at several places, a type of place for instance
+    void add(const string &text, uint32_t doc, uint32_t weight, const vector<QPointF> &positions);
+
+    // sort the entries and build the sparse table, call it once every term is added
+    void build();
+
+    // k best distinct suggestions by weight, at most budget entries of the range are looked at
+    vector<Suggestion> complete(const string &prefix, size_t k, size_t budget = 256) const;
+
+    // same, but the budget best entries by weight are ranked by distance to the center, from the
+    // closest position of each term; the terms without position have distance 0 and come first
+    vector<Suggestion> completeNear(const string &prefix, size_t k, QPointF center, size_t budget = 256) const;
+
+    size_t size() const;
+
+private:
+    struct Term
+    {
+        string text;
+        string key;
+        uint32_t doc;
+        uint32_t weight;
+        uint32_t firstPosition;     // positions of the term in m_positions
+        uint32_t positionCount;
+    };
+
+    struct Entry
+    {
+        uint32_t term;
+        uint32_t offset;    // word start inside the key
+    };
+
+    vector<Term> m_terms;
+    vector<Entry> m_entries;
+    vector<QPointF> m_positions;
+    vector<vector<uint32_t>> m_sparse;   // m_sparse[j][i] = best entry in [i, i + 2^j)
+
+    void addTerm(const string &text, uint32_t doc, uint32_t weight, const QPointF *positions, size_t count);
+
+    // position of the entries starting with the prefix, [first, last)
+    void range(const string &prefix, size_t &first, size_t &last) const;
+
+    uint32_t best(size_t first, size_t last) const;
+
+    // terms of the range by decreasing weight, one per text when distinct is set
+    vector<uint32_t> topTerms(const string &prefix, size_t k, size_t budget, bool distinct) const;
+
+    Suggestion suggestion(uint32_t term) const;
+};
+
+#endif // PREFIXINDEX_H
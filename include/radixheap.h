@@ -0,0 +1,39 @@
+#ifndef RADIXHEAP_H
+#define RADIXHEAP_H
+
+// Generic Libraries
+//===============================================
+#include <cstdint>
+#include <utility>
+#include <vector>
+//===============================================
+using namespace std;
+//===============================================
+
+// monotone priority queue of integer keys for Dijkstra: a key pushed is never below the last
+// key popped, so an entry only moves to lower buckets and is moved at most 32 times
+// bucket 0 holds the keys equal to the last popped one, bucket i the keys whose highest bit
+// different from it is bit i - 1
+// there is no decrease-key, the search pushes again and skips the stale entries
+class RadixHeap
+{
+private:
+  static const int BUCKETS = 33;
+  vector <pair<uint32_t, unsigned int>> Buckets[BUCKETS]; // (key, vertex)
+  uint32_t Last;
+  size_t Size;
+
+  static int bucketOf(uint32_t Key, uint32_t Last);
+  //===============================================
+public:
+  RadixHeap();
+
+  void push(uint32_t Key, unsigned int Value);
+  // the entry of the smallest key, the heap must not be empty
+  pair<uint32_t, unsigned int> pop();
+  bool empty() const;
+  size_t size() const;
+  void clear();
+};
+
+#endif // RADIXHEAP_H
@@ -3,10 +3,12 @@
 
 #include <QGraphicsPolygonItem>
 #include <QGraphicsPathItem>
+#include <QPainterPath>
 #include <QGraphicsLayoutItem>
 #include <QPen>
 #include <QPainter>
 #include <vector>
+#include <algorithm>
 #include <string>
 #include "modelDataHandler.h"
 #include <QMouseEvent>
@@ -15,6 +17,17 @@
 #include <QGraphicsSceneContextMenuEvent>
 #include <QMenu>
 #include <iostream>
+#include <QStyleOptionGraphicsItem>
+#include "simplify.h"
+#include "labelengine.h"
+#include "rtree.h"
+
+// items smaller than this on the screen are not drawn at all
+#define MIN_POLYGON_PIXELS 2.0
+#define MIN_ROAD_PIXELS 1.0
+
+// scene units around the label positions still covered by the label layer
+#define LABEL_MARGIN 1000.0
 
 // use style reference from P0267_RefImpl, but not exactly the same
 static QColor getPolygonColor(polygonType type)
@@ -80,65 +93,250 @@ static float getPathWidth(roadType type)
     }
 }
 
-class Multipolygon : public QGraphicsItem
+// every way of one style in one cell of the map, a single item drawn with a single pen or brush
+// the roads of a level of detail are merged into one path, built the first time that level is drawn
+// the areas are filled one by one after one setBrush, merged in a path the overlapping outlines
+// would punch holes into each other
+class WayBatch : public QGraphicsItem
 {
+    // a ring of a multipolygon area is an entry of its own, after the first ring of the area
+    struct Way
+    {
+        idType id;
+        LevelOfDetail lod;  // level 0 is read from the geometry store of the model
+        QRectF bound;       // of the whole area for its rings
+        uint32_t rings;     // entries of the area starting here, 1 for a way, 0 for the next rings
+    };
+
+    vector<Way> m_ways;
+    size_t m_count;
+    bool m_closed;
+    QPen m_pen;
+    QBrush m_brush;
+    QRectF m_bound;
+    vector<QPainterPath> m_paths;   // roads only, one per level of detail, empty until drawn
 
-    polygonType m_PolygonType;    //this will determin the z-value
-    QColor m_brushColor;
-    idType m_wayId;
-    QPolygonF m_poly;
+    // ways under a pixel at the zoom levels using the level k are left out of it
+    static bool isTiny(const QRectF &bound, size_t k, double minPixels)
+    {
+        return max(bound.width(), bound.height()) < minPixels * 2 * LevelOfDetail::tolerance(k);
+    }
+
+    const QPainterPath &path(size_t k)
+    {
+        if(m_paths.size() <= k)
+            m_paths.resize(k + 1);
+        QPainterPath &path = m_paths[k];
+        if(path.isEmpty())
+        {
+            for(auto it = m_ways.begin(); it != m_ways.end(); it ++)
+            {
+                PointSpan line = it->lod.at(k);
+                if(line.size == 0 || isTiny(it->bound, k, MIN_ROAD_PIXELS))
+                    continue;
+                path.moveTo(line.data[0]);
+                for(int i = 1; i < line.size; i ++)
+                    path.lineTo(line.data[i]);
+            }
+        }
+        return path;
+    }
 
 public:
-    Multipolygon(){}
-    ~Multipolygon(){}
-    enum { Type = UserType + 1 };
+    enum { Type = UserType + 2 };
+
+    WayBatch(polygonType type) : m_count(0), m_closed(true), m_brush(getPolygonColor(type))
+    {
+        setZValue(type);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    }
+
+    WayBatch(roadType type) : m_count(0), m_closed(false)
+    {
+        m_pen.setBrush(getPathColor(type));
+        m_pen.setWidth(getPathWidth(type) + 3.0);
+        m_pen.setCapStyle(Qt::RoundCap);
+        setZValue(leisure + static_cast<int>(type) * 0.1);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    }
+
+    int type() const override
+    {
+        return Type;
+    }
+
+    // the points are not copied, they stay in the geometry store
+    void addWay(idType id, PointSpan points, const QRectF &bound)
+    {
+        if(points.size == 0)
+            return;
+        prepareGeometryChange();
+        m_ways.emplace_back(Way{id, LevelOfDetail(), bound, 1});
+        m_ways.back().lod.build(points, m_closed);
+        m_bound = m_bound.isNull() ? m_ways.back().bound : m_bound.united(m_ways.back().bound);
+        m_count ++;
+        m_paths.clear();
+    }
 
-    int type() const
+    // an area of a polygon batch, each ring is simplified on its own
+    void addArea(idType id, const vector<PointSpan> &rings, const QRectF &bound)
     {
-       // Enable the use of qgraphicsitem_cast with this item.
-       return Type;
+        if(rings.empty() || !m_closed)
+            return;
+        prepareGeometryChange();
+        for(size_t i = 0; i < rings.size(); i ++)
+        {
+            m_ways.emplace_back(Way{id, LevelOfDetail(), bound, i == 0 ? static_cast<uint32_t>(rings.size()) : 0});
+            m_ways.back().lod.build(rings[i], true);
+        }
+        m_bound = m_bound.isNull() ? bound : m_bound.united(bound);
+        m_count ++;
     }
+
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                QWidget *widget) override
     {
-        Q_UNUSED(option);
         Q_UNUSED(widget);
-        painter->setBrush(m_brushColor);
-        painter->drawPolygon(this->m_poly);
+        qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+        size_t k = LevelOfDetail::levelIndex(lod);
+        if(!m_closed)
+        {
+            painter->setPen(m_pen);
+            // a path is closed when filled, no brush of an earlier item may leak in
+            painter->setBrush(Qt::NoBrush);
+            painter->drawPath(path(k));
+            return;
+        }
+        painter->setBrush(m_brush);
+        for(auto it = m_ways.begin(); it != m_ways.end(); it += max(it->rings, 1u))
+        {
+            if(!it->bound.intersects(option->exposedRect))
+                continue;
+            if(LevelOfDetail::isEnabled() && max(it->bound.width(), it->bound.height()) * lod < MIN_POLYGON_PIXELS)
+                continue;
+            if(it->rings == 1)
+            {
+                PointSpan outline = it->lod.at(k);
+                painter->drawPolygon(outline.data, outline.size, Qt::OddEvenFill);
+                continue;
+            }
+            // a subpath per ring, the inner rings of a multipolygon are holes of the odd-even
+            // fill and the pen only follows the rings
+            QPainterPath area;
+            area.setFillRule(Qt::OddEvenFill);
+            for(auto ring = it; ring != it + it->rings; ring ++)
+            {
+                PointSpan outline = ring->lod.at(k);
+                if(outline.size == 0)
+                    continue;
+                area.moveTo(outline.data[0]);
+                for(int i = 1; i < outline.size; i ++)
+                    area.lineTo(outline.data[i]);
+                area.closeSubpath();
+            }
+            painter->drawPath(area);
+        }
     }
 
-    QRectF boundingRect() const
+    QRectF boundingRect() const override
     {
-        return m_poly.boundingRect();
+        qreal margin = m_pen.widthF() / 2;
+        return m_bound.adjusted(-margin, -margin, margin, margin);
     }
 
-    void setPolyType(polygonType type)
+    // an area counts once, whatever its number of rings
+    size_t wayCount() const
     {
+        return m_count;
+    }
+};
 
-        m_PolygonType = type;
-        m_brushColor = getPolygonColor(m_PolygonType);
+// the base map: every way batch in one item of the scene, indexed once by a packed R-tree
+// the batches are not items of the scene, the layer paints the ones under the exposed rect,
+// so the scene only indexes this item and the few overlays (pins, route, labels)
+class StaticLayer : public QGraphicsItem
+{
+    vector<WayBatch *> m_batches;   // owned, by increasing z-value after build()
+    RTree m_index;                  // ids are positions in m_batches
+    QRectF m_bound;
 
-        setZValue(type);
+public:
+    enum { Type = UserType + 3 };
+
+    StaticLayer()
+    {
+        setZValue(0);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
     }
-    void setId(idType id)
+
+    ~StaticLayer()
     {
-        m_wayId = id;
+        for(auto it = m_batches.begin(); it != m_batches.end(); it ++)
+            delete *it;
     }
 
-    idType getId()
+    int type() const override
     {
-        return m_wayId;
+        return Type;
+    }
+
+    void addBatch(WayBatch *batch)
+    {
+        m_batches.emplace_back(batch);
+    }
+
+    // sort the batches by z-value and index them, call it once every way is added
+    void build()
+    {
+        stable_sort(m_batches.begin(), m_batches.end(), [](WayBatch *a, WayBatch *b)
+        {
+            return a->zValue() < b->zValue();
+        });
+        vector<RTree::Entry> entries(m_batches.size());
+        for(size_t i = 0; i < m_batches.size(); i ++)
+        {
+            entries[i].box = m_batches[i]->boundingRect();
+            entries[i].id = i;
+        }
+        m_index.bulkLoad(std::move(entries));
+        prepareGeometryChange();
+        m_bound = m_index.bounds();
     }
-    void setPolygon(QPolygonF poly)
+
+    // batches whose box intersects the rect, from the bottom one to the top one
+    vector<WayBatch *> batchesIn(const QRectF &rect) const
     {
-        m_poly = poly;
+        vector<idType> ids = m_index.search(rect);
+        sort(ids.begin(), ids.end());
+        vector<WayBatch *> batches;
+        batches.reserve(ids.size());
+        for(auto it = ids.begin(); it != ids.end(); it ++)
+            batches.emplace_back(m_batches[*it]);
+        return batches;
     }
 
-    polygonType getPolyType()
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override
     {
-        return m_PolygonType;
+        vector<WayBatch *> batches = batchesIn(option->exposedRect);
+        for(auto it = batches.begin(); it != batches.end(); it ++)
+        {
+            // each batch starts from a clean painter, as the scene does for its items
+            painter->save();
+            (*it)->paint(painter, option, widget);
+            painter->restore();
+        }
     }
 
+    QRectF boundingRect() const override
+    {
+        return m_bound;
+    }
+
+    size_t batchCount() const
+    {
+        return m_batches.size();
+    }
 };
 
 class Road : public QGraphicsPolygonItem
@@ -147,6 +345,7 @@ class Road : public QGraphicsPolygonItem
     QColor m_RoadStyle;
     idType m_wayId;
     QPen m_pen;
+    LevelOfDetail m_lod;
 
 public:
     Road(){}
@@ -155,11 +354,22 @@ public:
     QWidget *widget) override
     {
 
-        Q_UNUSED(option)
         Q_UNUSED(widget)
+        qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+        QRectF bound = boundingRect();
+        if(LevelOfDetail::isEnabled() && max(bound.width(), bound.height()) * lod < MIN_ROAD_PIXELS)
+            return;
         m_pen.setCapStyle(Qt::RoundCap);
         painter->setPen(m_pen);
-        painter->drawPolyline(this->polygon());
+        PointSpan line = m_lod.level(lod);
+        painter->drawPolyline(line.data, line.size);
+    }
+
+    // hides QGraphicsPolygonItem::setPolygon, the simplified lines are built here
+    void setPolygon(const QPolygonF &line)
+    {
+        QGraphicsPolygonItem::setPolygon(line);
+        m_lod.build(line, false);
     }
     idType getId()
     {
@@ -179,6 +389,77 @@ public:
 
 };
 
+// every label of a LabelEngine in one item: the labels are placed again when the view or the zoom
+// changes, then only the placed ones are drawn, in pixels over the scene
+class LabelLayer : public QGraphicsItem
+{
+    LabelEngine *m_engine;
+    QRectF m_view;
+    QRectF m_placedView;
+    qreal m_placedScale;
+    vector<size_t> m_placed;
+    QRectF m_bound;
+
+public:
+    LabelLayer(LabelEngine *engine) : m_engine(engine), m_placedScale(0)
+    {
+        setZValue(100);
+    }
+
+    // the part of the scene shown in the view
+    void setView(const QRectF &view)
+    {
+        m_view = view;
+        update();
+    }
+
+    // call it when labels are added or removed
+    void invalidate()
+    {
+        prepareGeometryChange();
+        m_bound = m_engine->bounds().adjusted(-LABEL_MARGIN, -LABEL_MARGIN, LABEL_MARGIN, LABEL_MARGIN);
+        m_placedScale = 0;
+        update();
+    }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+        QTransform transform = painter->worldTransform();
+        qreal scale = transform.m11();
+        if(scale != m_placedScale || m_view != m_placedView)
+        {
+            m_placed = m_engine->place(m_view, scale);
+            m_placedScale = scale;
+            m_placedView = m_view;
+        }
+
+        painter->save();
+        painter->resetTransform();
+        painter->setPen(QColor(40, 40, 40));
+        for(auto it = m_placed.begin(); it != m_placed.end(); it ++)
+        {
+            const QStaticText &text = m_engine->layout(*it);
+            QSizeF size = text.size();
+            painter->setFont(m_engine->font(*it));
+            painter->drawStaticText(transform.map(m_engine->label(*it).pos) - QPointF(size.width() / 2, size.height() / 2), text);
+        }
+        painter->restore();
+    }
+
+    QRectF boundingRect() const override
+    {
+        return m_bound;
+    }
+
+    size_t placedCount() const
+    {
+        return m_placed.size();
+    }
+};
+
 // this class is used to draw a pin on the selected item
 class Pin : public QGraphicsItem
 {
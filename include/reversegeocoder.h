@@ -0,0 +1,89 @@
+#ifndef REVERSEGEOCODER_H
+#define REVERSEGEOCODER_H
+
+#include <string>
+#include <vector>
+#include <QPointF>
+#include <QPolygonF>
+#include "rtree.h"
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// what is at a position: the nearest named place, the smallest area containing it and the
+// nearest named street, each one from its own R-tree
+// it keeps its own copy of the geometry and is never modified after build(), so any number
+// of threads can query it at the same time
+class ReverseGeocoder
+{
+public:
+    struct Feature
+    {
+        idType id = 0;          // 0 when nothing was found
+        string name;
+        string type;
+        double distance = 0;    // in meters on the ground, 0 inside an area
+    };
+
+    struct Result
+    {
+        Feature poi;
+        Feature area;
+        Feature street;
+    };
+
+    ReverseGeocoder(){}
+
+    void clear();
+
+    void addPoi(idType id, const string &name, const string &type, QPointF pos);
+
+    void addArea(idType id, const string &name, const string &type, const QPolygonF &outline);
+
+    void addStreet(idType id, const string &name, const string &type, const QPolygonF &line);
+
+    // bulk load the three R-trees, call it once every feature is added
+    void build();
+
+    // position in scene coordinates, places and streets farther than maxDistance meters are ignored
+    Result lookup(QPointF pos, double maxDistance = 500) const;
+
+    Result lookup(const osmium::Location &location, double maxDistance = 500) const;
+
+    // one result per position, in the same order, the positions are shared between threads
+    // (threads = 0 uses every core)
+    vector<Result> lookup(const vector<QPointF> &positions, double maxDistance = 500, unsigned threads = 0) const;
+
+    size_t poiCount() const;
+
+    size_t areaCount() const;
+
+    size_t streetCount() const;
+
+private:
+    struct Info
+    {
+        idType id;
+        string name;
+        string type;
+    };
+
+    vector<Info> m_poiInfo;
+    vector<QPointF> m_poiPositions;
+    vector<Info> m_areaInfo;
+    vector<QPolygonF> m_areaOutlines;
+    vector<Info> m_streetInfo;
+    vector<QPolygonF> m_streetLines;
+    RTree m_poiIndex;       // ids of the R-trees are positions in the vectors above
+    RTree m_areaIndex;
+    RTree m_streetIndex;
+
+    static Feature feature(const Info &info, double distance);
+
+    static double distanceToLine(QPointF pos, const QPolygonF &line);
+
+    // meters on the ground per scene unit at a scene position (web mercator stretches with the latitude)
+    static double groundScale(QPointF pos);
+};
+
+#endif // REVERSEGEOCODER_H
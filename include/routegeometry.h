@@ -0,0 +1,48 @@
+#ifndef ROUTEGEOMETRY_H
+#define ROUTEGEOMETRY_H
+
+// Generic Libraries
+//===============================================
+#include <ostream>
+#include <vector>
+// Qt Libraries
+//===============================================
+#include <QPointF>
+// Deng Libraries
+//===============================================
+#include <modelDataStructure.h>
+#include <RenderEnum.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// a route as it is drawn and sent, filled while the path is unpacked:
+// one entry per point in nodes, points and distance, one entry per segment in ways and roads
+struct RouteGeometry
+{
+  vector<idType> nodes;     // OSM nodes of the points
+  vector<QPointF> points;   // projected, in scene units
+  vector<double> distance;  // meters from the start, 0 at the first point
+  vector<idType> ways;      // way of the segment from point i to point i + 1
+  vector<roadType> roads;   // road class of that way
+
+  // consecutive segments on the same way, what a turn-by-turn list shows
+  struct Step
+  {
+    idType way;
+    roadType road;
+    size_t first;           // first point of the step
+    size_t last;            // last point, the first one of the next step
+    double length;          // meters
+  };
+
+  bool empty() const;
+  // meters
+  double length() const;
+  vector<Step> steps() const;
+  void clear();
+  // one JSON object with the points in scene units and the steps, for the clients of the route
+  void writeJson(ostream &out) const;
+};
+
+#endif // ROUTEGEOMETRY_H
@@ -0,0 +1,44 @@
+#ifndef ROUTINGPROFILE_H
+#define ROUTINGPROFILE_H
+
+// Generic Libraries
+//===============================================
+#include <string>
+#include <vector>
+// Deng Libraries
+//===============================================
+#include <modelDataStructure.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// the ways a route can take and how fast, one profile per mode
+enum travelMode { CarMode, BicycleMode, FootMode };
+#define MODE_COUNT 3
+
+// what a profile makes of a way, from its tags
+struct WayAccess
+{
+  bool forward;   // along the nodes of the way
+  bool backward;  // against them
+  double speed;   // km/h
+};
+
+// highway class, oneway, access and maxspeed rules of the mode
+// a way the mode can't take is closed both ways
+WayAccess wayAccess(travelMode, const vector<tagPair> &);
+
+bool isRoutable(travelMode, const vector<tagPair> &);
+
+// milliseconds added for a turn of that many degrees, 0 straight on and 180 for a U-turn
+unsigned int turnPenalty(travelMode, double);
+
+// whether a type=restriction relation applies to the mode ("except", "restriction:bicycle"...),
+// and its value ("no_left_turn", "only_straight_on"...)
+bool restrictionFor(travelMode, const vector<tagPair> &, string &);
+
+const char *modeName(travelMode);
+// "car", "bicycle" or "foot", false for anything else
+bool modeFromName(const string &, travelMode &);
+
+#endif // ROUTINGPROFILE_H
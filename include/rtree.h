@@ -0,0 +1,157 @@
+#ifndef RTREE_H
+#define RTREE_H
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <cstdint>
+#include <QPointF>
+#include <QRectF>
+#include "modelDataStructure.h"
+
+using namespace std;
+
+// static R-tree packed in one pass along a Hilbert curve
+// it is built once when the file is loaded and never modified afterwards,
+// so all the nodes are stored in flat arrays instead of being allocated one by one
+class RTree
+{
+public:
+    struct Entry
+    {
+        QRectF box;
+        idType id;
+    };
+
+    RTree(){}
+
+    // sort the entries by the Hilbert value of their center and pack them bottom-up
+    void bulkLoad(vector<Entry> entries);
+
+    void clear();
+
+    size_t size() const;
+
+    bool empty() const;
+
+    QRectF bounds() const;
+
+    // all entries whose box intersects the rect
+    void search(const QRectF &rect, vector<idType> &result) const;
+
+    vector<idType> search(const QRectF &rect) const;
+
+    // all entries whose box contains the point
+    void searchPoint(QPointF pos, vector<idType> &result) const;
+
+    // k entries with the nearest box to the point, nearest first
+    vector<idType> nearest(QPointF pos, size_t k) const;
+
+    // visit the entries by increasing distance between the point and their box,
+    // the visitor gets (id, squared box distance) and returns false to stop
+    template <typename Visitor>
+    void visitNearest(QPointF pos, Visitor visit) const;
+
+    // same, but the nodes and entries farther than the distance are never looked at
+    template <typename Visitor>
+    void visitNearest(QPointF pos, double maxDistance, Visitor visit) const;
+
+private:
+    static const unsigned NODE_SIZE = 16;
+
+    struct Box
+    {
+        double minX, minY, maxX, maxY;
+
+        bool intersects(const Box &o) const
+        {
+            return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+        }
+
+        bool contains(double x, double y) const
+        {
+            return minX <= x && x <= maxX && minY <= y && y <= maxY;
+        }
+
+        double distance2(double x, double y) const
+        {
+            double dx = x < minX ? minX - x : (x > maxX ? x - maxX : 0);
+            double dy = y < minY ? minY - y : (y > maxY ? y - maxY : 0);
+            return dx * dx + dy * dy;
+        }
+
+        void expand(const Box &o)
+        {
+            if(o.minX < minX) minX = o.minX;
+            if(o.minY < minY) minY = o.minY;
+            if(o.maxX > maxX) maxX = o.maxX;
+            if(o.maxY > maxY) maxY = o.maxY;
+        }
+    };
+
+    // children of a leaf node are in m_items, the others are in m_nodes
+    struct Node
+    {
+        Box box;
+        uint32_t first;
+        uint32_t last;
+        bool leaf;
+    };
+
+    vector<Box> m_itemBoxes;
+    vector<idType> m_itemIds;
+    vector<Node> m_nodes;       // the root is the last node
+
+    static Box toBox(const QRectF &rect);
+
+    static uint32_t hilbert(uint32_t x, uint32_t y);
+};
+
+template <typename Visitor>
+void RTree::visitNearest(QPointF pos, Visitor visit) const
+{
+    visitNearest(pos, numeric_limits<double>::infinity(), visit);
+}
+
+template <typename Visitor>
+void RTree::visitNearest(QPointF pos, double maxDistance, Visitor visit) const
+{
+    if(m_nodes.empty())
+        return;
+
+    // (distance, index), an index >= m_nodes.size() refers to an item
+    typedef pair<double, size_t> queued;
+    priority_queue<queued, vector<queued>, greater<queued>> queue;
+    const size_t itemOffset = m_nodes.size();
+    const double x = pos.x();
+    const double y = pos.y();
+    const double max2 = maxDistance * maxDistance;
+    auto push = [&](double distance2, size_t index)
+    {
+        if(distance2 <= max2)
+            queue.push(queued(distance2, index));
+    };
+
+    push(m_nodes.back().box.distance2(x, y), m_nodes.size() - 1);
+    while(!queue.empty())
+    {
+        queued top = queue.top();
+        queue.pop();
+        if(top.second >= itemOffset)
+        {
+            if(!visit(m_itemIds[top.second - itemOffset], top.first))
+                return;
+            continue;
+        }
+        const Node &node = m_nodes[top.second];
+        for(uint32_t i = node.first; i < node.last; i ++)
+        {
+            if(node.leaf)
+                push(m_itemBoxes[i].distance2(x, y), itemOffset + i);
+            else
+                push(m_nodes[i].box.distance2(x, y), i);
+        }
+    }
+}
+
+#endif // RTREE_H
@@ -3,25 +3,39 @@
 
 #include <mygraphbuilder.h>
 #include <myalgorithm.h>
+#include <turnalgorithm.h>
+#include <weightoverlay.h>
 #include <model.h>
 
 class ShortPath
 {
 private:
   vector <idType> mypath;
+  RouteGeometry myroute;
   idType Source_ID,Destination_ID;
+  travelMode Mode;
   Model OurModel;
+  // the node itself when a road of the mode goes through it, else the closest road node
+  idType snapNode(idType);
+  // the search itself, over the edges when there is a turn graph
+  void findRoute(MyGraphBuilder const&, vector<costType> const&, TurnGraph const*);
 public:
   ShortPath();//Default Constructor
-  ShortPath(idType,idType,Model);//Parameters Constructor
+  // with the turn restrictions and turn costs by default, over the vertices without them
+  ShortPath(idType,idType,Model,travelMode = CarMode,bool = true);//Parameters Constructor
+  // on a graph built once, with the weights of a version of its overlay
+  ShortPath(idType,idType,Model,MyGraphBuilder const&,WeightSet const&,TurnGraph const*,travelMode = CarMode);
   ~ShortPath();//Destructor
 
   //------------------------------------------
   //Accessors
   Path getYourPath();
+  // the path with its points, ways and distances, empty when there is none
+  RouteGeometry const& getYourRoute() const;
   Model getModel();
   idType getSource();
   idType getDestination();
+  travelMode getMode();
   //------------------------------------------
   //Mutators
   void setMyPath(Path);
@@ -0,0 +1,58 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <vector>
+#include <QPolygonF>
+#include "geometrystore.h"
+
+using namespace std;
+
+// Douglas-Peucker: the vertices closer than tolerance to the simplified line are dropped
+// the first and last points are always kept, a closed ring keeps at least 4 points
+QPolygonF simplifyDouglasPeucker(const QPolygonF &line, double tolerance, bool closed);
+
+QPolygonF simplifyDouglasPeucker(PointSpan line, double tolerance, bool closed);
+
+// one geometry at several resolutions, computed once when the item is built
+// level k is simplified with a tolerance of LOD_BASE_TOLERANCE * 4^(k-1) scene units,
+// level 0 is the full resolution, kept as a copy or read from a GeometryStore
+class LevelOfDetail
+{
+    QPolygonF m_copy;               // level 0 when built from a polygon
+    PointSpan m_full;               // level 0 when built from shared points
+    vector<QPolygonF> m_levels;     // levels 1 and up
+
+    void simplify(bool closed);
+
+public:
+    LevelOfDetail(){}
+
+    void build(const QPolygonF &line, bool closed);
+
+    // the points are not copied, they must stay in place as long as this object
+    void build(PointSpan line, bool closed);
+
+    // the coarsest level whose error stays under half a pixel,
+    // lod is the number of pixels per scene unit (QStyleOptionGraphicsItem::levelOfDetailFromTransform)
+    PointSpan level(qreal lod) const;
+
+    // level k, or the coarsest one when this geometry has less levels
+    PointSpan at(size_t k) const;
+
+    // the level level() would pick for this number of pixels per scene unit
+    static size_t levelIndex(qreal lod);
+
+    // largest error of level k, in scene units
+    static double tolerance(size_t k);
+
+    PointSpan full() const;
+
+    size_t levelCount() const;
+
+    // to compare with the full resolution, every item draws level 0 when it is disabled
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled();
+};
+
+#endif // SIMPLIFY_H
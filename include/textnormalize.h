@@ -0,0 +1,11 @@
+#ifndef TEXTNORMALIZE_H
+#define TEXTNORMALIZE_H
+
+#include <string>
+
+// lower case, accents folded (é -> e, œ -> oe, ß -> ss) and punctuation turned into single spaces,
+// so "Rue de l'Église" and "rue de l eglise" give the same key
+// characters outside of latin-1 are kept as they are
+std::string normalizeText(const std::string &text);
+
+#endif // TEXTNORMALIZE_H
@@ -0,0 +1,147 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "rtree.h"
+#include "simplify.h"
+#include "model.h"
+
+using namespace std;
+
+// side of a tile in pixels
+#define TILE_SIZE 256
+#define MAX_TILE_ZOOM 20
+
+struct TileKey
+{
+    int z;
+    int x;
+    int y;
+
+    bool operator==(const TileKey &o) const
+    {
+        return z == o.z && x == o.x && y == o.y;
+    }
+};
+
+struct TileKeyHash
+{
+    size_t operator()(const TileKey &key) const
+    {
+        return (static_cast<size_t>(key.z) << 58) ^ (static_cast<size_t>(key.x) << 29) ^ static_cast<size_t>(key.y);
+    }
+};
+
+// raster tiles of the map, z/x/y over the web mercator square like the usual slippy maps
+// the tiles are rendered by worker threads into QImage with QPainter (no GPU, no scene),
+// from the geometry store of the model and the simplified levels made by build(), the model
+// must not be loaded again while the workers run (clear() stops them)
+// the rendered tiles are kept in a LRU bounded in bytes, and in a directory when one is set
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    // memoryLimit in bytes, threads = 0 uses every core but one (kept for the GUI)
+    TileCache(size_t memoryLimit = 256 << 20, unsigned threads = 0);
+
+    ~TileCache();
+
+    // styles and simplified levels of the ways of the model, the tiles of the previous file are dropped
+    void build(Model &model);
+
+    void clear();
+
+    // tiles are also read from and written to dir/z/x/y.png, an empty dir disables it
+    void setDiskCache(const QString &dir);
+
+    // the tile in the memory cache, a null image when it is not rendered yet
+    QImage tile(const TileKey &key);
+
+    // queue the missing tiles of the view at the zoom of the scale, then the tiles around it,
+    // what was queued for the previous view and not started yet is dropped
+    void request(const QRectF &view, qreal scale);
+
+    // render one tile on the calling thread, without the cache
+    QImage render(const TileKey &key) const;
+
+    // block until every queued tile is rendered
+    void waitForIdle();
+
+    size_t memoryUsed();
+
+    size_t tileCount();
+
+    // the zoom whose tiles are drawn at a scale (pixels per scene unit) equal or above it
+    static int zoomFor(qreal scale);
+
+    static QRectF tileRect(const TileKey &key);
+
+    static vector<TileKey> tilesIn(const QRectF &rect, int z);
+
+signals:
+    // emitted from a worker thread, connect it with a queued connection
+    void tileReady(int z, int x, int y);
+
+private:
+    struct Shape
+    {
+        bool closed;
+        double z;           // same z-value as the items of the scene
+        QColor color;
+        float width;        // pen width of the roads, in scene units
+        QRectF bound;
+        LevelOfDetail lod;  // level 0 in the geometry store of the model
+        uint32_t rings;     // shapes of the area starting here, 1 for a way, 0 for the next rings
+    };
+
+    struct Entry
+    {
+        QImage image;
+        list<TileKey>::iterator position;
+    };
+
+    vector<Shape> m_shapes;
+    RTree m_index;          // ids are positions in m_shapes, the first ring of an area only
+
+    size_t m_memoryLimit;
+    size_t m_memory;
+    list<TileKey> m_lru;    // most recently used first
+    unordered_map<TileKey, Entry, TileKeyHash> m_tiles;
+
+    deque<TileKey> m_queue;     // the view first, then the prefetched tiles
+    unordered_set<TileKey, TileKeyHash> m_rendering;
+    QString m_diskCache;
+
+    unsigned m_threadCount;
+    vector<thread> m_workers;
+    bool m_stop;
+    size_t m_busy;
+    mutex m_mutex;
+    condition_variable m_wake;
+    condition_variable m_idle;
+
+    void startWorkers();
+
+    void stopWorkers();
+
+    void work();
+
+    // m_mutex must be held
+    void insert(const TileKey &key, const QImage &image);
+
+    QString diskPath(const TileKey &key) const;
+};
+
+#endif // TILECACHE_H
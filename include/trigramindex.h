@@ -0,0 +1,39 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+// inverted index from every 3 bytes sequence to the documents containing it,
+// used to answer substring queries without scanning the whole catalog
+class TrigramIndex
+{
+    // document ids, sorted and unique
+    unordered_map<uint32_t, vector<uint32_t>> m_postings;
+    uint32_t m_docCount;
+
+    static uint32_t trigram(const string &text, size_t pos);
+
+public:
+    TrigramIndex();
+
+    void clear();
+
+    // documents must be added with increasing ids, a document can have several strings
+    void add(uint32_t doc, const string &text);
+
+    // documents that contain every trigram of the query, sorted by id
+    // they still have to be checked with string::find, the trigrams may not be contiguous
+    // return false if the query is shorter than 3 bytes, then every document is a candidate
+    bool candidates(const string &query, vector<uint32_t> &result) const;
+
+    size_t trigramCount() const;
+
+    size_t documentCount() const;
+};
+
+#endif // TRIGRAMINDEX_H
@@ -0,0 +1,49 @@
+#ifndef TURNALGORITHM_H
+#define TURNALGORITHM_H
+
+// Generic Libraries
+//===============================================
+#include <vector>
+//===============================================
+#include <turngraph.h>
+#include <routegeometry.h>
+#include <radixheap.h>
+#include <myalgorithm.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// Dijkstra over the edges of the graph with the turn restrictions and turn costs of a profile:
+// a label is an edge reached with its cost, a step is a turn into an out edge of its target
+// the labels are one cost and one predecessor per edge, the turns are read from the graph
+class TurnAlgorithm
+{
+private:
+  TurnGraph const* Turns;
+  vector <costType> const* Weights;
+  travelMode Mode;
+  vector <costType> distances;        // cost of the routes ending with each edge
+  vector <unsigned int> predecessors; // edge before each edge, NoEdge for the first one
+  RadixHeap Queue;
+  unsigned int Last;                  // last edge of the route, NoEdge when there is none
+  unsigned int Source;                // vertex of a route of no edge
+  bool Reached;                       // the last search found a route, maybe of no edge
+  size_t Settled;
+  //===============================================
+public:
+  static const unsigned int NoEdge = UINT32_MAX;
+  // the turn graph and the weights must outlive the algorithm
+  TurnAlgorithm(TurnGraph const&, vector<costType> const&, travelMode);
+
+  // the cost of the best route, COST_INFINITE when there is none
+  // a destination of 0 searches the whole graph, to measure a search from one source to all
+  costType run(GraphMap const&, idType, idType);
+  //===============================================
+  //Accessors
+  Path getShortPath() const;
+  RouteGeometry getRoute() const;
+  // edges the last search settled
+  size_t getSettledCount() const;
+};
+
+#endif // TURNALGORITHM_H
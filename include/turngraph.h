@@ -0,0 +1,52 @@
+#ifndef TURNGRAPH_H
+#define TURNGRAPH_H
+
+// Generic Libraries
+//===============================================
+#include <vector>
+#include <utility>
+//===============================================
+#include <mygraphbuilder.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// the turns of a graph of MyGraphBuilder, for a search over its edges instead of its vertices
+// the edge-expanded graph is never stored: the turns out of an edge are the out edges of its
+// target, read from the graph during the search, and only what can't be read there is kept
+// here, the direction of every edge and the forbidden turns of each profile
+// the graph must outlive it
+class TurnGraph
+{
+private:
+  const graph_t *Graph;
+  vector <Edge> Edges;    // by EdgeInfo::index, the two directions of a segment are 2k and 2k + 1
+  vector <float> Bearing; // direction of each edge, radians
+  // (from edge, to edge) sorted, and the edges with at least one of them in the list
+  vector <pair<unsigned int, unsigned int>> Forbidden[MODE_COUNT];
+  vector <bool> Restricted[MODE_COUNT];
+  size_t Unsupported;     // restrictions with a via way or with members off the graph
+
+  void addRestriction(travelMode, GraphMap const&, relationData const&, string const&);
+  //===============================================
+public:
+  TurnGraph();
+  // the graph of the builder, and the type=restriction relations of the model
+  void build(graph_t const&, GraphMap const&, Model &);
+  //===============================================
+  //Accessors
+  graph_t const& getGraph() const;
+  Edge const& getEdge(unsigned int) const;
+  size_t getEdgeCount() const;
+  bool isForbidden(travelMode, unsigned int, unsigned int) const;
+  // milliseconds of the turn from the first edge into the second
+  costType turnCost(travelMode, unsigned int, unsigned int) const;
+  size_t getRestrictionCount(travelMode) const;
+  size_t getUnsupportedCount() const;
+  // bytes held here, the graph itself not counted
+  size_t memoryUsed() const;
+  // turns the edge-expanded graph would store, one per pair of edges meeting at a vertex
+  size_t getTurnCount() const;
+};
+
+#endif // TURNGRAPH_H
@@ -0,0 +1,93 @@
+#ifndef WEIGHTOVERLAY_H
+#define WEIGHTOVERLAY_H
+
+// Generic Libraries
+//===============================================
+#include <atomic>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+//===============================================
+#include <mygraphbuilder.h>
+//===============================================
+using namespace std;
+//===============================================
+
+// one update: the edges of the way cost factor times their weight in the graph, or are closed
+// the factor is not cumulative, 1 gives the way its weight back
+struct WeightUpdate
+{
+  idType way;
+  double factor;
+  bool closed;
+};
+
+// the weights of every profile as one query sees them
+struct WeightSet
+{
+  unsigned long long version;
+  vector<costType> weights[MODE_COUNT];
+};
+
+// closures and traffic over the weights of a graph of MyGraphBuilder, without building it again
+// two weight sets: the queries read the published one, apply() writes the other in place (only
+// the edges of the ways updated, through a way -> edges index) then publishes it, so a query
+// holding a snapshot sees one version from start to end
+// the previous version becomes the one written next, it is copied whole only when a query
+// still holds it: each set counts its readers, a snapshot takes the published set and counts
+// itself under one lock and gives it back with a release, the writer checks with an acquire
+//
+// update files, one per line, # starts a comment:
+//   <way id> <factor>     1.5 for a road 50% slower
+//   <way id> closed
+//   <way id> open         same as a factor of 1
+class WeightOverlay
+{
+private:
+  vector <costType> Base[MODE_COUNT];   // weights of the graph
+  // the edges of Ways[i] are WayEdges[First[i]] to WayEdges[First[i + 1] - 1]
+  vector <idType> Ways;
+  vector <unsigned int> First;
+  vector <unsigned int> WayEdges;
+  struct Buffer
+  {
+    WeightSet set;
+    atomic<unsigned int> readers;       // snapshots not released yet
+    Buffer() : readers(0) {}
+  };
+  std::shared_ptr<Buffer> Front;        // the published set, changed under Publish
+  std::shared_ptr<Buffer> Back;
+  mutable mutex Publish;
+  vector <unsigned int> Stale;          // edges of Back older than Front
+  mutex Writer;
+  size_t Unknown;
+  //===============================================
+public:
+  WeightOverlay();
+  // the way index and the weights of the builder, the overlay starts without update
+  void build(MyGraphBuilder const&);
+
+  // the current version, to keep for the whole query
+  std::shared_ptr<const WeightSet> snapshot() const;
+
+  // apply the updates over the base weights and publish the result, returns the updates applied
+  size_t apply(vector<WeightUpdate> const&);
+  // the updates of a stream or a file in the format above, the malformed lines are skipped
+  size_t load(istream &);
+  bool loadFile(string const&);
+  static bool parseLine(string const&, WeightUpdate &);
+
+  // every way back to its weight in the graph
+  void reset();
+  //===============================================
+  //Accessors
+  // updates of the last apply() for ways not in the graph
+  size_t getUnknownCount() const;
+  size_t getWayCount() const;
+  // edges of a way, nullptr when there is none
+  unsigned int const* getWayEdges(idType, size_t &) const;
+};
+
+#endif // WEIGHTOVERLAY_H
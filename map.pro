@@ -11,28 +11,70 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000
 
 SOURCES += \
     src/SceneBuilder.cpp \
+    src/addressindex.cpp \
+    src/chunkstore.cpp \
+    src/distancematrix.cpp \
+    src/fuzzyindex.cpp \
+    src/geometrystore.cpp \
+    src/isochrone.cpp \
+    src/labelengine.cpp \
     src/main.cpp \
     src/mainwindow.cpp \
     src/mapview.cpp \
     src/modeldata.cpp \
+    src/multipolygon.cpp \
+    src/prefixindex.cpp \
     src/projection.cpp \
+    src/radixheap.cpp \
+    src/reversegeocoder.cpp \
+    src/rtree.cpp \
+    src/simplify.cpp \
+    src/textnormalize.cpp \
+    src/tilecache.cpp \
+    src/trigramindex.cpp \
+    src/turnalgorithm.cpp \
+    src/turngraph.cpp \
+    src/weightoverlay.cpp \
     src/myalgorithm.cpp \
     src/mygraphbuilder.cpp \
+    src/routegeometry.cpp \
+    src/routingprofile.cpp \
     src/shortpath.cpp
 
 HEADERS += \
     include/RenderEnum.h \
     include/SceneBuilder.h \
+    include/addressindex.h \
+    include/chunkstore.h \
+    include/distancematrix.h \
+    include/fuzzyindex.h \
+    include/geometrystore.h \
+    include/isochrone.h \
+    include/labelengine.h \
     include/mainwindow.h \
     include/mapview.h \
     include/model.h \
     include/modelDataHandler.h \
     include/modelDataStructure.h \
     include/modeldata.h \
+    include/multipolygon.h \
     include/myalgorithm.h \
     include/mygraphbuilder.h \
+    include/prefixindex.h \
     include/projection.h \
+    include/radixheap.h \
     include/renderitem.h \
+    include/reversegeocoder.h \
+    include/routegeometry.h \
+    include/routingprofile.h \
+    include/rtree.h \
+    include/simplify.h \
+    include/textnormalize.h \
+    include/tilecache.h \
+    include/trigramindex.h \
+    include/turnalgorithm.h \
+    include/turngraph.h \
+    include/weightoverlay.h \
     include/shortpath.h
 
 FORMS += \
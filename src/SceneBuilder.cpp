@@ -1,52 +1,60 @@
 #include "SceneBuilder.h"
+#include <cmath>
 
-// created a multi-polygon from the "way" data in osm, they are basically buildings or aeras
-void SceneBuilder::buildMutipolygon(wayData way, idType wayId)
+// the ways are not items of their own: each one goes to the batch of its style (road or polygon type)
+// and of the cell of its center, a batch is drawn with one pen or brush
+void SceneBuilder::buildWay(const wayData &way, idType wayId)
 {
-    QPolygonF polygon;
-    auto nodeRefList = way.nodeRefList;
-    // build a multi-polygon from the OSM way data
-    for(vector<idType>::iterator it = nodeRefList.begin();it != nodeRefList.end();it++)
-    {
-        auto point = projection(m_model->getNodeLoaction(*(it)).lon(), m_model->getNodeLoaction(*(it)).lat());
-        polygon << point;
-    }
-    Multipolygon *polyItem = new Multipolygon;
-
-    polyItem->setId(wayId);
-    polyItem->setPolygon(polygon);
-    polyItem->setPolyType(way.pType);
-    m_polygonList.emplace_back(polyItem);
-    m_scene->addItem(polyItem);
+    // the points are read from the geometry store of the model, projected once at loading
+    const GeometryStore &geometry = m_model->getGeometry();
+    PointSpan points = geometry.points(wayId);
+    if(points.size == 0)
+        return;
+    QRectF bound = geometry.bounds(wayId);
+    WayBatch *batch = getBatch(way.isPolygon, way.isPolygon ? static_cast<int>(way.pType) : static_cast<int>(way.rType), bound.center());
+    batch->addWay(wayId, points, bound);
+    m_wayItems[wayId] = batch;
 }
 
-void SceneBuilder::buildRoad(wayData way, idType wayId)
+// the rings of the relation go to the batch of the ways of the same style, drawn as the
+// subpaths of one odd-even fill, the holes stay empty
+void SceneBuilder::buildArea(idType relationId, polygonType type)
 {
-    QPolygonF polyLine;
-    auto nodeRefList = way.nodeRefList;
-    // build a multi-polygon from the OSM way data
-    for(vector<idType>::iterator it = nodeRefList.begin();it != nodeRefList.end();it++)
-    {
-        auto point = projection(m_model->getNodeLoaction(*(it)).lon(), m_model->getNodeLoaction(*(it)).lat());
-        polyLine << point;
-    }
-    Road *roadItem = new Road;
-    roadItem->setId(wayId);
-    roadItem->setPenStyle(way.rType);
-    roadItem->setPolygon(polyLine);
-    m_RoadList.emplace_back(roadItem);
-    m_scene->addItem(roadItem);
+    const GeometryStore &geometry = m_model->getGeometry();
+    idType key = GeometryStore::areaKey(relationId);
+    vector<PointSpan> rings = geometry.rings(key);
+    if(rings.empty())
+        return;
+    QRectF bound = geometry.bounds(key);
+    getBatch(true, type, bound.center())->addArea(key, rings, bound);
 }
 
+WayBatch *SceneBuilder::getBatch(bool isPolygon, int type, QPointF center)
+{
+    auto key = make_tuple(isPolygon, type, static_cast<int>(floor(center.x() / BATCH_CELL)), static_cast<int>(floor(center.y() / BATCH_CELL)));
+    auto it = m_batches.find(key);
+    if(it != m_batches.end())
+        return it->second;
+    WayBatch *batch = isPolygon ? new WayBatch(static_cast<polygonType>(type)) : new WayBatch(static_cast<roadType>(type));
+    m_batches[key] = batch;
+    staticLayer()->addBatch(batch);
+    return batch;
+}
 
 SceneBuilder::SceneBuilder(Model *model)
 {
     m_scene = new QGraphicsScene;
+    // the base map is one item with its own static index (StaticLayer), the rest are a few
+    // overlays, a BSP tree of the scene would only be rebuilt for nothing as they are added
+    m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
     m_model = model;
     m_route = nullptr;
     m_dest = nullptr;
     m_source = nullptr;
-
+    m_showBatches = true;
+    m_labelLayer = nullptr;
+    m_staticLayer = nullptr;
+    m_chunks = nullptr;
 }
 
 SceneBuilder::~SceneBuilder()
@@ -56,25 +64,47 @@ SceneBuilder::~SceneBuilder()
 
 void SceneBuilder::clear()
 {
+    // the overlays are items of the scene too, they go with it
     m_scene->clear();
+    m_scene->setSceneRect(QRectF());
+    m_batches.clear();
+    m_staticLayer = nullptr;
+    m_labels.clear();
+    m_labelLayer = nullptr;
+    m_route = nullptr;
+    m_isochrones.clear();
+    m_source = nullptr;
+    m_dest = nullptr;
+    m_pinContainer.clear();
+    m_wayItems.clear();
+    m_viewRect = QRectF();
+    m_chunkLayers.clear();
+    if(m_chunks != nullptr)
+    {
+        disconnect(m_chunks, &ChunkStore::chunkEvicted, this, &SceneBuilder::removeChunk);
+        m_chunks = nullptr;
+    }
 }
 
 void SceneBuilder::addAllItem()
 {
     addPolyItem();
     addRoadItem();
+    staticLayer()->build();
+    m_scene->setSceneRect(m_staticLayer->boundingRect());
 }
 
 void SceneBuilder::addPolyItem()
 {
-    auto wayMap = m_model->getWayMap();
-    map<idType, wayData>::iterator it;
-    for(it = wayMap.begin(); it != wayMap.end(); it++)
+    const map<idType, wayData> wayMap = m_model->getWayMap();
+    for(auto it = wayMap.begin(); it != wayMap.end(); it++)
     {
-        auto way = it -> second;
-        if(way.isPolygon)
-            buildMutipolygon(way, it -> first );
+        if(it->second.isPolygon)
+            buildWay(it->second, it->first);
     }
+    const map<idType, polygonType> areaMap = m_model->getAreaMap();
+    for(auto it = areaMap.begin(); it != areaMap.end(); it ++)
+        buildArea(it->first, it->second);
 }
 
 QGraphicsScene* SceneBuilder::getScene()
@@ -82,24 +112,29 @@ QGraphicsScene* SceneBuilder::getScene()
     return m_scene;
 }
 
+StaticLayer *SceneBuilder::staticLayer()
+{
+    if(m_staticLayer == nullptr)
+    {
+        m_staticLayer = new StaticLayer;
+        m_staticLayer->setVisible(m_showBatches);
+        m_scene->addItem(m_staticLayer);
+    }
+    return m_staticLayer;
+}
+
 void SceneBuilder::addRoadItem()
 {
-    auto wayMap = m_model->getWayMap();
-    map<idType, wayData>::iterator it;
-    for(it = wayMap.begin(); it != wayMap.end(); it++)
+    const map<idType, wayData> wayMap = m_model->getWayMap();
+    for(auto it = wayMap.begin(); it != wayMap.end(); it++)
     {
-        auto way = it -> second;
-        if(!way.isPolygon)
-            buildRoad(way, it->first);
+        if(!it->second.isPolygon)
+            buildWay(it->second, it->first);
     }
 }
 
 void SceneBuilder::drawRoute(std::vector<idType> refList)
 {
-    if(m_route == nullptr)
-        m_route = new Road;
-    else
-        m_route->setVisible(true);
     QPolygonF polyLine;
     for(vector<idType>::iterator it = refList.begin();it != refList.end();it++)
     {
@@ -107,38 +142,124 @@ void SceneBuilder::drawRoute(std::vector<idType> refList)
         auto point = projection(m_model->getNodeLoaction(*(it)).lon(), m_model->getNodeLoaction(*(it)).lat());
         polyLine << point;
     }
+    showRoute(polyLine);
+}
+
+void SceneBuilder::drawRoute(const RouteGeometry &route)
+{
+    QPolygonF polyLine;
+    polyLine.reserve(route.points.size());
+    for(auto it = route.points.begin(); it != route.points.end(); it ++)
+        polyLine << *it;
+    showRoute(polyLine);
+}
+
+void SceneBuilder::drawIsochrones(const vector<vector<QPolygonF>> &outlines)
+{
+    deleteContainer(m_isochrones);
+    for(size_t i = 0; i < outlines.size(); i ++)
+    {
+        QPainterPath path;
+        path.setFillRule(Qt::OddEvenFill);
+        for(auto ring = outlines[i].begin(); ring != outlines[i].end(); ring ++)
+            path.addPolygon(*ring);
+        // green for the smallest budget to red for the largest, the smaller ones on top
+        int hue = outlines.size() > 1 ? int(120 * (outlines.size() - 1 - i) / (outlines.size() - 1)) : 120;
+        QGraphicsPathItem *item = new QGraphicsPathItem(path);
+        item->setBrush(QColor::fromHsv(hue, 200, 220, 70));
+        item->setPen(Qt::NoPen);
+        // inside (150, 190] whatever the number of budgets, under the route at 200
+        item->setZValue(150 + 40.0 * (outlines.size() - i) / outlines.size());
+        m_scene->addItem(item);
+        m_isochrones.push_back(item);
+    }
+}
 
+void SceneBuilder::showRoute(const QPolygonF &polyLine)
+{
+    if(m_route == nullptr)
+    {
+        m_route = new Road;
+        // temporary z-value to make sure the route stays at the top of the view
+        m_route->setPenStyle(Route);
+        m_route->setZValue(200);
+        m_scene->addItem(m_route);
+    }
+    else
+        m_route->setVisible(true);
     m_route->setPolygon(polyLine);
-    // temporary z-value to make sure the route stays at the top of the view
-    m_route->setPenStyle(Route);
-    m_route->setZValue(200);
-    m_scene->addItem(m_route);
+
+    // the map along the whole route is read, not only the part in the view
+    if(m_chunks != nullptr)
+    {
+        vector<QPointF> line(polyLine.begin(), polyLine.end());
+        vector<int> ids = m_chunks->requestCorridor(line, ROUTE_CORRIDOR);
+        for(auto it = ids.begin(); it != ids.end(); it ++)
+            addChunkLayer(*it);
+    }
+}
+
+// importance of a named node, and the scale from which it can be shown
+static int labelPriority(const vector<tagPair> &tags, qreal &minScale)
+{
+    static const map<string, pair<int, qreal>> places = {
+        {"city", {100, 0}}, {"town", {90, 0.001}}, {"village", {80, 0.004}}, {"suburb", {70, 0.004}},
+        {"hamlet", {60, 0.01}}, {"neighbourhood", {60, 0.01}}, {"locality", {50, 0.01}}
+    };
+    for(auto it = tags.begin(); it != tags.end(); it ++)
+    {
+        if(it->first != "place")
+            continue;
+        auto place = places.find(it->second);
+        if(place != places.end())
+        {
+            minScale = place->second.second;
+            return place->second.first;
+        }
+    }
+    for(auto it = tags.begin(); it != tags.end(); it ++)
+    {
+        if(it->first == "amenity" || it->first == "shop" || it->first == "tourism" || (it->first == "railway" && it->second == "station"))
+        {
+            minScale = 0.02;
+            return 40;
+        }
+    }
+    minScale = 0.04;
+    return 20;
 }
 
 void SceneBuilder::drawPointText()
 {
-    auto nodeMap = m_model->getNodeMap();
-    for(auto it = nodeMap.begin();it != nodeMap.end();it ++)
+    m_labels.clear();
+    const map<idType, nodeData> nodeMap = m_model->getNodeMap();
+    for(auto it = nodeMap.begin(); it != nodeMap.end(); it ++)
     {
-        auto node = it -> second;
-        auto tagList = node.tagList;
-        for(const auto &tag:tagList)
+        const vector<tagPair> &tagList = it->second.tagList;
+        for(auto tag = tagList.begin(); tag != tagList.end(); tag ++)
         {
-            if(tag.first == "name")
+            if(tag->first == "name")
             {
-                QGraphicsTextItem *Text = new QGraphicsTextItem;
-//                    QGraphicsEllipseItem *Point = new QGraphicsEllipseItem;
-                string name = tag.second;
-                Text->setPlainText(QString::fromStdString(name));
-                auto geoPos = m_model->getNodeLoaction(it -> first);
-                auto pos = projection(geoPos.lon(), geoPos.lat());
-                Text->setPos(pos);
-                Text->setZValue(100);
-                m_textContainer.emplace_back(Text);
-                m_scene->addItem(Text);
+                qreal minScale;
+                int priority = labelPriority(tagList, minScale);
+                m_labels.addLabel(QString::fromStdString(tag->second), projection(m_model->getNodeLoaction(it->first)), priority, minScale);
+                break;
             }
         }
     }
+    m_labels.build();
+    labelLayer()->invalidate();
+}
+
+LabelLayer *SceneBuilder::labelLayer()
+{
+    if(m_labelLayer == nullptr)
+    {
+        m_labelLayer = new LabelLayer(&m_labels);
+        m_labelLayer->setView(m_viewRect);
+        m_scene->addItem(m_labelLayer);
+    }
+    return m_labelLayer;
 }
 
 //void SceneBuilder::cancelRoute()
@@ -146,34 +267,24 @@ void SceneBuilder::drawPointText()
 //    m_route->setVisible(false);
 //}
 
-void SceneBuilder::setSource(Multipolygon *item)
+void SceneBuilder::setSource(idType wayId)
 {
 
-    QPointF centerPos = item->boundingRect().center();
+    QPointF centerPos = m_model->getWayCentroid(wayId);
 
-    m_source = new Pin(item->getId(), Pin::pinType::source);
+    m_source = new Pin(wayId, Pin::pinType::source);
     m_source->setPos(centerPos);
-
-    auto rect = m_scene->sceneRect();
-
     m_scene->addItem(m_source);
-
-    m_scene->setSceneRect(rect);
     std::cout << "setSource slot connected" << std::endl;
 }
 
-void SceneBuilder::setDest(Multipolygon *item)
+void SceneBuilder::setDest(idType wayId)
 {
-    QPointF centerPos = item->boundingRect().center();
+    QPointF centerPos = m_model->getWayCentroid(wayId);
 
-    m_dest = new Pin(item->getId(), Pin::pinType::dest);
+    m_dest = new Pin(wayId, Pin::pinType::dest);
     m_dest->setPos(centerPos);
-
-    auto rect = m_scene->sceneRect();
-
     m_scene->addItem(m_dest);
-
-    m_scene->setSceneRect(rect);
     std::cout << "setDestination slot connected" << std::endl;
 }
 
@@ -185,68 +296,58 @@ bool SceneBuilder::searchPlace(QString name)
     // get a list of catagory data
     string key = name.toLower().toStdString();
 
-    vector<catagoryData> resultType;
+    // the places in the view closest to its center, or the closest ones to the view
+    QRectF area = m_viewRect.isEmpty() ? m_model->getBounds() : m_viewRect;
+    vector<catagoryData> result = m_model->searchAmenityInRect(key, area, SEARCH_RESULTS);
+    if(result.size() == 0)
+        result = m_model->searchAmenityNear(key, area.center(), numeric_limits<double>::infinity(), SEARCH_RESULTS);
 
-    if(m_model->isAmenityTypeExist(key))
+    // nothing matches exactly, try again with typos
+    if(result.size() == 0)
     {
-        resultType = m_model->searchAmenityByType(key);
+        result = m_model->searchAmenityFuzzy(key);
+        if(result.size() > SEARCH_RESULTS)
+            result.resize(SEARCH_RESULTS);
     }
 
-    vector<catagoryData> resultName = m_model->searchAmenityByName(key);
-
-    vector<catagoryData> result = resultType;
-
-    result.insert(result.end(), resultName.begin(), resultName.end());
-
     // check if it is empty
     if(result.size() == 0)
         return false;
     else
     {
+        // avoid drawing multiple text and pin on the same polygon
+        unordered_set<idType> pinned;
+        for(auto pin = m_pinContainer.begin(); pin != m_pinContainer.end(); pin ++)
+            pinned.insert((*pin)->getId());
+
         for(auto it = result.begin(); it != result.end(); it ++)
         {
+            QPointF center;
+            idType pinId;
             if(it->itemType == osmium::item_type::node)
             {
+                // pin the polygon the node is in
                 auto geoPos = this->m_model->getNodeLoaction(it->id);
-                auto pos = projection(geoPos.lon(), geoPos.lat());
-                auto item = m_scene->itemAt(pos, QTransform());
-                if(qgraphicsitem_cast<Multipolygon *>(item))
-                {
-                    auto casted = qgraphicsitem_cast<Multipolygon *>(item);
-
-                    // avoid drawing multiple text and pin
-                    auto test = m_scene->itemAt(item->boundingRect().center(), QTransform());
-                    if(qgraphicsitem_cast<Multipolygon *>(test))
-                    {
-                        drawPin(casted->getId(), casted->boundingRect().center());
-                        if(it->name.size() != 0)
-                            drawText(it->name[0], item->boundingRect().center());
-                        else if(it->type.size() != 0)
-                            drawText(it->type, item->boundingRect().center());
-                    }
-                }
+                pinId = m_model->searchPolygonAt(projection(geoPos.lon(), geoPos.lat()));
+                if(pinId == 0)
+                    continue;
+                center = m_model->getWayCentroid(pinId);
             }
             else
             {
-                auto way = this->m_model->getWayData(it->id);
-                QPolygonF tempPoly;
-                auto nodeRefList = way.nodeRefList;
-                for(vector<idType>::iterator it = nodeRefList.begin();it != nodeRefList.end();it++)
-                {
-                    auto point = projection(m_model->getNodeLoaction(*(it)));
-                    tempPoly << point;
-                }
-
-                auto test = m_scene->itemAt(tempPoly.boundingRect().center(), QTransform());
-                if(qgraphicsitem_cast<Multipolygon *>(test))
-                {
-                    drawPin(it->id, tempPoly.boundingRect().center());
-                    if(it->name.size() != 0)
-                        drawText(it->name[0], tempPoly.boundingRect().center());
-                    else if(it->type.size() != 0)
-                        drawText(it->type, tempPoly.boundingRect().center());
-                }
-                //drawText();
+                pinId = it->id;
+                center = m_model->getWayCentroid(pinId);
+                if(m_model->searchPolygonAt(center) == 0)
+                    continue;
+            }
+
+            if(pinned.insert(pinId).second)
+            {
+                drawPin(pinId, center);
+                if(it->name.size() != 0)
+                    drawText(it->name[0], center);
+                else if(it->type.size() != 0)
+                    drawText(it->type, center);
             }
         }
         return true;
@@ -268,12 +369,15 @@ void SceneBuilder::cancel()
         m_dest = nullptr;
     }
     deleteContainer(m_pinContainer);
-    deleteContainer(m_textContainer);
+    m_labels.clearTemporary();
+    if(m_labelLayer != nullptr)
+        m_labelLayer->invalidate();
     if(m_route != nullptr)
     {
         delete m_route;
         m_route = nullptr;
     }
+    deleteContainer(m_isochrones);
 
     std::cout << "cancel slot connected" << std::endl;
 }
@@ -293,6 +397,111 @@ void SceneBuilder::slotDrawRoute(vector<idType> route)
     this->drawRoute(route);
 }
 
+idType SceneBuilder::polygonAt(QPointF pos)
+{
+    return m_model->searchPolygonAt(pos);
+}
+
+polygonType SceneBuilder::polygonTypeOf(idType wayId)
+{
+    if(m_wayItems.find(wayId) == m_wayItems.end())
+        return invalid;
+    return m_model->getWayData(wayId).pType;
+}
+
+size_t SceneBuilder::batchCount() const
+{
+    return m_batches.size();
+}
+
+void SceneBuilder::setBatchesVisible(bool visible)
+{
+    m_showBatches = visible;
+    if(m_staticLayer != nullptr)
+        m_staticLayer->setVisible(visible);
+    for(auto it = m_chunkLayers.begin(); it != m_chunkLayers.end(); it ++)
+    {
+        for(auto layer = it->second.begin(); layer != it->second.end(); layer ++)
+            (*layer)->setVisible(visible);
+    }
+}
+
+void SceneBuilder::setChunkStore(ChunkStore *store)
+{
+    clear();
+    m_chunks = store;
+    if(m_chunks == nullptr)
+        return;
+    // the evicted chunks are removed before their points are freed, on the same thread
+    connect(m_chunks, &ChunkStore::chunkEvicted, this, &SceneBuilder::removeChunk, Qt::DirectConnection);
+    m_scene->setSceneRect(m_chunks->bounds());
+}
+
+size_t SceneBuilder::chunkLayerCount() const
+{
+    return m_chunkLayers.size();
+}
+
+void SceneBuilder::addChunkLayer(int id)
+{
+    const ChunkStore::Chunk *chunk = m_chunks->chunk(id);
+    if(chunk == nullptr || m_chunkLayers.find(id) != m_chunkLayers.end())
+        return;
+    // the chunk is the cell, the ways are only batched by style
+    map<pair<bool, int>, WayBatch *> batches;
+    for(auto it = chunk->ways.begin(); it != chunk->ways.end(); it ++)
+    {
+        WayBatch *&batch = batches[make_pair(it->isPolygon, static_cast<int>(it->type))];
+        if(batch == nullptr)
+            batch = it->isPolygon ? new WayBatch(static_cast<polygonType>(it->type)) : new WayBatch(static_cast<roadType>(it->type));
+        batch->addWay(it->id, chunk->geometry.points(it->id), chunk->geometry.bounds(it->id));
+    }
+    // a layer per z-value of the batches at that z-value, the scene stacks them with the layers
+    // of the other chunks instead of a whole chunk over the ones read before
+    map<qreal, StaticLayer *> layers;
+    for(auto it = batches.begin(); it != batches.end(); it ++)
+    {
+        StaticLayer *&layer = layers[it->second->zValue()];
+        if(layer == nullptr)
+            layer = new StaticLayer;
+        layer->addBatch(it->second);
+    }
+    vector<StaticLayer *> &items = m_chunkLayers[id];
+    for(auto it = layers.begin(); it != layers.end(); it ++)
+    {
+        it->second->build();
+        it->second->setZValue(it->first);
+        it->second->setVisible(m_showBatches);
+        m_scene->addItem(it->second);
+        items.push_back(it->second);
+    }
+}
+
+void SceneBuilder::removeChunk(int id)
+{
+    auto it = m_chunkLayers.find(id);
+    if(it == m_chunkLayers.end())
+        return;
+    for(auto layer = it->second.begin(); layer != it->second.end(); layer ++)
+        delete *layer;
+    m_chunkLayers.erase(it);
+}
+
+void SceneBuilder::cullToViewport(QRectF rect)
+{
+    m_viewRect = rect;
+    if(m_labelLayer != nullptr)
+        m_labelLayer->setView(rect);
+
+    // page in the chunks under the view, the store evicts the old ones through removeChunk
+    if(m_chunks != nullptr && !rect.isEmpty())
+    {
+        vector<int> ids = m_chunks->request(rect);
+        for(auto it = ids.begin(); it != ids.end(); it ++)
+            addChunkLayer(*it);
+    }
+}
+
 template<typename T>
 void SceneBuilder::deleteContainer(T &vp)
 {
@@ -308,17 +517,9 @@ void SceneBuilder::deleteContainer(T &vp)
 
 void SceneBuilder::drawText(string text, QPointF pos)
 {
-    QGraphicsTextItem *temp = new QGraphicsTextItem;
-    temp->setPlainText(QString::fromStdString(text));
-    temp->setPos(pos);
-
-    QFont f;
-    f.setPointSizeF(16.0);
-    temp->setFont(f);
-    temp->setZValue(50);
-    temp->setFlag(QGraphicsItem::ItemIgnoresTransformations,true);
-    m_scene->addItem(temp);
-    m_textContainer.emplace_back(temp);
+    // shown before any other label, until cancel
+    m_labels.addTemporary(QString::fromStdString(text), pos);
+    labelLayer()->invalidate();
 }
 
 void SceneBuilder::drawPin(idType id, QPointF pos)
@@ -326,12 +527,8 @@ void SceneBuilder::drawPin(idType id, QPointF pos)
     Pin *temp = new Pin(id);
 
     temp->setPos(pos);
-    auto rect = m_scene->sceneRect();
-
     m_scene->addItem(temp);
     m_pinContainer.emplace_back(temp);
-
-    m_scene->setSceneRect(rect);
 }
 
 
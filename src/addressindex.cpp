@@ -0,0 +1,244 @@
+#include "addressindex.h"
+#include "textnormalize.h"
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+
+void AddressIndex::clear()
+{
+    m_addresses.clear();
+    m_streets.clear();
+    m_streetIds.clear();
+}
+
+string AddressIndex::streetKey(const string &street)
+{
+    static const unordered_map<string, string> abbreviations = {
+        {"av", "avenue"}, {"ave", "avenue"}, {"bd", "boulevard"}, {"bld", "boulevard"},
+        {"ch", "chemin"}, {"imp", "impasse"}, {"pl", "place"}, {"rte", "route"},
+        {"sq", "square"}, {"st", "saint"}, {"ste", "sainte"}
+    };
+    istringstream words(normalizeText(street));
+    string key, w;
+    while(words >> w)
+    {
+        auto it = abbreviations.find(w);
+        if(!key.empty())
+            key += ' ';
+        key += it != abbreviations.end() ? it->second : w;
+    }
+    return key;
+}
+
+string AddressIndex::numberKey(const string &number)
+{
+    string key;
+    string normalized = normalizeText(number);
+    for(auto it = normalized.begin(); it != normalized.end(); it ++)
+    {
+        if(*it != ' ')
+            key.push_back(*it);
+    }
+    return key;
+}
+
+uint32_t AddressIndex::streetId(const string &key, const string &name, QPointF position)
+{
+    auto it = m_streetIds.find(key);
+    if(it != m_streetIds.end())
+        return it->second;
+    uint32_t id = m_streets.size();
+    m_streetIds[key] = id;
+    m_streets.push_back(Street{name, position, unordered_map<string, vector<uint32_t>>()});
+    return id;
+}
+
+void AddressIndex::addAddress(const Address &address)
+{
+    string key = streetKey(address.street);
+    string number = numberKey(address.housenumber);
+    if(key.empty() || number.empty())
+        return;
+    uint32_t id = streetId(key, address.street, address.position);
+    m_streets[id].numbers[number].emplace_back(m_addresses.size());
+    m_addresses.emplace_back(address);
+}
+
+void AddressIndex::addStreet(const string &name, QPointF position)
+{
+    string key = streetKey(name);
+    if(key.empty())
+        return;
+    // the street itself is a better position than the first address found on it
+    uint32_t id = streetId(key, name, position);
+    m_streets[id].position = position;
+}
+
+static bool isDigits(const string &word)
+{
+    for(auto it = word.begin(); it != word.end(); it ++)
+    {
+        if(!isdigit(static_cast<unsigned char>(*it)))
+            return false;
+    }
+    return !word.empty();
+}
+
+// "12", "12b", "3" followed by a suffix word
+static bool isNumber(const string &word)
+{
+    return !word.empty() && word.size() <= 5 && isdigit(static_cast<unsigned char>(word[0]));
+}
+
+static bool isNumberSuffix(const string &word)
+{
+    return word == "bis" || word == "ter" || word == "quater" || (word.size() == 1 && word[0] >= 'a' && word[0] <= 'h');
+}
+
+AddressIndex::Query AddressIndex::parse(const string &query)
+{
+    Query q;
+    vector<string> words;
+    istringstream stream(normalizeText(query));
+    string w;
+    while(stream >> w)
+        words.emplace_back(w);
+
+    // the postcode ends the street, what comes after it is the city
+    size_t end = words.size();
+    for(size_t i = 1; i < words.size(); i ++)
+    {
+        if(words[i].size() == 5 && isDigits(words[i]))
+        {
+            q.postcode = words[i];
+            end = i;
+            break;
+        }
+    }
+
+    // the number before the street ("12 bis rue x") or after it ("rue x 12")
+    size_t begin = 0;
+    if(begin < end && isNumber(words[begin]))
+    {
+        q.housenumber = words[begin ++];
+        if(begin < end - 1 && isNumberSuffix(words[begin]))
+            q.housenumber += words[begin ++];
+    }
+    else if(end > 1 && isNumber(words[end - 1]))
+        q.housenumber = words[-- end];
+    else if(end > 2 && isNumberSuffix(words[end - 1]) && isNumber(words[end - 2]))
+    {
+        q.housenumber = words[end - 2] + words[end - 1];
+        end -= 2;
+    }
+
+    string street;
+    for(size_t i = begin; i < end; i ++)
+    {
+        if(!street.empty())
+            street += ' ';
+        street += words[i];
+    }
+    q.street = streetKey(street);
+    return q;
+}
+
+AddressIndex::Result AddressIndex::result(const Street &street, const vector<uint32_t> &candidates, const Query &query, bool exact) const
+{
+    Result r;
+    r.found = true;
+    r.exactNumber = exact;
+    r.label = street.name;
+    r.position = street.position;
+    if(candidates.empty())
+    {
+        if(!query.postcode.empty())
+            r.label += " " + query.postcode;
+        return r;
+    }
+
+    // the same street name can exist in several towns, the postcode decides
+    uint32_t best = candidates.front();
+    for(auto it = candidates.begin(); it != candidates.end(); it ++)
+    {
+        if(!query.postcode.empty() && m_addresses[*it].postcode == query.postcode)
+        {
+            best = *it;
+            break;
+        }
+    }
+    const Address &address = m_addresses[best];
+    r.label = address.housenumber + " " + address.street;
+    if(!address.postcode.empty())
+        r.label += " " + address.postcode;
+    r.position = address.position;
+    r.address = address.id;
+    return r;
+}
+
+AddressIndex::Result AddressIndex::lookup(const string &query) const
+{
+    Query q = parse(query);
+
+    // the city may follow the street without a postcode, drop the last words until a street is known
+    string key = q.street;
+    auto street = m_streetIds.end();
+    while(!key.empty())
+    {
+        street = m_streetIds.find(key);
+        if(street != m_streetIds.end())
+            break;
+        size_t space = key.rfind(' ');
+        key = space == string::npos ? string() : key.substr(0, space);
+    }
+    if(street == m_streetIds.end())
+        return Result();
+
+    const Street &s = m_streets[street->second];
+    if(q.housenumber.empty())
+    {
+        // any address with the postcode, or the street itself
+        if(!q.postcode.empty())
+        {
+            for(auto it = s.numbers.begin(); it != s.numbers.end(); it ++)
+            {
+                for(auto a = it->second.begin(); a != it->second.end(); a ++)
+                {
+                    if(m_addresses[*a].postcode == q.postcode)
+                        return result(s, vector<uint32_t>(1, *a), q, false);
+                }
+            }
+        }
+        return result(s, vector<uint32_t>(), q, false);
+    }
+
+    auto number = s.numbers.find(numberKey(q.housenumber));
+    if(number != s.numbers.end())
+        return result(s, number->second, q, true);
+
+    // unknown number, the closest one on the same side of the street (same parity) if possible
+    long wanted = strtol(q.housenumber.c_str(), nullptr, 10);
+    const vector<uint32_t> *closest = nullptr;
+    long bestScore = 0;
+    for(auto it = s.numbers.begin(); it != s.numbers.end(); it ++)
+    {
+        long n = strtol(it->first.c_str(), nullptr, 10);
+        long score = 2 * labs(n - wanted) + ((n - wanted) % 2 != 0 ? 1 : 0);
+        if(closest == nullptr || score < bestScore)
+        {
+            closest = &it->second;
+            bestScore = score;
+        }
+    }
+    return result(s, closest == nullptr ? vector<uint32_t>() : *closest, q, false);
+}
+
+const vector<AddressIndex::Address> &AddressIndex::addresses() const
+{
+    return m_addresses;
+}
+
+size_t AddressIndex::streetCount() const
+{
+    return m_streets.size();
+}
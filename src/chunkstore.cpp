@@ -0,0 +1,472 @@
+#include "chunkstore.h"
+#include "modelDataHandler.h"
+#include "projection.h"
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/visitor.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <QDir>
+#include <QFile>
+#include <fstream>
+#include <algorithm>
+#include <unordered_set>
+#include <map>
+#include <cstring>
+#include <cmath>
+
+static const char CHUNK_MAGIC[8] = {'M', 'A', 'P', 'C', 'H', 'N', 'K', '1'};
+// id, area flag, style and point count in front of the points of a way
+static const size_t WAY_HEADER = sizeof(uint64_t) + 2 * sizeof(uint8_t) + sizeof(uint32_t);
+// records of the import buffered in memory before they go to the files of their cells
+static const size_t CHUNK_IMPORT_BUFFER = 64 << 20;
+
+template <typename T>
+static void writeValue(ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static T readValue(const char *&p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+template <typename T>
+static bool readValue(istream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+static void appendValue(vector<char> &out, const T &value)
+{
+    const char *p = reinterpret_cast<const char *>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+static string cellPath(const string &cellDir, int32_t cellX, int32_t cellY)
+{
+    return cellDir + "/" + to_string(cellX) + "_" + to_string(cellY) + ".tmp";
+}
+
+// groups the ways by the cell of their center as the reader gives them, with the locations of
+// their nodes filled by NodeLocationsForWays: the records of each cell are buffered and appended
+// to a file of the cell when the buffers pass CHUNK_IMPORT_BUFFER, so only the table of the cells
+// stays in memory and the ways of a cell keep the order of the file
+class ChunkImporter : public osmium::handler::Handler
+{
+public:
+    struct Cell
+    {
+        uint64_t bytes;
+        uint32_t ways;
+        QRectF box;
+        vector<char> pending;
+    };
+
+    // by cellX then cellY, the order of the chunks
+    map<pair<int32_t, int32_t>, Cell> cells;
+    bool failed;
+
+    ChunkImporter(const string &cellDir, double chunkSize) : failed(false), m_cellDir(cellDir), m_chunkSize(chunkSize), m_pending(0) {}
+
+    void way(const osmium::Way &way)
+    {
+        if(way.id() < 0)
+            return;
+        wayData data;
+        data.isClosed = way.is_closed();
+        m_tags.clear();
+        modelDataHandler::getTagsAndType(m_tags, way.tags(), data);
+
+        // nodes outside of the extract have no location
+        m_points.clear();
+        for(const auto &node : way.nodes())
+        {
+            if(node.location().valid())
+                m_points.emplace_back(projection(node.location()));
+        }
+        if(m_points.empty())
+            return;
+
+        double minX = m_points[0].x(), maxX = minX, minY = m_points[0].y(), maxY = minY;
+        for(auto it = m_points.begin(); it != m_points.end(); it ++)
+        {
+            minX = min(minX, it->x());
+            maxX = max(maxX, it->x());
+            minY = min(minY, it->y());
+            maxY = max(maxY, it->y());
+        }
+        QRectF box(QPointF(minX, minY), QPointF(maxX, maxY));
+        pair<int32_t, int32_t> key(static_cast<int32_t>(floor(box.center().x() / m_chunkSize)),
+                                   static_cast<int32_t>(floor(box.center().y() / m_chunkSize)));
+        size_t bytes = WAY_HEADER + m_points.size() * sizeof(QPointF);
+
+        auto found = cells.find(key);
+        if(found == cells.end())
+            found = cells.emplace(key, Cell{0, 0, box, vector<char>()}).first;
+        Cell &cell = found->second;
+        cell.bytes += bytes;
+        cell.ways ++;
+        cell.box = cell.box.united(box);
+
+        vector<char> &out = cell.pending;
+        appendValue(out, static_cast<uint64_t>(way.id()));
+        appendValue(out, static_cast<uint8_t>(data.isPolygon));
+        appendValue(out, static_cast<uint8_t>(data.isPolygon ? static_cast<int>(data.pType) : static_cast<int>(data.rType)));
+        appendValue(out, static_cast<uint32_t>(m_points.size()));
+        const char *points = reinterpret_cast<const char *>(m_points.data());
+        out.insert(out.end(), points, points + m_points.size() * sizeof(QPointF));
+        m_pending += bytes;
+        if(m_pending > CHUNK_IMPORT_BUFFER)
+            flush();
+    }
+
+    // append the buffered records to the files of their cells
+    void flush()
+    {
+        for(auto it = cells.begin(); it != cells.end(); it ++)
+        {
+            vector<char> &pending = it->second.pending;
+            if(pending.empty())
+                continue;
+            ofstream out(cellPath(m_cellDir, it->first.first, it->first.second), ios::binary | ios::app);
+            if(!out.write(pending.data(), pending.size()))
+                failed = true;
+            vector<char>().swap(pending);
+        }
+        m_pending = 0;
+    }
+
+private:
+    string m_cellDir;
+    double m_chunkSize;
+    size_t m_pending;
+    vector<pair<string, string>> m_tags;
+    vector<QPointF> m_points;
+};
+
+ChunkStore::ChunkStore(size_t memoryLimit)
+{
+    m_memoryLimit = memoryLimit;
+    m_memory = 0;
+    m_reads = 0;
+}
+
+bool ChunkStore::import(const string &osmFile, const string &dir, double chunkSize)
+{
+    if(!QDir().mkpath(QString::fromStdString(dir)))
+        return false;
+    string nodePath = dir + "/nodes.tmp";
+    string cellDir = dir + "/cells.tmp";
+    QDir(QString::fromStdString(cellDir)).removeRecursively();
+    if(!QDir().mkpath(QString::fromStdString(cellDir)))
+        return false;
+
+    // pass over the file: the node locations go to a file, the ways to the files of their cells
+    map<pair<int32_t, int32_t>, ChunkImporter::Cell> cells;
+    {
+        QFile nodeFile(QString::fromStdString(nodePath));
+        if(!nodeFile.open(QIODevice::ReadWrite | QIODevice::Truncate))
+            return false;
+
+        using indexType = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+        indexType nodeIndex(nodeFile.handle());
+        osmium::handler::NodeLocationsForWays<indexType> locations(nodeIndex);
+        locations.ignore_errors();
+        ChunkImporter importer(cellDir, chunkSize);
+
+        osmium::io::File inputFile(osmFile);
+        osmium::io::Reader reader(inputFile, osmium::io::read_meta::no);
+        osmium::apply(reader, locations, importer);
+        reader.close();
+        importer.flush();
+        if(importer.failed)
+        {
+            QFile::remove(QString::fromStdString(nodePath));
+            QDir(QString::fromStdString(cellDir)).removeRecursively();
+            return false;
+        }
+        cells.swap(importer.cells);
+    }
+    QFile::remove(QString::fromStdString(nodePath));
+
+    // the files of the cells one after the other, each is read in order and only once
+    ofstream chunkFile(dir + "/chunks.bin", ios::binary | ios::trunc);
+    ofstream indexFile(dir + "/index.bin", ios::binary | ios::trunc);
+    if(!chunkFile || !indexFile)
+    {
+        QDir(QString::fromStdString(cellDir)).removeRecursively();
+        return false;
+    }
+
+    struct ChunkHeader
+    {
+        int32_t cellX, cellY;
+        uint64_t offset, bytes;
+        uint32_t ways;
+        QRectF box;
+    };
+    vector<ChunkHeader> chunks;
+    chunks.reserve(cells.size());
+    uint64_t offset = 0;
+    vector<char> buffer(1 << 20);
+    bool copied = true;
+    for(auto it = cells.begin(); it != cells.end() && copied; it ++)
+    {
+        string path = cellPath(cellDir, it->first.first, it->first.second);
+        ifstream cellFile(path, ios::binary);
+        uint64_t left = it->second.bytes;
+        while(left > 0 && cellFile)
+        {
+            size_t bytes = static_cast<size_t>(min<uint64_t>(left, buffer.size()));
+            cellFile.read(buffer.data(), bytes);
+            chunkFile.write(buffer.data(), cellFile.gcount());
+            left -= cellFile.gcount();
+        }
+        copied = left == 0;
+        cellFile.close();
+        QFile::remove(QString::fromStdString(path));
+        chunks.emplace_back(ChunkHeader{it->first.first, it->first.second, offset, it->second.bytes, it->second.ways, it->second.box});
+        offset += it->second.bytes;
+    }
+    QDir(QString::fromStdString(cellDir)).removeRecursively();
+    if(!copied)
+        return false;
+
+    indexFile.write(CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    writeValue(indexFile, chunkSize);
+    writeValue(indexFile, static_cast<uint32_t>(chunks.size()));
+    for(auto it = chunks.begin(); it != chunks.end(); it ++)
+    {
+        writeValue(indexFile, it->cellX);
+        writeValue(indexFile, it->cellY);
+        writeValue(indexFile, it->offset);
+        writeValue(indexFile, it->bytes);
+        writeValue(indexFile, it->ways);
+        writeValue(indexFile, it->box.left());
+        writeValue(indexFile, it->box.top());
+        writeValue(indexFile, it->box.right());
+        writeValue(indexFile, it->box.bottom());
+    }
+    return static_cast<bool>(chunkFile) && static_cast<bool>(indexFile);
+}
+
+bool ChunkStore::open(const string &dir)
+{
+    close();
+    ifstream in(dir + "/index.bin", ios::binary);
+    char magic[sizeof(CHUNK_MAGIC)];
+    double chunkSize;
+    uint32_t count;
+    if(!in.read(magic, sizeof(magic)) || memcmp(magic, CHUNK_MAGIC, sizeof(magic)) != 0
+            || !readValue(in, chunkSize) || !readValue(in, count))
+        return false;
+
+    m_chunks.resize(count);
+    vector<RTree::Entry> entries(count);
+    for(uint32_t i = 0; i < count; i ++)
+    {
+        Entry &chunk = m_chunks[i];
+        int32_t cellX, cellY;
+        double left, top, right, bottom;
+        if(!readValue(in, cellX) || !readValue(in, cellY) || !readValue(in, chunk.offset) || !readValue(in, chunk.bytes)
+                || !readValue(in, chunk.ways) || !readValue(in, left) || !readValue(in, top)
+                || !readValue(in, right) || !readValue(in, bottom))
+        {
+            m_chunks.clear();
+            return false;
+        }
+        chunk.box = QRectF(QPointF(left, top), QPointF(right, bottom));
+        chunk.memory = 0;
+        entries[i].box = chunk.box;
+        entries[i].id = i;
+    }
+    m_index.bulkLoad(std::move(entries));
+    m_bounds = m_index.bounds();
+    m_dir = dir;
+    return true;
+}
+
+void ChunkStore::close()
+{
+    for(auto it = m_lru.begin(); it != m_lru.end(); it ++)
+        emit chunkEvicted(*it);
+    m_lru.clear();
+    m_chunks.clear();
+    m_index.clear();
+    m_bounds = QRectF();
+    m_dir.clear();
+    m_memory = 0;
+    m_reads = 0;
+}
+
+bool ChunkStore::isOpen() const
+{
+    return !m_dir.empty();
+}
+
+QRectF ChunkStore::bounds() const
+{
+    return m_bounds;
+}
+
+vector<int> ChunkStore::request(const QRectF &rect)
+{
+    QRectF area = rect.adjusted(-rect.width() * CHUNK_MARGIN, -rect.height() * CHUNK_MARGIN,
+                                rect.width() * CHUNK_MARGIN, rect.height() * CHUNK_MARGIN);
+    vector<idType> ids = m_index.search(area);
+    // a view zoomed out can touch more chunks than the limit holds, the middle of it goes first
+    QPointF center = rect.center();
+    auto distance = [&](idType id)
+    {
+        QPointF d = m_chunks[id].box.center() - center;
+        return QPointF::dotProduct(d, d);
+    };
+    sort(ids.begin(), ids.end(), [&](idType a, idType b) { return distance(a) < distance(b); });
+    vector<int> loaded = touch(ids);
+    evict(loaded);
+    return loaded;
+}
+
+vector<int> ChunkStore::requestCorridor(const vector<QPointF> &line, double margin)
+{
+    // in the order of the line, a long route only gets its start when the limit is reached
+    vector<idType> ids, found;
+    vector<char> seen(m_chunks.size(), 0);
+    for(size_t i = 0; i < line.size(); i ++)
+    {
+        QPointF next = line[i + 1 < line.size() ? i + 1 : i];
+        QRectF box = QRectF(line[i], next).normalized().adjusted(-margin, -margin, margin, margin);
+        found.clear();
+        m_index.search(box, found);
+        for(auto it = found.begin(); it != found.end(); it ++)
+        {
+            if(!seen[*it])
+                ids.push_back(*it);
+            seen[*it] = 1;
+        }
+    }
+    vector<int> loaded = touch(ids);
+    evict(loaded);
+    return loaded;
+}
+
+const ChunkStore::Chunk *ChunkStore::chunk(int id) const
+{
+    if(id < 0 || static_cast<size_t>(id) >= m_chunks.size())
+        return nullptr;
+    return m_chunks[id].data.get();
+}
+
+QRectF ChunkStore::chunkBounds(int id) const
+{
+    return m_chunks.at(id).box;
+}
+
+void ChunkStore::setMemoryLimit(size_t bytes)
+{
+    m_memoryLimit = bytes;
+    evict(vector<int>());
+}
+
+size_t ChunkStore::memoryUsed() const
+{
+    return m_memory;
+}
+
+size_t ChunkStore::chunkCount() const
+{
+    return m_chunks.size();
+}
+
+size_t ChunkStore::loadedCount() const
+{
+    return m_lru.size();
+}
+
+size_t ChunkStore::readCount() const
+{
+    return m_reads;
+}
+
+bool ChunkStore::load(int id)
+{
+    Entry &entry = m_chunks[id];
+    vector<char> buffer(entry.bytes);
+    ifstream in(m_dir + "/chunks.bin", ios::binary);
+    in.seekg(entry.offset);
+    if(!in.read(buffer.data(), entry.bytes))
+        return false;
+
+    // the point count is known from the size, the buffer of the geometry never grows
+    unique_ptr<Chunk> chunk(new Chunk);
+    chunk->ways.reserve(entry.ways);
+    chunk->geometry.reserve(entry.ways, (entry.bytes - entry.ways * WAY_HEADER) / sizeof(QPointF));
+    const char *p = buffer.data();
+    for(uint32_t i = 0; i < entry.ways; i ++)
+    {
+        Way way;
+        way.id = readValue<uint64_t>(p);
+        way.isPolygon = readValue<uint8_t>(p) != 0;
+        way.type = readValue<uint8_t>(p);
+        uint32_t count = readValue<uint32_t>(p);
+        for(uint32_t k = 0; k < count; k ++)
+            chunk->geometry.addPoint(readValue<QPointF>(p));
+        chunk->geometry.finishWay(way.id, way.isPolygon);
+        chunk->ways.emplace_back(way);
+    }
+
+    entry.memory = sizeof(Chunk) + chunk->geometry.memory() + chunk->ways.capacity() * sizeof(Way);
+    entry.data = std::move(chunk);
+    m_memory += entry.memory;
+    m_lru.push_front(id);
+    entry.position = m_lru.begin();
+    m_reads ++;
+    return true;
+}
+
+void ChunkStore::evict(const vector<int> &keep)
+{
+    unordered_set<int> kept(keep.begin(), keep.end());
+    auto it = m_lru.end();
+    while(m_memory > m_memoryLimit && it != m_lru.begin())
+    {
+        -- it;
+        if(kept.find(*it) != kept.end())
+            continue;
+        Entry &entry = m_chunks[*it];
+        emit chunkEvicted(*it);
+        m_memory -= entry.memory;
+        entry.data.reset();
+        entry.memory = 0;
+        it = m_lru.erase(it);
+    }
+}
+
+vector<int> ChunkStore::touch(const vector<idType> &ids)
+{
+    vector<int> loaded;
+    loaded.reserve(ids.size());
+    size_t memory = 0;
+    for(auto it = ids.begin(); it != ids.end(); it ++)
+    {
+        int id = static_cast<int>(*it);
+        Entry &entry = m_chunks[id];
+        // a chunk not read yet takes about its size on disk, the points are stored the same way
+        size_t need = entry.data ? entry.memory : sizeof(Chunk) + entry.bytes;
+        if(!loaded.empty() && memory + need > m_memoryLimit)
+            break;
+        if(entry.data)
+            m_lru.splice(m_lru.begin(), m_lru, entry.position);
+        else if(!load(id))
+            continue;
+        memory += entry.memory;
+        loaded.push_back(id);
+    }
+    return loaded;
+}
@@ -0,0 +1,180 @@
+#include <distancematrix.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+//===============================================
+using namespace std;
+using namespace boost;
+//===============================================
+
+DistanceMatrix::DistanceMatrix() : Settled(0), TargetVertices(0) {}
+//================================================================
+// Matrix
+//================================================================
+void DistanceMatrix::compute(MyGraphBuilder const& Builder, vector<costType> const& Weights,
+                             vector<idType> const& AnySources, vector<idType> const& AnyTargets, unsigned int Threads) {
+  graph_t const& Graph = Builder.getGraph();
+  GraphMap const& AnyGraphMap = Builder.getGraphMap();
+  Sources = AnySources;
+  Targets = AnyTargets;
+  Times.assign(Sources.size() * Targets.size(), COST_INFINITE);
+  Meters.assign(Sources.size() * Targets.size(), 0);
+  Settled = 0;
+  //---------------------------------------------------
+  // the columns of each vertex, several targets can be the same node
+  size_t Vertices = num_vertices(Graph);
+  vector <unsigned int> Column(Targets.size(), UINT32_MAX);
+  TargetFirst.assign(Vertices + 1, 0);
+  for (size_t j = 0; j < Targets.size(); j++) {
+      auto Found = AnyGraphMap.find(Targets[j]);
+      if (Found == AnyGraphMap.end()) continue;
+      Column[j] = Found->second;
+      TargetFirst[Found->second + 1]++;
+    }
+  TargetVertices = 0;
+  for (size_t v = 0; v < Vertices; v++) {
+      if (TargetFirst[v + 1] != 0) TargetVertices++;
+      TargetFirst[v + 1] += TargetFirst[v];
+    }
+  TargetColumns.assign(TargetFirst[Vertices], 0);
+  vector <unsigned int> Next(TargetFirst.begin(), TargetFirst.end() - 1);
+  for (size_t j = 0; j < Targets.size(); j++)
+    if (Column[j] != UINT32_MAX) TargetColumns[Next[Column[j]]++] = j;
+  if (TargetVertices == 0 || Sources.empty())
+    return;
+  //---------------------------------------------------
+  if (Threads == 0)
+    Threads = max(1u, thread::hardware_concurrency());
+  Threads = min<size_t>(Threads, Sources.size());
+  // the searches differ a lot in cost, so the threads take the next source instead of a range
+  atomic<size_t> NextRow(0);
+  atomic<size_t> Total(0);
+  auto work = [&]() {
+    Search Labels;
+    Labels.distances.assign(Vertices, COST_INFINITE);
+    Labels.lengths.assign(Vertices, 0);
+    size_t Count = 0;
+    for (size_t Row = NextRow++; Row < Sources.size(); Row = NextRow++) {
+        auto Found = AnyGraphMap.find(Sources[Row]);
+        if (Found != AnyGraphMap.end())
+          Count += sweep(Graph, Weights, Found->second, Row, Labels);
+      }
+    Total += Count;
+  };
+  vector <thread> Workers;
+  for (unsigned int i = 1; i < Threads; i++)
+    Workers.emplace_back(work);
+  work();
+  for (auto it = Workers.begin(); it != Workers.end(); ++it)
+    it->join();
+  Settled = Total;
+  cout<<"\nDistance Matrix : \t"<<Sources.size()<<" x "<<Targets.size()<<", "<<Threads<<" threads"<<endl;
+}
+//================================================================
+// Dijkstra from one source like MyAlgorithm, until the last target is settled
+size_t DistanceMatrix::sweep(graph_t const& Graph, vector<costType> const& Weight, unsigned int Source, size_t Row, Search &Labels) {
+  vector <costType> &distances = Labels.distances;
+  vector <double> &lengths = Labels.lengths;
+  for (auto v = Labels.touched.begin(); v != Labels.touched.end(); ++v) {
+      distances[*v] = COST_INFINITE;
+      lengths[*v] = 0;
+    }
+  Labels.touched.clear();
+  Labels.Queue.clear();
+  costType *RowTimes = &Times[Row * Targets.size()];
+  float *RowMeters = &Meters[Row * Targets.size()];
+  size_t Remaining = TargetVertices;
+  size_t Count = 0;
+  distances[Source] = 0;
+  Labels.touched.push_back(Source);
+  Labels.Queue.push(0, Source);
+  while (!Labels.Queue.empty() && Remaining > 0) {
+      pair<costType, unsigned int> Top = Labels.Queue.pop();
+      unsigned int u = Top.second;
+      // stale entry, the vertex was reached at a lower cost since
+      if (Top.first != distances[u]) continue;
+      Count++;
+      if (TargetFirst[u] != TargetFirst[u + 1]) {
+          for (unsigned int k = TargetFirst[u]; k < TargetFirst[u + 1]; k++) {
+              RowTimes[TargetColumns[k]] = Top.first;
+              RowMeters[TargetColumns[k]] = static_cast<float>(lengths[u]);
+            }
+          Remaining--;
+        }
+      graph_traits<graph_t>::out_edge_iterator e, end;
+      for (tie(e, end) = out_edges(u, Graph); e != end; ++e) {
+          unsigned int v = target(*e, Graph);
+          costType Cost = Weight[Graph[*e].index];
+          if (Cost == COST_INFINITE || Cost >= COST_INFINITE - Top.first) continue;
+          Cost += Top.first;
+          if (Cost < distances[v]) {
+              if (distances[v] == COST_INFINITE) Labels.touched.push_back(v);
+              distances[v] = Cost;
+              lengths[v] = lengths[u] + Graph[*e].length;
+              Labels.Queue.push(Cost, v);
+            }
+        }
+    }
+  return Count;
+}
+//================================================================
+// Output
+//================================================================
+void DistanceMatrix::writeCsv(ostream &out, bool InMeters) const {
+  ios::fmtflags Flags = out.flags();
+  streamsize Precision = out.precision();
+  out << fixed << setprecision(InMeters ? 1 : 3) << "source";
+  for (auto it = Targets.begin(); it != Targets.end(); ++it)
+    out << "," << *it;
+  out << "\n";
+  for (size_t i = 0; i < Sources.size(); i++) {
+      out << Sources[i];
+      for (size_t j = 0; j < Targets.size(); j++) {
+          out << ",";
+          if (getTime(i, j) == COST_INFINITE) continue;
+          if (InMeters) out << getMeters(i, j);
+          else out << getTime(i, j) / 1000.0;
+        }
+      out << "\n";
+    }
+  out.flags(Flags);
+  out.precision(Precision);
+}
+
+void DistanceMatrix::writeBinary(ostream &out) const {
+  uint32_t Rows = Sources.size(), Columns = Targets.size();
+  out.write("DMX1", 4);
+  out.write(reinterpret_cast<const char *>(&Rows), sizeof(Rows));
+  out.write(reinterpret_cast<const char *>(&Columns), sizeof(Columns));
+  for (auto it = Sources.begin(); it != Sources.end(); ++it) {
+      uint64_t Node = *it;
+      out.write(reinterpret_cast<const char *>(&Node), sizeof(Node));
+    }
+  for (auto it = Targets.begin(); it != Targets.end(); ++it) {
+      uint64_t Node = *it;
+      out.write(reinterpret_cast<const char *>(&Node), sizeof(Node));
+    }
+  out.write(reinterpret_cast<const char *>(Times.data()), Times.size() * sizeof(costType));
+  out.write(reinterpret_cast<const char *>(Meters.data()), Meters.size() * sizeof(float));
+}
+
+bool DistanceMatrix::save(string const& Path) const {
+  bool Csv = Path.size() >= 4 && Path.compare(Path.size() - 4, 4, ".csv") == 0;
+  ofstream out(Path, Csv ? ios::out : ios::out | ios::binary);
+  if (!out) return false;
+  if (Csv) writeCsv(out);
+  else writeBinary(out);
+  return static_cast<bool>(out);
+}
+//================================================================
+// Accessors
+size_t DistanceMatrix::getRowCount() const { return Sources.size(); }
+size_t DistanceMatrix::getColumnCount() const { return Targets.size(); }
+costType DistanceMatrix::getTime(size_t Row, size_t Column) const { return Times[Row * Targets.size() + Column]; }
+double DistanceMatrix::getMeters(size_t Row, size_t Column) const { return Meters[Row * Targets.size() + Column]; }
+vector<costType> const& DistanceMatrix::getTimes() const { return Times; }
+vector<float> const& DistanceMatrix::getMeters() const { return Meters; }
+size_t DistanceMatrix::getSettledCount() const { return Settled; }
+//================================================================
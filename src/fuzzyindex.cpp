@@ -0,0 +1,243 @@
+#include "fuzzyindex.h"
+#include "textnormalize.h"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+FuzzyIndex::FuzzyIndex(unsigned maxDistance, unsigned prefixLength)
+{
+    m_maxDistance = maxDistance;
+    m_prefixLength = prefixLength;
+}
+
+void FuzzyIndex::clear()
+{
+    m_words.clear();
+    m_wordIds.clear();
+    m_wordDocs.clear();
+    m_deletes.clear();
+}
+
+void FuzzyIndex::add(uint32_t doc, const string &text)
+{
+    istringstream words(normalizeText(text));
+    string w;
+    while(words >> w)
+    {
+        auto found = m_wordIds.find(w);
+        uint32_t id;
+        if(found != m_wordIds.end())
+            id = found->second;
+        else
+        {
+            id = m_words.size();
+            m_words.emplace_back(w);
+            m_wordIds[w] = id;
+            m_wordDocs.emplace_back();
+
+            vector<string> keys;
+            deletions(w.substr(0, m_prefixLength), m_maxDistance, keys);
+            hash<string> hasher;
+            for(auto it = keys.begin(); it != keys.end(); it ++)
+            {
+                vector<uint32_t> &list = m_deletes[hasher(*it)];
+                if(list.empty() || list.back() != id)
+                    list.emplace_back(id);
+            }
+        }
+        vector<uint32_t> &docs = m_wordDocs[id];
+        if(docs.empty() || docs.back() != doc)
+            docs.emplace_back(doc);
+    }
+}
+
+void FuzzyIndex::deletions(const string &word, unsigned distance, vector<string> &result)
+{
+    // breadth first, one deletion more at each step, without duplicates
+    vector<string> level(1, word);
+    result.emplace_back(word);
+    for(unsigned d = 0; d < distance; d ++)
+    {
+        vector<string> next;
+        for(auto it = level.begin(); it != level.end(); it ++)
+        {
+            for(size_t i = 0; i < it->size(); i ++)
+            {
+                string shorter = *it;
+                shorter.erase(i, 1);
+                next.emplace_back(shorter);
+            }
+        }
+        sort(next.begin(), next.end());
+        next.erase(unique(next.begin(), next.end()), next.end());
+        result.insert(result.end(), next.begin(), next.end());
+        level.swap(next);
+    }
+}
+
+unsigned FuzzyIndex::allowedDistance(const string &word) const
+{
+    if(word.size() <= 2)
+        return 0;
+    if(word.size() <= 4)
+        return min(1u, m_maxDistance);
+    return m_maxDistance;
+}
+
+unsigned FuzzyIndex::editDistance(const string &a, const string &b, unsigned bound)
+{
+    size_t n = a.size();
+    size_t m = b.size();
+    if((n > m ? n - m : m - n) > bound)
+        return bound + 1;
+
+    // three rows for the transposition
+    vector<unsigned> before(m + 1), previous(m + 1), current(m + 1);
+    for(size_t j = 0; j <= m; j ++)
+        previous[j] = j;
+    for(size_t i = 1; i <= n; i ++)
+    {
+        current[0] = i;
+        unsigned rowMin = current[0];
+        for(size_t j = 1; j <= m; j ++)
+        {
+            unsigned cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            unsigned value = min(min(previous[j] + 1, current[j - 1] + 1), previous[j - 1] + cost);
+            if(i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                value = min(value, before[j - 2] + 1);
+            current[j] = value;
+            rowMin = min(rowMin, value);
+        }
+        if(rowMin > bound)
+            return bound + 1;
+        before.swap(previous);
+        previous.swap(current);
+    }
+    return min(previous[m], bound + 1);
+}
+
+vector<pair<uint32_t, unsigned>> FuzzyIndex::searchWord(const string &word) const
+{
+    vector<pair<uint32_t, unsigned>> result;
+    unsigned bound = allowedDistance(word);
+
+    auto exact = m_wordIds.find(word);
+    if(bound == 0)
+    {
+        if(exact != m_wordIds.end())
+            result.emplace_back(exact->second, 0);
+        return result;
+    }
+
+    vector<string> keys;
+    deletions(word.substr(0, m_prefixLength), bound, keys);
+    vector<uint32_t> candidates;
+    hash<string> hasher;
+    for(auto it = keys.begin(); it != keys.end(); it ++)
+    {
+        auto list = m_deletes.find(hasher(*it));
+        if(list != m_deletes.end())
+            candidates.insert(candidates.end(), list->second.begin(), list->second.end());
+    }
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // sharing a deletion (or a hash) is not enough, check the real distance
+    for(auto it = candidates.begin(); it != candidates.end(); it ++)
+    {
+        unsigned distance = editDistance(word, m_words[*it], bound);
+        if(distance <= bound)
+            result.emplace_back(*it, distance);
+    }
+    return result;
+}
+
+vector<FuzzyIndex::Match> FuzzyIndex::search(const string &query) const
+{
+    vector<Match> result;
+    istringstream words(normalizeText(query));
+    string w;
+    bool first = true;
+    // (document, distance) sorted by document, intersected word after word
+    vector<pair<uint32_t, unsigned>> matched;
+    while(words >> w)
+    {
+        vector<pair<uint32_t, unsigned>> docs;
+        vector<pair<uint32_t, unsigned>> similar = searchWord(w);
+        for(auto it = similar.begin(); it != similar.end(); it ++)
+        {
+            const vector<uint32_t> &list = m_wordDocs[it->first];
+            for(auto doc = list.begin(); doc != list.end(); doc ++)
+                docs.emplace_back(*doc, it->second);
+        }
+        // keep the best distance of every document
+        sort(docs.begin(), docs.end());
+        docs.erase(unique(docs.begin(), docs.end(), [](const pair<uint32_t, unsigned> &a, const pair<uint32_t, unsigned> &b)
+        {
+            return a.first == b.first;
+        }), docs.end());
+
+        if(first)
+        {
+            matched.swap(docs);
+            first = false;
+            continue;
+        }
+        vector<pair<uint32_t, unsigned>> both;
+        auto a = matched.begin();
+        auto b = docs.begin();
+        while(a != matched.end() && b != docs.end())
+        {
+            if(a->first < b->first)
+                a ++;
+            else if(b->first < a->first)
+                b ++;
+            else
+            {
+                both.emplace_back(a->first, a->second + b->second);
+                a ++;
+                b ++;
+            }
+        }
+        matched.swap(both);
+        if(matched.empty())
+            break;
+    }
+
+    for(auto it = matched.begin(); it != matched.end(); it ++)
+        result.push_back(Match{it->first, it->second});
+    stable_sort(result.begin(), result.end(), [](const Match &a, const Match &b)
+    {
+        return a.distance < b.distance;
+    });
+    return result;
+}
+
+const string &FuzzyIndex::word(uint32_t id) const
+{
+    return m_words[id];
+}
+
+size_t FuzzyIndex::wordCount() const
+{
+    return m_words.size();
+}
+
+size_t FuzzyIndex::memoryUsage() const
+{
+    // vectors by capacity, hash maps by buckets plus one node per element
+    size_t bytes = m_words.capacity() * sizeof(string) + m_wordDocs.capacity() * sizeof(vector<uint32_t>);
+    for(auto it = m_words.begin(); it != m_words.end(); it ++)
+        bytes += it->capacity() + 1;
+    for(auto it = m_wordDocs.begin(); it != m_wordDocs.end(); it ++)
+        bytes += it->capacity() * sizeof(uint32_t);
+    bytes += m_wordIds.bucket_count() * sizeof(void *);
+    bytes += m_wordIds.size() * (sizeof(void *) + sizeof(size_t) + sizeof(pair<string, uint32_t>));
+    for(auto it = m_wordIds.begin(); it != m_wordIds.end(); it ++)
+        bytes += it->first.capacity() + 1;
+    bytes += m_deletes.bucket_count() * sizeof(void *);
+    bytes += m_deletes.size() * (sizeof(void *) + sizeof(size_t) + sizeof(pair<size_t, vector<uint32_t>>));
+    for(auto it = m_deletes.begin(); it != m_deletes.end(); it ++)
+        bytes += it->second.capacity() * sizeof(uint32_t);
+    return bytes;
+}
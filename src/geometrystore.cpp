@@ -0,0 +1,235 @@
+#include "geometrystore.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+GeometryStore::GeometryStore()
+{
+    m_wayStart = 0;
+    m_ringStart = 0;
+    m_wayRings = 0;
+}
+
+void GeometryStore::clear()
+{
+    m_points.clear();
+    m_points.shrink_to_fit();
+    m_ways.clear();
+    m_rings.clear();
+    m_index.clear();
+    m_wayStart = 0;
+    m_ringStart = 0;
+    m_wayRings = 0;
+}
+
+void GeometryStore::reserve(size_t ways, size_t points)
+{
+    m_ways.reserve(ways);
+    m_index.reserve(ways);
+    m_points.reserve(points);
+}
+
+void GeometryStore::addPoint(QPointF point)
+{
+    m_points.emplace_back(point);
+}
+
+void GeometryStore::finishRing()
+{
+    if(m_points.size() > m_ringStart)
+        m_rings.push_back(m_points.size() - m_ringStart);
+    m_ringStart = m_points.size();
+}
+
+void GeometryStore::finishWay(idType id, bool closed)
+{
+    Way way;
+    way.offset = m_wayStart;
+    way.length = m_points.size() - m_wayStart;
+    if(m_wayRings < m_rings.size())
+        finishRing();
+    way.firstRing = m_wayRings;
+    way.ringCount = m_rings.size() - m_wayRings;
+    m_wayStart = m_points.size();
+    m_ringStart = m_wayStart;
+    m_wayRings = m_rings.size();
+    if(way.length == 0)
+        return;
+
+    const QPointF *p = m_points.data() + way.offset;
+    double minX = p[0].x(), maxX = p[0].x(), minY = p[0].y(), maxY = p[0].y();
+    for(uint32_t i = 1; i < way.length; i ++)
+    {
+        minX = min(minX, p[i].x());
+        maxX = max(maxX, p[i].x());
+        minY = min(minY, p[i].y());
+        maxY = max(maxY, p[i].y());
+    }
+    way.bound = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    way.centroid = way.bound.center();
+
+    if(closed && way.length >= 3)
+    {
+        // shoelace formula, relative to the first point to keep the precision, summed over the
+        // rings of an area: the inner rings turn the other way, their area is taken out
+        double area = 0, cx = 0, cy = 0;
+        uint32_t start = 0;
+        for(uint32_t r = 0; r < max(way.ringCount, 1u); r ++)
+        {
+            uint32_t length = way.ringCount == 0 ? way.length : m_rings[way.firstRing + r];
+            for(uint32_t i = 0; i < length; i ++)
+            {
+                QPointF a = p[start + i] - p[0];
+                QPointF b = p[start + (i + 1) % length] - p[0];
+                double cross = a.x() * b.y() - b.x() * a.y();
+                area += cross;
+                cx += (a.x() + b.x()) * cross;
+                cy += (a.y() + b.y()) * cross;
+            }
+            start += length;
+        }
+        if(fabs(area) > 1e-9)
+            way.centroid = p[0] + QPointF(cx / (3 * area), cy / (3 * area));
+    }
+    else if(!closed && way.length >= 2)
+    {
+        double total = 0;
+        for(uint32_t i = 1; i < way.length; i ++)
+            total += hypot(p[i].x() - p[i - 1].x(), p[i].y() - p[i - 1].y());
+        double half = total / 2;
+        for(uint32_t i = 1; i < way.length; i ++)
+        {
+            double length = hypot(p[i].x() - p[i - 1].x(), p[i].y() - p[i - 1].y());
+            if(length >= half)
+            {
+                way.centroid = p[i - 1] + (p[i] - p[i - 1]) * (length > 0 ? half / length : 0);
+                break;
+            }
+            half -= length;
+        }
+    }
+
+    m_index[id] = m_ways.size();
+    m_ways.emplace_back(way);
+}
+
+const GeometryStore::Way *GeometryStore::find(idType id) const
+{
+    auto it = m_index.find(id);
+    if(it == m_index.end())
+        return nullptr;
+    return &m_ways[it->second];
+}
+
+bool GeometryStore::contains(idType id) const
+{
+    return find(id) != nullptr;
+}
+
+PointSpan GeometryStore::points(idType id) const
+{
+    PointSpan span;
+    const Way *way = find(id);
+    if(way != nullptr)
+    {
+        span.data = m_points.data() + way->offset;
+        span.size = way->length;
+    }
+    return span;
+}
+
+vector<PointSpan> GeometryStore::rings(idType id) const
+{
+    vector<PointSpan> spans;
+    const Way *way = find(id);
+    if(way == nullptr)
+        return spans;
+    if(way->ringCount == 0)
+    {
+        spans.push_back(points(id));
+        return spans;
+    }
+    const QPointF *p = m_points.data() + way->offset;
+    for(uint32_t r = 0; r < way->ringCount; r ++)
+    {
+        PointSpan span;
+        span.data = p;
+        span.size = m_rings[way->firstRing + r];
+        spans.push_back(span);
+        p += span.size;
+    }
+    return spans;
+}
+
+QRectF GeometryStore::bounds(idType id) const
+{
+    const Way *way = find(id);
+    return way == nullptr ? QRectF() : way->bound;
+}
+
+QPointF GeometryStore::centroid(idType id) const
+{
+    const Way *way = find(id);
+    return way == nullptr ? QPointF() : way->centroid;
+}
+
+QPolygonF GeometryStore::polygon(idType id) const
+{
+    PointSpan span = points(id);
+    QPolygonF polygon;
+    polygon.reserve(span.size);
+    for(int i = 0; i < span.size; i ++)
+        polygon << span.data[i];
+    return polygon;
+}
+
+size_t GeometryStore::wayCount() const
+{
+    return m_ways.size();
+}
+
+size_t GeometryStore::pointCount() const
+{
+    return m_points.size();
+}
+
+size_t GeometryStore::memory() const
+{
+    // a node of the hash map holds the pair and the next pointer, plus one bucket pointer
+    return m_points.capacity() * sizeof(QPointF) + m_ways.capacity() * sizeof(Way) + m_rings.capacity() * sizeof(uint32_t)
+            + m_index.size() * (sizeof(pair<idType, uint32_t>) + 2 * sizeof(void *));
+}
+
+bool GeometryStore::containsPoint(PointSpan points, QPointF pos)
+{
+    bool inside = false;
+    for(int i = 0, j = points.size - 1; i < points.size; j = i ++)
+    {
+        const QPointF &a = points.data[i];
+        const QPointF &b = points.data[j];
+        if((a.y() > pos.y()) != (b.y() > pos.y())
+                && pos.x() < (b.x() - a.x()) * (pos.y() - a.y()) / (b.y() - a.y()) + a.x())
+            inside = !inside;
+    }
+    return inside;
+}
+
+double GeometryStore::distanceToLine(PointSpan points, QPointF pos)
+{
+    if(points.size == 0)
+        return numeric_limits<double>::max();
+    QPointF d0 = pos - points.data[0];
+    double best = QPointF::dotProduct(d0, d0);
+    for(int i = 0; i + 1 < points.size; i ++)
+    {
+        QPointF a = points.data[i];
+        QPointF ab = points.data[i + 1] - a;
+        QPointF ap = pos - a;
+        double length2 = QPointF::dotProduct(ab, ab);
+        double t = length2 > 0 ? QPointF::dotProduct(ap, ab) / length2 : 0;
+        t = max(0.0, min(1.0, t));
+        QPointF d = ap - ab * t;
+        best = min(best, QPointF::dotProduct(d, d));
+    }
+    return sqrt(best);
+}
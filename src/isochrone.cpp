@@ -0,0 +1,189 @@
+#include <isochrone.h>
+#include <algorithm>
+#include <math.h>
+//===============================================
+using namespace std;
+using namespace boost;
+//===============================================
+
+// the grid of an outline is made coarser beyond this number of cells
+#define ISOCHRONE_MAX_CELLS (1 << 24)
+//===============================================
+
+Isochrone::Isochrone() : Graph(nullptr), Weights(nullptr) {}
+//===========================================================================
+// Search
+//===========================================================================
+bool Isochrone::compute(graph_t const& AnyGraph, GraphMap const& AnyGraphMap, vector<costType> const& AnyWeights,
+                        idType Source2, vector<costType> const& AnyBudgets) {
+  Graph = &AnyGraph;
+  Weights = &AnyWeights;
+  Budgets = AnyBudgets;
+  sort(Budgets.begin(), Budgets.end());
+  Counts.assign(Budgets.size(), 0);
+  Reached.clear();
+  if (distances.size() != num_vertices(AnyGraph)) {
+      distances.assign(num_vertices(AnyGraph), COST_INFINITE);
+      touched.clear();
+    }
+  for (auto v = touched.begin(); v != touched.end(); ++v)
+    distances[*v] = COST_INFINITE;
+  touched.clear();
+  Queue.clear();
+  auto Found = AnyGraphMap.find(Source2);
+  if (Found == AnyGraphMap.end())
+    return false;
+  if (Budgets.empty())
+    return true;
+  //===================================================
+  // nothing beyond the largest budget is pushed, the queue empties there
+  costType Limit = Budgets.back();
+  vector <costType> const& Weight = *Weights;
+  distances[Found->second] = 0;
+  touched.push_back(Found->second);
+  Queue.push(0, Found->second);
+  while (!Queue.empty()) {
+      pair<costType, unsigned int> Top = Queue.pop();
+      unsigned int u = Top.second;
+      // stale entry, the vertex was reached at a lower cost since
+      if (Top.first != distances[u]) continue;
+      Reached.push_back(u);
+      graph_traits<graph_t>::out_edge_iterator e, end;
+      for (tie(e, end) = out_edges(u, AnyGraph); e != end; ++e) {
+          unsigned int v = target(*e, AnyGraph);
+          costType Cost = Weight[AnyGraph[*e].index];
+          if (Cost == COST_INFINITE || Cost > Limit - Top.first) continue;
+          Cost += Top.first;
+          if (Cost < distances[v]) {
+              if (distances[v] == COST_INFINITE) touched.push_back(v);
+              distances[v] = Cost;
+              Queue.push(Cost, v);
+            }
+        }
+    }
+  // the vertices were settled by cost, each budget ends where the next costs more
+  size_t i = 0;
+  for (size_t b = 0; b < Budgets.size(); b++) {
+      while (i < Reached.size() && distances[Reached[i]] <= Budgets[b]) i++;
+      Counts[b] = i;
+    }
+  return true;
+}
+//===========================================================================
+// Outline
+//===========================================================================
+vector<QPolygonF> Isochrone::outline(size_t Budget, double Cell) const {
+  vector <QPolygonF> Rings;
+  if (Budget >= Counts.size() || Counts[Budget] == 0 || Cell <= 0)
+    return Rings;
+  graph_t const& AnyGraph = *Graph;
+  vector <costType> const& Weight = *Weights;
+  costType Limit = Budgets[Budget];
+  // the reached vertices, and points every half cell along what is reached of their edges:
+  // the whole edge when both ends are within the budget, else the part the rest of it pays for
+  vector <QPointF> Points;
+  for (size_t i = 0; i < Counts[Budget]; i++) {
+      unsigned int u = Reached[i];
+      QPointF From = AnyGraph[u].point;
+      Points.push_back(From);
+      graph_traits<graph_t>::out_edge_iterator e, end;
+      for (tie(e, end) = out_edges(u, AnyGraph); e != end; ++e) {
+          unsigned int v = target(*e, AnyGraph);
+          costType Cost = Weight[AnyGraph[*e].index];
+          if (Cost == COST_INFINITE) continue;
+          double Part = distances[v] <= Limit || Cost == 0 ? 1 : double(Limit - distances[u]) / Cost;
+          QPointF Along = (AnyGraph[v].point - From) * min(1.0, Part);
+          int Steps = static_cast<int>(ceil(hypot(Along.x(), Along.y()) / (Cell / 2)));
+          for (int s = 1; s <= Steps; s++)
+            Points.push_back(From + Along * (double(s) / Steps));
+        }
+    }
+  //---------------------------------------------------
+  // the grid has an empty cell on each side, the borders are never cut
+  double Left = Points[0].x(), Top = Points[0].y(), Right = Left, Bottom = Top;
+  for (auto p = Points.begin(); p != Points.end(); ++p) {
+      Left = min(Left, p->x());
+      Right = max(Right, p->x());
+      Top = min(Top, p->y());
+      Bottom = max(Bottom, p->y());
+    }
+  size_t Width, Height;
+  for (;; Cell *= 2) {
+      Width = static_cast<size_t>((Right - Left) / Cell) + 3;
+      Height = static_cast<size_t>((Bottom - Top) / Cell) + 3;
+      if (Width * Height <= ISOCHRONE_MAX_CELLS) break;
+    }
+  Left -= Cell;
+  Top -= Cell;
+  vector <char> Filled(Width * Height, 0);
+  for (auto p = Points.begin(); p != Points.end(); ++p) {
+      size_t x = static_cast<size_t>((p->x() - Left) / Cell);
+      size_t y = static_cast<size_t>((p->y() - Top) / Cell);
+      Filled[y * Width + x] = 1;
+    }
+  //---------------------------------------------------
+  // the sides between a cell in and a cell out, each going from one corner to the next with the
+  // cell on the same hand; a corner has as many sides in as out, two at most where cells touch
+  // by a corner only
+  size_t Columns = Width + 1;
+  vector <int> Out(2 * Columns * (Height + 1), -1);
+  auto side = [&](size_t x1, size_t y1, size_t x2, size_t y2) {
+    size_t From = y1 * Columns + x1;
+    Out[Out[2 * From] == -1 ? 2 * From : 2 * From + 1] = static_cast<int>(y2 * Columns + x2);
+  };
+  for (size_t y = 1; y + 1 < Height; y++) {
+      for (size_t x = 1; x + 1 < Width; x++) {
+          if (!Filled[y * Width + x]) continue;
+          if (!Filled[(y - 1) * Width + x]) side(x, y, x + 1, y);
+          if (!Filled[y * Width + x + 1]) side(x + 1, y, x + 1, y + 1);
+          if (!Filled[(y + 1) * Width + x]) side(x + 1, y + 1, x, y + 1);
+          if (!Filled[y * Width + x - 1]) side(x, y + 1, x, y);
+        }
+    }
+  // the sides chained into rings, only the corners where the border turns are kept
+  auto point = [&](size_t Corner) {
+    return QPointF(Left + (Corner % Columns) * Cell, Top + (Corner / Columns) * Cell);
+  };
+  for (size_t Start = 0; Start < Out.size() / 2; Start++) {
+      while (Out[2 * Start] != -1 || Out[2 * Start + 1] != -1) {
+          QPolygonF Ring;
+          size_t Corner = Start;
+          long Direction = 0;
+          do {
+              size_t Slot = Out[2 * Corner] != -1 ? 2 * Corner : 2 * Corner + 1;
+              size_t Next = static_cast<size_t>(Out[Slot]);
+              Out[Slot] = -1;
+              long Step = static_cast<long>(Next) - static_cast<long>(Corner);
+              if (Step != Direction) Ring << point(Corner);
+              Direction = Step;
+              Corner = Next;
+            } while (Corner != Start);
+          Ring << Ring.front();
+          Rings.push_back(Ring);
+        }
+    }
+  return Rings;
+}
+//===========================================================================
+// Accessors
+size_t Isochrone::getBudgetCount() const { return Budgets.size(); }
+costType Isochrone::getBudget(size_t Budget) const { return Budgets[Budget]; }
+size_t Isochrone::getReachedCount(size_t Budget) const { return Counts[Budget]; }
+size_t Isochrone::getSettledCount() const { return Reached.size(); }
+
+vector<idType> Isochrone::getReachedNodes(size_t Budget) const {
+  vector <idType> Nodes;
+  Nodes.reserve(Counts[Budget]);
+  for (size_t i = 0; i < Counts[Budget]; i++)
+    Nodes.push_back((*Graph)[Reached[i]].node);
+  return Nodes;
+}
+
+vector<QPointF> Isochrone::getReachedPoints(size_t Budget) const {
+  vector <QPointF> Points;
+  Points.reserve(Counts[Budget]);
+  for (size_t i = 0; i < Counts[Budget]; i++)
+    Points.push_back((*Graph)[Reached[i]].point);
+  return Points;
+}
+//===========================================================================
@@ -0,0 +1,183 @@
+#include "labelengine.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LabelEngine::LabelEngine()
+{
+    m_indexed = 0;
+    m_font.setPointSizeF(9.0);
+    m_emphasizedFont.setPointSizeF(16.0);
+}
+
+void LabelEngine::clear()
+{
+    m_labels.clear();
+    m_indexed = 0;
+    m_index.clear();
+    m_layouts.clear();
+}
+
+void LabelEngine::addLabel(const QString &text, QPointF pos, int priority, qreal minScale)
+{
+    m_labels.push_back(Label{text, pos, priority, minScale, false});
+}
+
+void LabelEngine::build()
+{
+    stable_sort(m_labels.begin(), m_labels.end(), [](const Label &a, const Label &b)
+    {
+        return a.priority > b.priority;
+    });
+    m_layouts.clear();
+
+    // an id is also the rank of the label, sorting the ids sorts by priority
+    vector<RTree::Entry> entries(m_labels.size());
+    for(size_t i = 0; i < m_labels.size(); i ++)
+    {
+        entries[i].box = QRectF(m_labels[i].pos, m_labels[i].pos);
+        entries[i].id = i;
+    }
+    m_index.bulkLoad(std::move(entries));
+    m_indexed = m_labels.size();
+}
+
+void LabelEngine::addTemporary(const QString &text, QPointF pos)
+{
+    m_labels.push_back(Label{text, pos, numeric_limits<int>::max(), 0, true});
+}
+
+void LabelEngine::clearTemporary()
+{
+    for(size_t i = m_indexed; i < m_labels.size(); i ++)
+        m_layouts.erase(i);
+    m_labels.resize(m_indexed);
+}
+
+vector<size_t> LabelEngine::place(const QRectF &view, qreal scale)
+{
+    vector<size_t> placed;
+    if(scale <= 0 || view.isEmpty())
+        return placed;
+
+    // the temporary labels first, then the indexed ones in the view by rank
+    vector<size_t> candidates;
+    for(size_t i = m_indexed; i < m_labels.size(); i ++)
+    {
+        if(view.contains(m_labels[i].pos))
+            candidates.push_back(i);
+    }
+    vector<idType> inView = m_index.search(view);
+    size_t first = candidates.size();
+    for(auto it = inView.begin(); it != inView.end(); it ++)
+    {
+        if(m_labels[*it].minScale <= scale)
+            candidates.push_back(*it);
+    }
+    sort(candidates.begin() + first, candidates.end());
+
+    // grid over the view in pixels, each cell lists the boxes placed over it
+    int columns = max(1, static_cast<int>(ceil(view.width() * scale / LABEL_CELL)));
+    int rows = max(1, static_cast<int>(ceil(view.height() * scale / LABEL_CELL)));
+    vector<vector<QRectF>> grid(columns * rows);
+
+    for(auto it = candidates.begin(); it != candidates.end() && placed.size() < MAX_LABELS; it ++)
+    {
+        QSizeF size = layout(*it).size();
+        QPointF center = (m_labels[*it].pos - view.topLeft()) * scale;
+        QRectF box(center.x() - size.width() / 2 - LABEL_PADDING, center.y() - size.height() / 2 - LABEL_PADDING,
+                   size.width() + 2 * LABEL_PADDING, size.height() + 2 * LABEL_PADDING);
+
+        int left = max(0, static_cast<int>(floor(box.left() / LABEL_CELL)));
+        int right = min(columns - 1, static_cast<int>(floor(box.right() / LABEL_CELL)));
+        int top = max(0, static_cast<int>(floor(box.top() / LABEL_CELL)));
+        int bottom = min(rows - 1, static_cast<int>(floor(box.bottom() / LABEL_CELL)));
+
+        bool collides = false;
+        for(int y = top; y <= bottom && !collides; y ++)
+        {
+            for(int x = left; x <= right && !collides; x ++)
+            {
+                const vector<QRectF> &cell = grid[y * columns + x];
+                for(auto other = cell.begin(); other != cell.end(); other ++)
+                {
+                    if(other->intersects(box))
+                    {
+                        collides = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if(collides)
+            continue;
+        for(int y = top; y <= bottom; y ++)
+        {
+            for(int x = left; x <= right; x ++)
+                grid[y * columns + x].push_back(box);
+        }
+        placed.push_back(*it);
+    }
+    return placed;
+}
+
+const LabelEngine::Label &LabelEngine::label(size_t i) const
+{
+    return m_labels[i];
+}
+
+const QFont &LabelEngine::font(size_t i) const
+{
+    return m_labels[i].emphasized ? m_emphasizedFont : m_font;
+}
+
+const QStaticText &LabelEngine::layout(size_t i)
+{
+    auto it = m_layouts.find(i);
+    if(it != m_layouts.end())
+        return it->second;
+    // a simple bound, the layouts of the current view are made again after a flush
+    if(m_layouts.size() >= LABEL_LAYOUT_CACHE)
+        m_layouts.clear();
+    QStaticText &text = m_layouts[i];
+    text.setText(m_labels[i].text);
+    text.setPerformanceHint(QStaticText::AggressiveCaching);
+    text.prepare(QTransform(), font(i));
+    return text;
+}
+
+size_t LabelEngine::size() const
+{
+    return m_labels.size();
+}
+
+QRectF LabelEngine::bounds() const
+{
+    if(m_labels.empty())
+        return QRectF();
+    // min and max by hand, the box of one anchor has no size and united() would skip it
+    double left, top, right, bottom;
+    size_t first = m_indexed;
+    if(m_indexed > 0)
+    {
+        QRectF box = m_index.bounds();
+        left = box.left();
+        top = box.top();
+        right = box.right();
+        bottom = box.bottom();
+    }
+    else
+    {
+        left = right = m_labels[0].pos.x();
+        top = bottom = m_labels[0].pos.y();
+        first = 1;
+    }
+    for(size_t i = first; i < m_labels.size(); i ++)
+    {
+        left = min(left, m_labels[i].pos.x());
+        right = max(right, m_labels[i].pos.x());
+        top = min(top, m_labels[i].pos.y());
+        bottom = max(bottom, m_labels[i].pos.y());
+    }
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
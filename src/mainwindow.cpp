@@ -12,8 +12,19 @@
 #include <QVBoxLayout>
 #include <QLayout>
 #include <QInputDialog>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QLabel>
+#include <QCompleter>
+#include <QStringListModel>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QElapsedTimer>
+#include "projection.h"
+#include <future>
+#include <sstream>
 using namespace std;
 
 MainWindow::MainWindow(QWidget *parent)
@@ -25,6 +36,12 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
     m_mapView = ui->map;
     m_sceneBuilder = new SceneBuilder(m_model);
+    m_mapView->setSceneBuilder(m_sceneBuilder);
+    m_tileCache = new TileCache;
+    m_mapView->setTileCache(m_tileCache);
+    // chunk memory limit in MB, for the regions bigger than the memory
+    QByteArray chunkMemory = qgetenv("MAP_CHUNK_MEMORY");
+    m_chunks = chunkMemory.isEmpty() ? new ChunkStore : new ChunkStore(static_cast<size_t>(chunkMemory.toULongLong()) << 20);
     m_mapView->setDragMode(QGraphicsView::ScrollHandDrag);
     m_mapView->setGeometry(QRect(0,20,100,100));
     m_mapView->lower();
@@ -61,6 +78,22 @@ MainWindow::MainWindow(QWidget *parent)
     connect(this, &MainWindow::changeToInit, m_mapView, &MapView::changeToInit);
     connect(this, &MainWindow::changeToSearch, m_mapView, &MapView::changeToSearch);
     connect(this, &MainWindow::changeToRoute, m_mapView, &MapView::changeToRoute);
+    connect(m_mapView, &MapView::viewportChanged, m_sceneBuilder, &SceneBuilder::cullToViewport);
+    connect(m_mapView, &MapView::showDetail, this, &MainWindow::showDetail);
+
+    // the source and destination also take addresses ("12 rue de la gare"), resolved on return
+    ui->Source_QB->setEditable(true);
+    ui->Source_QB->setInsertPolicy(QComboBox::NoInsert);
+    ui->Destination_QB->setEditable(true);
+    ui->Destination_QB->setInsertPolicy(QComboBox::NoInsert);
+    connect(ui->Source_QB->lineEdit(), &QLineEdit::returnPressed, [this]()
+    {
+        on_Source_QB_activated(ui->Source_QB->currentText());
+    });
+    connect(ui->Destination_QB->lineEdit(), &QLineEdit::returnPressed, [this]()
+    {
+        on_Destination_QB_activated(ui->Destination_QB->currentText());
+    });
 
     //=========== cancel the drawing of the routing and change the state ==========
     connect(this, &MainWindow::cancelRoute, m_mapView, &MapView::changeToInit);
@@ -77,6 +110,11 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     delete ui;
+    delete m_tileCache;
+    // the layers of the chunks point into the store
+    m_sceneBuilder->clear();
+    delete m_chunks;
+    clearRoutingGraph();
     delete m_model;
 }
 
@@ -112,6 +150,11 @@ void MainWindow::loadFile(string filePath)
 {
 
     // =================== load file ==========================
+    // the items and the tiles read the points of the model, they go before it is loaded again
+    m_tileCache->clear();
+    m_sceneBuilder->clear();
+    m_chunks->close();
+    clearRoutingGraph();
     clock_t start = clock();
     m_model->setFilePath(filePath);
     auto mpMap = m_model->getMPMap();
@@ -121,24 +164,37 @@ void MainWindow::loadFile(string filePath)
     std::cout << "time used for loading file: " << t << "s" << std::endl;
     emit changeToInit();
 
-    // =================== render map ==========================
-    start = clock();
+    // ============ generate catalog for searching =============
+    // the catalog only reads the model, it is built on other threads while the scene is built
+    // wall clock here, clock() would add up the time of every thread
+    QElapsedTimer catalogTimer;
+    catalogTimer.start();
+    future<qint64> catalog = async(launch::async, [this, catalogTimer]()
+    {
+        m_model->buildAmenityCatalog();
+        return catalogTimer.elapsed();
+    });
 
-    m_sceneBuilder->clear();
+    // =================== render map ==========================
+    QElapsedTimer renderTimer;
+    renderTimer.start();
 
-    m_sceneBuilder->addPolyItem();
-    m_sceneBuilder->addRoadItem();
+    m_sceneBuilder->addAllItem();
+    m_sceneBuilder->drawPointText();
 
-    t = (clock() - start + 0.0)/CLOCKS_PER_SEC;
-    std::cout << "time used for rendering the map: " << t << "s" << std::endl;
+    std::cout << "time used for rendering the map: " << renderTimer.elapsed() / 1000.0 << "s" << std::endl;
 
-    // ============ generate catalog for searching =============
-    start = clock();
+    // the tiles keep the styles and the simplified levels, the workers start once they are made
+    renderTimer.restart();
+    m_tileCache->build(*m_model);
+    // optional tile directory, one sub directory per map file
+    QString tileDir = qgetenv("MAP_TILE_CACHE");
+    if(!tileDir.isEmpty())
+        tileDir += "/" + QString::fromStdString(filePath.substr(filePath.find_last_of("/\\") + 1));
+    m_tileCache->setDiskCache(tileDir);
+    std::cout << "time used for preparing the tiles: " << renderTimer.elapsed() / 1000.0 << "s" << std::endl;
 
-    m_model->buildAmenityCatalog();
-
-    t = (clock() - start + 0.0)/CLOCKS_PER_SEC;
-    std::cout << "time used for generating the catalog: " << t << "s" << std::endl;
+    std::cout << "time used for generating the catalog: " << catalog.get() / 1000.0 << "s" << std::endl;
 
     m_mapView->setScene(m_sceneBuilder->getScene());
 
@@ -150,6 +206,9 @@ void MainWindow::loadFile(string filePath)
 
     m_mapView->centerOn(m_model->getCenter());
 
+    m_sceneBuilder->cullToViewport(m_mapView->visibleSceneRect());
+    on_actionRaster_Tiles_toggled(ui->actionRaster_Tiles->isChecked());
+
     update();
 }
 
@@ -175,13 +234,58 @@ void MainWindow::getRoutePath(idType src, idType dest)
 
 }
 
-void MainWindow::getSearchName()
+void MainWindow::showDetail(QPointF scenePos)
 {
-    bool ok;
+    ReverseGeocoder::Result result = m_model->reverseGeocode(scenePos);
+    auto line = [](const QString &title, const ReverseGeocoder::Feature &feature, bool showDistance)
+    {
+        if(feature.id == 0)
+            return title + ": -\n";
+        QString text = title + ": " + QString::fromStdString(feature.name.empty() ? feature.type : feature.name);
+        if(!feature.name.empty() && !feature.type.empty())
+            text += " (" + QString::fromStdString(feature.type) + ")";
+        if(showDistance)
+            text += QString(", %1 m").arg(qRound(feature.distance));
+        return text + "\n";
+    };
+    QString text = line(tr("Place"), result.poi, true)
+            + line(tr("Area"), result.area, false)
+            + line(tr("Street"), result.street, true);
+    QMessageBox::information(this, tr("Detail"), text);
+}
 
-    QString text = QInputDialog::getText(this, tr("Search"),
-                                         tr("place name:"), QLineEdit::Normal,
-                                         "aldi", &ok);
+void MainWindow::getSearchName()
+{
+    // search dialog with suggestions updated on every keystroke, the closest to the view first
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Search"));
+    QLineEdit *edit = new QLineEdit("aldi", &dialog);
+    QStringListModel *suggestions = new QStringListModel(&dialog);
+    QCompleter *completer = new QCompleter(suggestions, &dialog);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    edit->setCompleter(completer);
+    QPointF viewCenter = m_mapView->visibleSceneRect().center();
+    connect(edit, &QLineEdit::textEdited, [=](const QString &input)
+    {
+        QStringList list;
+        vector<string> names = m_model->autocompleteNear(input.toStdString(), SEARCH_SUGGESTIONS, viewCenter);
+        if(names.empty())
+            names = m_model->suggestFuzzy(input.toStdString(), SEARCH_SUGGESTIONS);
+        for(auto it = names.begin(); it != names.end(); it ++)
+            list << QString::fromStdString(*it);
+        suggestions->setStringList(list);
+        completer->complete();
+    });
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(new QLabel(tr("place name:"), &dialog));
+    layout->addWidget(edit);
+    layout->addWidget(buttons);
+
+    bool ok = dialog.exec() == QDialog::Accepted;
+    QString text = edit->text();
 
     std::cout << text.toStdString() << std::endl;
 
@@ -213,20 +317,150 @@ void MainWindow::getSearchName()
 
 //===================== edited by Belal to add extra UI =========================
 //start
-void MainWindow::on_Source_QB_activated(const QString &arg1)
+bool MainWindow::resolvePlace(const QString &text, idType &node)
 {
     for(unsigned int i = 0; i < MyPlaces.size(); i++){
-        QString str1 = MyPlaces.at(i).first ;
-        if ((str1.compare(arg1)) == 0)SourceS = MyPlaces.at(i).second;
+        if (MyPlaces.at(i).first.compare(text) == 0)
+        {
+            node = MyPlaces.at(i).second;
+            return true;
+        }
+    }
+    if(m_mapView->getUserState() == MapView::userState::null)
+        return false;
+
+    AddressIndex::Result address = m_model->geocodeAddress(text.toStdString());
+    if(!address.found || address.node == 0)
+    {
+        QMessageBox::warning(this, tr("Address"), tr("didn't find the address:") + "\n" + text);
+        return false;
     }
+    std::cout << "address found: " << address.label << (address.exactNumber ? "" : " (closest number)") << std::endl;
+    node = address.node;
+    return true;
+}
+//-----------------------------------------------------------------
+void MainWindow::on_Source_QB_activated(const QString &arg1)
+{
+    resolvePlace(arg1, SourceS);
 }
 //-----------------------------------------------------------------
 void MainWindow::on_Destination_QB_activated(const QString &arg1)
 {
-    for(unsigned int i = 0; i < MyPlaces.size(); i++){
-        QString str1 = MyPlaces.at(i).first ;
-        if ((str1.compare(arg1)) == 0)DestinationD = MyPlaces.at(i).second;
+    resolvePlace(arg1, DestinationD);
+}
+//-----------------------------------------------------------------
+void MainWindow::buildRoutingGraph()
+{
+    if(m_graph != nullptr)
+        return;
+    m_graph = new MyGraphBuilder(*m_model);
+    m_graph->generateGraph();
+    m_turns = new TurnGraph;
+    m_turns->build(m_graph->getGraph(), m_graph->getGraphMap(), *m_model);
+    m_weights = new WeightOverlay;
+    m_weights->build(*m_graph);
+}
+//-----------------------------------------------------------------
+void MainWindow::clearRoutingGraph()
+{
+    delete m_weights;
+    delete m_turns;
+    delete m_graph;
+    m_weights = nullptr;
+    m_turns = nullptr;
+    m_graph = nullptr;
+}
+//-----------------------------------------------------------------
+void MainWindow::on_actionTraffic_Updates_triggered()
+{
+    if(m_mapView->getUserState() == MapView::userState::null)
+        return;
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Traffic Updates"), "", "Updates (*.txt)");
+    if(fileName.isEmpty())
+        return;
+    buildRoutingGraph();
+    QElapsedTimer timer;
+    timer.start();
+    if(!m_weights->loadFile(fileName.toStdString()))
+    {
+        QMessageBox::warning(this, tr("Traffic Updates"), tr("couldn't read the file:") + "\n" + fileName);
+        return;
+    }
+    std::cout << "time used for the weight updates: " << timer.elapsed() << "ms" << std::endl;
+}
+//-----------------------------------------------------------------
+void MainWindow::on_actionPlaces_Matrix_triggered()
+{
+    if(m_mapView->getUserState() == MapView::userState::null)
+        return;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Places Matrix"), "", "Table (*.csv);;Binary (*.dmx)");
+    if(fileName.isEmpty())
+        return;
+    buildRoutingGraph();
+    // every place to every other one, from the road nodes the routes would start from
+    vector<idType> places;
+    for(auto it = MyPlaces.begin(); it != MyPlaces.end(); it ++)
+    {
+        idType snapped = m_model->snapToRoad(projection(m_model->getNodeLoaction(it->second)), Mode);
+        places.push_back(snapped != 0 ? snapped : it->second);
     }
+    QElapsedTimer timer;
+    timer.start();
+    std::shared_ptr<const WeightSet> weights = m_weights->snapshot();
+    DistanceMatrix matrix;
+    matrix.compute(*m_graph, weights->weights[Mode], places, places);
+    std::cout << "time used for the places matrix: " << timer.elapsed() << "ms" << std::endl;
+    if(!matrix.save(fileName.toStdString()))
+        QMessageBox::warning(this, tr("Places Matrix"), tr("couldn't write the file:") + "\n" + fileName);
+}
+//-----------------------------------------------------------------
+void MainWindow::on_actionReachability_triggered()
+{
+    if(m_mapView->getUserState() == MapView::userState::null)
+        return;
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Reachability"), tr("minutes from the source:"),
+                                         QLineEdit::Normal, "5 10 15", &ok);
+    if(!ok)
+        return;
+    // one search for every budget, the larger ones only go on from where the smaller ones stop
+    string list = text.toStdString();
+    replace(list.begin(), list.end(), ',', ' ');
+    istringstream stream(list);
+    vector<costType> budgets;
+    double minutes;
+    while(stream >> minutes)
+        if(minutes > 0 && minutes < 24 * 60)
+            budgets.push_back(static_cast<costType>(minutes * 60000));
+    if(budgets.empty())
+        return;
+    buildRoutingGraph();
+    idType source = m_model->snapToRoad(projection(m_model->getNodeLoaction(SourceS)), Mode);
+    QElapsedTimer timer;
+    timer.start();
+    std::shared_ptr<const WeightSet> weights = m_weights->snapshot();
+    Isochrone isochrone;
+    if(!isochrone.compute(m_graph->getGraph(), m_graph->getGraphMap(), weights->weights[Mode], source != 0 ? source : SourceS, budgets))
+    {
+        QMessageBox::warning(this, tr("Reachability"), tr("the source is not on a road of the mode"));
+        return;
+    }
+    vector<vector<QPolygonF>> outlines;
+    for(size_t i = 0; i < isochrone.getBudgetCount(); i ++)
+        outlines.push_back(isochrone.outline(i, ISOCHRONE_CELL));
+    std::cout << "time used for the reachability: " << timer.elapsed() << "ms, "
+              << isochrone.getSettledCount() << " nodes" << std::endl;
+    emit cancelRoute();
+    m_sceneBuilder->drawIsochrones(outlines);
+    emit changeToRoute();
+}
+//-----------------------------------------------------------------
+void MainWindow::on_Mode_QB_activated(int index)
+{
+    // the items are in the order of travelMode
+    if(index >= 0 && index < MODE_COUNT)
+        Mode = static_cast<travelMode>(index);
 }
 //-----------------------------------------------------------------
 void MainWindow::on_Navigate_Button_clicked()
@@ -234,11 +468,14 @@ void MainWindow::on_Navigate_Button_clicked()
     //edited by deng, added if statement to avoid crash
     if(m_mapView->getUserState() != MapView::userState::null)
     {
-        ShortPath route(SourceS,DestinationD,*m_model);
+        buildRoutingGraph();
+        // the version of the weights of this route, the updates loaded meanwhile wait for the next one
+        std::shared_ptr<const WeightSet> weights = m_weights->snapshot();
+        ShortPath route(SourceS,DestinationD,*m_model,*m_graph,*weights,m_turns,Mode);
         // added by deng to merge this to UI FSM
         emit cancelRoute();
-        Path anypath = route.getYourPath();
-        m_sceneBuilder->drawRoute(anypath);
+        // the route carries its projected points, no node is looked up again
+        m_sceneBuilder->drawRoute(route.getYourRoute());
         // added by deng to merge this to UI FSM
         emit changeToRoute();
 
@@ -253,6 +490,66 @@ void MainWindow::on_action_Open_File_triggered()
     loadFile(FilePath2);
 }
 //-----------------------------------------------------------------
+void MainWindow::on_actionImport_Region_triggered()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Import Region"), "", "OSM File (*.pbf)");
+    if(fileName.isEmpty())
+        return;
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Store Directory"));
+    if(dir.isEmpty())
+        return;
+    QElapsedTimer timer;
+    timer.start();
+    if(!ChunkStore::import(fileName.toStdString(), dir.toStdString()))
+    {
+        QMessageBox::warning(this, tr("Import Region"), tr("couldn't import the file into:") + "\n" + dir);
+        return;
+    }
+    std::cout << "time used for importing the region: " << timer.elapsed() / 1000.0 << "s" << std::endl;
+    openRegion(dir);
+}
+//-----------------------------------------------------------------
+void MainWindow::on_actionOpen_Region_triggered()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Open Region"));
+    if(!dir.isEmpty())
+        openRegion(dir);
+}
+//-----------------------------------------------------------------
+void MainWindow::openRegion(QString dir)
+{
+    // only the base map: the tiles, the labels, the search and the routing need a loaded file,
+    // the file shown before goes with its routing graph so nothing works on a map off screen
+    m_tileCache->clear();
+    m_sceneBuilder->clear();
+    clearRoutingGraph();
+    m_model->unload();
+    m_mapView->changeToNull();
+    if(!m_chunks->open(dir.toStdString()))
+    {
+        QMessageBox::warning(this, tr("Open Region"), tr("no region store in:") + "\n" + dir);
+        return;
+    }
+    std::cout << "chunks in the region: " << m_chunks->chunkCount() << std::endl;
+    m_sceneBuilder->setChunkStore(m_chunks);
+    ui->actionRaster_Tiles->setChecked(false);
+    on_actionRaster_Tiles_toggled(false);
+
+    m_mapView->setScene(m_sceneBuilder->getScene());
+    m_mapView->setBackgroundBrush(QBrush(QColor(230,230,230)));
+    m_mapView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    m_mapView->centerOn(m_chunks->bounds().center());
+    m_sceneBuilder->cullToViewport(m_mapView->visibleSceneRect());
+    update();
+}
+//-----------------------------------------------------------------
+void MainWindow::on_actionRaster_Tiles_toggled(bool checked)
+{
+    // the tiles and the vector items draw the same ways, only one of them is shown
+    m_mapView->setTilesEnabled(checked);
+    m_sceneBuilder->setBatchesVisible(!checked);
+}
+//-----------------------------------------------------------------
 void MainWindow::on_actionQuit_triggered()
 {
     QApplication::quit();
@@ -4,6 +4,8 @@
 * @date  30-11-2019
 */
 #include "mapview.h"
+#include "SceneBuilder.h"
+#include "tilecache.h"
 
 void MapView::mousePressEvent(QMouseEvent *event)
 {
@@ -15,12 +17,14 @@ void MapView::mousePressEvent(QMouseEvent *event)
         {
             auto pos = event->pos();
             auto scenePos = mapToScene(pos);
+            m_detailPos = scenePos;
     //            std::cout << "position from mapview is " << pos.x() << ", " << pos.y() << std::endl;
-            auto item = this->scene()->itemAt(scenePos, QTransform());
-            if(qgraphicsitem_cast<Multipolygon *>(item))
+            // the ways are drawn in batches, a way is picked by its id
+            idType id = m_sceneBuilder != nullptr ? m_sceneBuilder->polygonAt(scenePos) : 0;
+            if(id != 0)
             {
-                m_selectedItem = qgraphicsitem_cast<Multipolygon *>(item);
-                if(m_selectedItem->getPolyType() == building)
+                m_selectedId = id;
+                if(m_sceneBuilder->polygonTypeOf(id) == building)
                     m_isBuilding = true;
             }
             QGraphicsView::mousePressEvent(event);
@@ -42,10 +46,10 @@ void MapView::contextMenuEvent(QContextMenuEvent *event)
         {
             menu.addAction("select as source place");
             menu.addAction("select as destiantion place");
-            //======== this is set for debug ============
-            menu.addAction("show detail");
             m_isBuilding = false;
         }
+        // what is under the cursor, works outside the buildings too
+        menu.addAction("show detail");
     }
     else if(m_state == sourceSel || m_state == destSel)
     {
@@ -66,14 +70,13 @@ void MapView::contextMenuEvent(QContextMenuEvent *event)
     QAction *a = menu.exec(event->globalPos());
     if(a != nullptr)
     {
-        //=========== this is set for debug ==========
         if(a->text() == "show detail")
         {
-            std::cout << "the id of the building:" << m_selectedItem->getId() << std::endl;
+            emit showDetail(m_detailPos);
         }
         if(a->text() == "select as source place")
         {
-            emit setSource(m_selectedItem);
+            emit setSource(m_selectedId);
             if(m_state == destSel)
             {
                 m_state = routing;
@@ -84,7 +87,7 @@ void MapView::contextMenuEvent(QContextMenuEvent *event)
         }
         else if(a->text() == "select as destiantion place")
         {
-            emit setDest(m_selectedItem);
+            emit setDest(m_selectedId);
             if(m_state == sourceSel)
             {
                 m_state = routing;
@@ -113,7 +116,7 @@ void MapView::contextMenuEvent(QContextMenuEvent *event)
 
     //============ end of state control ==============
 
-    m_selectedItem = nullptr;
+    m_selectedId = 0;
 }
 
 void MapView::wheelEvent(QWheelEvent *event)
@@ -136,6 +139,84 @@ void MapView::wheelEvent(QWheelEvent *event)
             m_scale *= 1/ZOOM_STEP;
         }
     }
+    emit viewportChanged(visibleSceneRect());
+}
+
+void MapView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    emit viewportChanged(visibleSceneRect());
+}
+
+void MapView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    emit viewportChanged(visibleSceneRect());
+}
+
+void MapView::setSceneBuilder(SceneBuilder *builder)
+{
+    m_sceneBuilder = builder;
+}
+
+void MapView::setTileCache(TileCache *cache)
+{
+    if(m_tileCache != nullptr)
+        disconnect(m_tileCache, &TileCache::tileReady, this, &MapView::tileReady);
+    m_tileCache = cache;
+    if(m_tileCache != nullptr)
+        connect(m_tileCache, &TileCache::tileReady, this, &MapView::tileReady, Qt::QueuedConnection);
+}
+
+void MapView::setTilesEnabled(bool enabled)
+{
+    m_tilesEnabled = enabled;
+    viewport()->update();
+}
+
+void MapView::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+    if(m_tileCache == nullptr || !m_tilesEnabled)
+        return;
+
+    qreal scale = transform().m11();
+    int z = TileCache::zoomFor(scale);
+    vector<TileKey> keys = TileCache::tilesIn(rect, z);
+    for(auto it = keys.begin(); it != keys.end(); it ++)
+    {
+        QRectF target = TileCache::tileRect(*it);
+        QImage image = m_tileCache->tile(*it);
+        if(!image.isNull())
+        {
+            painter->drawImage(target, image);
+            continue;
+        }
+        // not rendered yet, the part of a lower zoom tile covering it stands in
+        for(int up = 1; up <= 3 && up <= z; up ++)
+        {
+            TileKey parent{z - up, it->x >> up, it->y >> up};
+            image = m_tileCache->tile(parent);
+            if(image.isNull())
+                continue;
+            qreal side = qreal(TILE_SIZE) / (1 << up);
+            QRectF source((it->x - (parent.x << up)) * side, (it->y - (parent.y << up)) * side, side, side);
+            painter->drawImage(target, image, source);
+            break;
+        }
+    }
+    // the missing tiles of the whole view and the ones around it, not only of the exposed part
+    m_tileCache->request(visibleSceneRect(), scale);
+}
+
+void MapView::tileReady()
+{
+    viewport()->update();
+}
+
+QRectF MapView::visibleSceneRect()
+{
+    return mapToScene(viewport()->rect()).boundingRect();
 }
 
 void MapView::changeToSearch()
@@ -159,6 +240,14 @@ void MapView::changeToRoute()
     m_state = routing;
 }
 
+void MapView::changeToNull()
+{
+    m_srcId = 0;
+    m_destId = 0;
+    m_state = null;
+    m_isBuilding = false;
+}
+
 MapView::userState MapView::getUserState()
 {
     return m_state;
@@ -170,6 +259,10 @@ MapView::MapView(QWidget *parent) : QGraphicsView(parent)
     m_isBuilding = false;
     m_pressPos = QPoint(0,0);
     m_state = null;
+    m_sceneBuilder = nullptr;
+    m_selectedId = 0;
+    m_tileCache = nullptr;
+    m_tilesEnabled = false;
 }
 
 MapView::~MapView(){}
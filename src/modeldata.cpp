@@ -1,7 +1,13 @@
 #include "modeldata.h"
+#include "modelDataHandler.h"
+#include "projection.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <time.h>
 
 
-vector<string> modelData::findName(vector<modelData::tagPair> &tags)
+vector<string> modelData::findName(const vector<modelData::tagPair> &tags)
 {
     vector<string> tempVec;
     for(auto it = tags.begin(); it != tags.end(); it ++)
@@ -31,7 +37,18 @@ void modelData::clear()
     m_WayMap.clear();
     m_RelationMap.clear();
     m_Multipolygon.clear();
-    m_AmenityType.clear();
+    m_AreaMap.clear();
+    m_AmenityTypeId.clear();
+    m_AmenityTypeName.clear();
+    m_AmenityTypeBucket.clear();
+    m_AmenityNameIndex.clear();
+    m_AmenityPrefixIndex.clear();
+    m_AmenityFuzzyIndex.clear();
+    m_AmenityIndex.clear();
+    m_WayIndex.clear();
+    m_Geometry.clear();
+    m_Geocoder.clear();
+    m_Addresses.clear();
 }
 
 const nodeData modelData::getNodeData(modelData::idType id)
@@ -69,15 +86,235 @@ const map<modelData::idType, vector<modelData::idType> > modelData::getMultipoly
     return m_Multipolygon;
 }
 
-void modelData::buildAmenityCatagory()
+const map<modelData::idType, polygonType> modelData::getAreaMap()
 {
-    buildCatagory(m_NodeMap);
-    buildCatagory(m_WayMap);
+    return m_AreaMap;
+}
+
+bool modelData::assembleArea(idType id, const relationData &relation, MultipolygonArea &area)
+{
+    // styled from the tags of the relation as a closed way, old style relations tag their outer way instead
+    wayData style;
+    style.isClosed = true;
+    bool nonPolyFlag = false;
+    bool multipolygon = false;
+    for(auto it = relation.tagList.begin(); it != relation.tagList.end(); it ++)
+    {
+        if(it->first == "type")
+            multipolygon = it->second == "multipolygon";
+        else
+            modelDataHandler::classifyTag(it->first, it->second, style, nonPolyFlag);
+    }
+    if(!multipolygon || !style.isPolygon || style.pType == invalid)
+        return false;
+
+    // the members missing from the extract are skipped, their rings don't close
+    vector<const vector<idType> *> outerWays, innerWays;
+    for(auto it = relation.memberList.begin(); it != relation.memberList.end(); it ++)
+    {
+        if(it->type != osmium::item_type::way)
+            continue;
+        auto way = m_WayMap.find(it->ref);
+        if(way == m_WayMap.end())
+            continue;
+        if(it->role == "inner")
+            innerWays.push_back(&way->second.nodeRefList);
+        else
+            outerWays.push_back(&way->second.nodeRefList);
+    }
+
+    auto project = [this](const vector<vector<idType>> &rings)
+    {
+        vector<vector<QPointF>> result(rings.size());
+        for(size_t i = 0; i < rings.size(); i ++)
+        {
+            result[i].reserve(rings[i].size());
+            for(auto node = rings[i].begin(); node != rings[i].end(); node ++)
+                result[i].emplace_back(projection(m_NodesLocation.get(*node)));
+        }
+        return result;
+    };
+    vector<vector<QPointF>> outer = project(joinRings(outerWays));
+    if(outer.empty())
+        return false;
+    vector<vector<QPointF>> inner = project(joinRings(innerWays));
+
+    area.id = id;
+    area.type = style.pType;
+    area.points.clear();
+    area.rings.clear();
+    appendRings(area.points, area.rings, outer, inner);
+    return true;
+}
+
+vector<MultipolygonArea> modelData::assembleAreas(unsigned threads)
+{
+    if(threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    vector<map<idType, relationData>::const_iterator> relations;
+    for(auto it = m_RelationMap.cbegin(); it != m_RelationMap.cend(); it ++)
+        relations.push_back(it);
+
+    // every thread takes a range of the relations, the ranges are merged back in id order
+    size_t step = max<size_t>(1, (relations.size() + threads - 1) / threads);
+    vector<vector<MultipolygonArea>> parts((relations.size() + step - 1) / step);
+    auto assemble = [this, &relations, &parts, step](size_t part)
+    {
+        size_t last = min(relations.size(), (part + 1) * step);
+        for(size_t i = part * step; i < last; i ++)
+        {
+            MultipolygonArea area;
+            if(assembleArea(relations[i]->first, relations[i]->second, area))
+                parts[part].emplace_back(std::move(area));
+        }
+    };
+    if(parts.size() == 1)
+        assemble(0);
+    else
+    {
+        vector<thread> workers;
+        for(size_t part = 0; part < parts.size(); part ++)
+            workers.emplace_back(assemble, part);
+        for(auto it = workers.begin(); it != workers.end(); it ++)
+            it->join();
+    }
+
+    vector<MultipolygonArea> areas;
+    for(auto it = parts.begin(); it != parts.end(); it ++)
+        areas.insert(areas.end(), make_move_iterator(it->begin()), make_move_iterator(it->end()));
+    return areas;
+}
+
+void modelData::buildAmenityCatagory(unsigned threads)
+{
+    if(threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    m_Amenity.clear();
+    m_AmenityTypeId.clear();
+    m_AmenityTypeName.clear();
+    m_AmenityTypeBucket.clear();
+    buildCatagory(m_NodeMap, threads);
+    buildCatagory(m_WayMap, threads);
+
+    // trigram index over the names, the document is the position in m_Amenity
+    auto buildNameIndex = [this]()
+    {
+        m_AmenityNameIndex.clear();
+        for(uint32_t i = 0; i < m_Amenity.size(); i ++)
+        {
+            for(auto it = m_Amenity[i].name.begin(); it != m_Amenity[i].name.end(); it ++)
+                m_AmenityNameIndex.add(i, *it);
+        }
+    };
+
+    auto buildFuzzyIndex = [this]()
+    {
+        m_AmenityFuzzyIndex.clear();
+        for(uint32_t i = 0; i < m_Amenity.size(); i ++)
+        {
+            for(auto it = m_Amenity[i].name.begin(); it != m_Amenity[i].name.end(); it ++)
+                m_AmenityFuzzyIndex.add(i, *it);
+            m_AmenityFuzzyIndex.add(i, m_Amenity[i].type);
+        }
+    };
+
+    // autocompletion: named places weigh more when they have several names and when they are
+    // mapped as ways (an outline, a building or a site, rather than a point); types weigh the
+    // number of places having them, and are placed at each of these places for completeNear
+    // so a type ranks by its closest place like a name does
+    auto buildPrefixIndex = [this]()
+    {
+        m_AmenityPrefixIndex.clear();
+        for(uint32_t i = 0; i < m_Amenity.size(); i ++)
+        {
+            const catagoryData &data = m_Amenity[i];
+            uint32_t weight = 1 + 2 * data.name.size() + (data.itemType == osmium::item_type::way ? 1 : 0);
+            for(auto it = data.name.begin(); it != data.name.end(); it ++)
+                m_AmenityPrefixIndex.add(*it, i, weight, data.position);
+        }
+        for(uint32_t i = 0; i < m_AmenityTypeName.size(); i ++)
+        {
+            vector<QPointF> positions;
+            positions.reserve(m_AmenityTypeBucket[i].size());
+            for(auto it = m_AmenityTypeBucket[i].begin(); it != m_AmenityTypeBucket[i].end(); it ++)
+                positions.push_back(m_Amenity[*it].position);
+            m_AmenityPrefixIndex.add(m_AmenityTypeName[i], i, m_AmenityTypeBucket[i].size(), positions);
+        }
+        m_AmenityPrefixIndex.build();
+    };
+
+    auto buildSpatialIndex = [this]()
+    {
+        vector<RTree::Entry> entries(m_Amenity.size());
+        for(uint32_t i = 0; i < m_Amenity.size(); i ++)
+        {
+            entries[i].box = QRectF(m_Amenity[i].position, m_Amenity[i].position);
+            entries[i].id = i;
+        }
+        m_AmenityIndex.bulkLoad(std::move(entries));
+    };
+
+    // the indexes only read the catalog, each one is built on its own thread
+    if(threads == 1)
+    {
+        buildNameIndex();
+        buildFuzzyIndex();
+        buildPrefixIndex();
+        buildSpatialIndex();
+        return;
+    }
+    thread nameWorker(buildNameIndex);
+    thread fuzzyWorker(buildFuzzyIndex);
+    thread spatialWorker(buildSpatialIndex);
+    buildPrefixIndex();
+    nameWorker.join();
+    fuzzyWorker.join();
+    spatialWorker.join();
+}
+
+static vector<string> suggestionText(const vector<PrefixIndex::Suggestion> &suggestions)
+{
+    vector<string> result;
+    for(auto it = suggestions.begin(); it != suggestions.end(); it ++)
+        result.emplace_back(it->text);
+    return result;
+}
+
+vector<string> modelData::autocomplete(const string &prefix, size_t k)
+{
+    return suggestionText(m_AmenityPrefixIndex.complete(prefix, k));
+}
+
+vector<string> modelData::autocompleteNear(const string &prefix, size_t k, QPointF center)
+{
+    return suggestionText(m_AmenityPrefixIndex.completeNear(prefix, k, center));
 }
 
 vector<catagoryData> modelData::searchAmenityByName(string name)
 {
     vector<catagoryData> result;
+    vector<uint32_t> candidates;
+    if(m_AmenityNameIndex.candidates(name, candidates))
+    {
+        // candidates are sorted, so the order is the same as the full scan
+        for(auto it = candidates.begin(); it != candidates.end(); it ++)
+        {
+            const catagoryData &data = m_Amenity[*it];
+            for(auto it2 = data.name.begin(); it2 != data.name.end(); it2 ++)
+            {
+                if(it2->find(name) != string::npos)
+                {
+                    result.emplace_back(data);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    // too short for the index
     for(auto it = m_Amenity.begin(); it != m_Amenity.end(); it ++)
     {
         for(auto it2 = it->name.begin(); it2 != it->name.end(); it2 ++)
@@ -92,52 +329,615 @@ vector<catagoryData> modelData::searchAmenityByName(string name)
     return result;
 }
 
-bool modelData::isAmenityTypeExist(string name)
+vector<catagoryData> modelData::searchAmenityFuzzy(string name)
 {
-    for(auto it = m_AmenityType.begin(); it != m_AmenityType.end(); it ++)
+    vector<catagoryData> result;
+    vector<FuzzyIndex::Match> matches = m_AmenityFuzzyIndex.search(name);
+    for(auto it = matches.begin(); it != matches.end(); it ++)
     {
-        if(it->find(name) != string::npos)
-            return true;
+        // sorted by distance, stop after the best ones
+        if(it->distance > matches.front().distance)
+            break;
+        result.emplace_back(m_Amenity[it->doc]);
     }
-    return false;
+    return result;
+}
+
+vector<string> modelData::suggestFuzzy(const string &name, size_t k)
+{
+    vector<string> result;
+    set<string> seen;
+    vector<FuzzyIndex::Match> matches = m_AmenityFuzzyIndex.search(name);
+    for(auto it = matches.begin(); it != matches.end() && result.size() < k; it ++)
+    {
+        const catagoryData &data = m_Amenity[it->doc];
+        const string &text = data.name.empty() ? data.type : data.name.front();
+        if(seen.insert(text).second)
+            result.emplace_back(text);
+    }
+    return result;
+}
 
+size_t modelData::fuzzyIndexMemory()
+{
+    return m_AmenityFuzzyIndex.memoryUsage();
+}
+
+const vector<catagoryData> &modelData::getAmenityCatalog()
+{
+    return m_Amenity;
+}
+
+uint32_t modelData::getTypeId(const string &type)
+{
+    auto it = m_AmenityTypeId.find(type);
+    if(it != m_AmenityTypeId.end())
+        return it->second;
+    uint32_t id = m_AmenityTypeName.size();
+    m_AmenityTypeId[type] = id;
+    m_AmenityTypeName.emplace_back(type);
+    m_AmenityTypeBucket.emplace_back();
+    return id;
+}
+
+vector<uint32_t> modelData::matchTypes(const string &name)
+{
+    vector<uint32_t> ids;
+    auto exact = m_AmenityTypeId.find(name);
+    if(exact != m_AmenityTypeId.end())
+    {
+        ids.emplace_back(exact->second);
+        return ids;
+    }
+    // a partial type ("rest" for "restaurant"), there are only a few hundred distinct types
+    for(uint32_t i = 0; i < m_AmenityTypeName.size(); i ++)
+    {
+        if(m_AmenityTypeName[i].find(name) != string::npos)
+            ids.emplace_back(i);
+    }
+    return ids;
+}
+
+bool modelData::isAmenityTypeExist(string name)
+{
+    return !matchTypes(name).empty();
 }
 
 vector<catagoryData> modelData::searchAmenityByType(string name)
 {
     vector<catagoryData> result;
-    for(auto it = m_Amenity.begin(); it != m_Amenity.end(); it ++)
+    vector<uint32_t> ids = matchTypes(name);
+    if(ids.empty())
+        return result;
+
+    // one bucket is already in catalog order, several are merged back into it
+    vector<uint32_t> positions;
+    if(ids.size() == 1)
+        positions = m_AmenityTypeBucket[ids.front()];
+    else
+    {
+        for(auto it = ids.begin(); it != ids.end(); it ++)
+            positions.insert(positions.end(), m_AmenityTypeBucket[*it].begin(), m_AmenityTypeBucket[*it].end());
+        sort(positions.begin(), positions.end());
+    }
+
+    result.reserve(positions.size());
+    for(auto it = positions.begin(); it != positions.end(); it ++)
+        result.emplace_back(m_Amenity[*it]);
+    return result;
+}
+
+// below this number of places carrying the text, they are filtered by position one by one,
+// above it the area is walked from the center and every place is tested against the text
+static const size_t TEXT_FIRST_LIMIT = 4096;
+
+vector<catagoryData> modelData::searchAmenitySpatial(const string &text, QPointF center, double radius, const QRectF *rect, size_t limit)
+{
+    vector<catagoryData> result;
+    if(limit == 0 || m_AmenityIndex.empty())
+        return result;
+
+    // same match as searchAmenityByType and searchAmenityByName
+    vector<char> typeMatch(m_AmenityTypeName.size(), 0);
+    vector<uint32_t> types = matchTypes(text);
+    size_t estimate = 0;
+    for(auto it = types.begin(); it != types.end(); it ++)
+    {
+        typeMatch[*it] = 1;
+        estimate += m_AmenityTypeBucket[*it].size();
+    }
+    vector<uint32_t> candidates;
+    // too short for the trigrams: every place is a name candidate
+    bool indexed = m_AmenityNameIndex.candidates(text, candidates);
+    if(indexed)
+        estimate += candidates.size();
+    else
+        estimate = m_Amenity.size();
+
+    auto nameMatch = [&](const catagoryData &data)
     {
-        if(it->type.find(name) != string::npos)
-            result.emplace_back(*it);
+        for(auto it = data.name.begin(); it != data.name.end(); it ++)
+        {
+            if(it->find(text) != string::npos)
+                return true;
+        }
+        return false;
+    };
+    auto inside = [&](QPointF pos)
+    {
+        return rect == nullptr || rect->contains(pos);
+    };
+
+    if(estimate > TEXT_FIRST_LIMIT)
+    {
+        m_AmenityIndex.visitNearest(center, radius, [&](idType id, double)
+        {
+            const catagoryData &data = m_Amenity[id];
+            if(inside(data.position) && (typeMatch[data.typeId] || nameMatch(data)))
+                result.emplace_back(data);
+            return result.size() < limit;
+        });
+        return result;
     }
+
+    // (distance, position in m_Amenity) of the places in the area
+    vector<pair<double, uint32_t>> found;
+    auto consider = [&](uint32_t i)
+    {
+        const catagoryData &data = m_Amenity[i];
+        QPointF d = data.position - center;
+        double distance = sqrt(QPointF::dotProduct(d, d));
+        if(distance <= radius && inside(data.position))
+            found.emplace_back(distance, i);
+    };
+    for(auto it = types.begin(); it != types.end(); it ++)
+    {
+        for(auto i = m_AmenityTypeBucket[*it].begin(); i != m_AmenityTypeBucket[*it].end(); i ++)
+            consider(*i);
+    }
+    auto candidate = [&](uint32_t i)
+    {
+        // the places of a matching type are already there
+        if(!typeMatch[m_Amenity[i].typeId] && nameMatch(m_Amenity[i]))
+            consider(i);
+    };
+    if(indexed)
+    {
+        for(auto it = candidates.begin(); it != candidates.end(); it ++)
+            candidate(*it);
+    }
+    else
+    {
+        for(uint32_t i = 0; i < m_Amenity.size(); i ++)
+            candidate(i);
+    }
+    sort(found.begin(), found.end());
+    if(found.size() > limit)
+        found.resize(limit);
+    result.reserve(found.size());
+    for(auto it = found.begin(); it != found.end(); it ++)
+        result.emplace_back(m_Amenity[it->second]);
     return result;
 }
 
+vector<catagoryData> modelData::searchAmenityNear(const string &text, QPointF center, double radius, size_t limit)
+{
+    return searchAmenitySpatial(text, center, radius, nullptr, limit);
+}
+
+vector<catagoryData> modelData::searchAmenityInRect(const string &text, const QRectF &rect, size_t limit)
+{
+    // the circle around the rect, the rect itself is checked place by place
+    QRectF area = rect.normalized();
+    double radius = sqrt(area.width() * area.width() + area.height() * area.height()) / 2;
+    return searchAmenitySpatial(text, area.center(), radius, &area, limit);
+}
+
+template<typename Iterator>
+void modelData::collectCatagory(Iterator first, Iterator last, vector<catagoryData> &result)
+{
+    for(auto data = first; data != last; data ++)
+    {
+        const vector<tagPair> &tags = data->second.tagList;
+        for(auto tag = tags.begin(); tag != tags.end(); tag ++)
+        {
+            if(tag->first == "amenity" || tag->first == "shop" || data->second.osmType == osmium::item_type::node)
+            {
+                catagoryData temp;
+                temp.itemType = data->second.osmType;
+                temp.type = tag->second;
+                boost::algorithm::to_lower(temp.type);
+                temp.name = findName(tags);
+                temp.id = data->first;
+                if(data->second.osmType == osmium::item_type::node)
+                    temp.position = projection(m_NodesLocation.get(data->first));
+                else
+                    temp.position = getWayCentroid(data->first);
+                result.emplace_back(std::move(temp));
+                break;
+            }
+        }
+    }
+}
+
 template<typename T>
-void modelData::buildCatagory(const T &map)
+void modelData::buildCatagory(const T &map, unsigned threads)
 {
     //loop over node map and way map
-    for(auto data = map.begin(); data != map.end(); data ++)
+    if(map.empty())
+        return;
+
+    // bounds of the ranges, the map is walked once to find them
+    size_t step = (map.size() + threads - 1) / threads;
+    vector<typename T::const_iterator> bounds;
+    size_t i = 0;
+    for(auto it = map.begin(); it != map.end(); it ++, i ++)
+    {
+        if(i % step == 0)
+            bounds.emplace_back(it);
+    }
+    bounds.emplace_back(map.end());
+
+    vector<vector<catagoryData>> parts(bounds.size() - 1);
+    if(parts.size() == 1)
+        collectCatagory(bounds[0], bounds[1], parts[0]);
+    else
     {
-        vector<tagPair> tags = data->second.tagList;
-        if(tags.size() != 0)
+        vector<thread> workers;
+        for(size_t part = 0; part < parts.size(); part ++)
         {
-            catagoryData temp;
-            for(auto tag = tags.begin(); tag != tags.end(); tag ++)
+            workers.emplace_back([this, &bounds, &parts, part]()
             {
-                if(tag->first == "amenity" || tag->first == "shop" || data->second.osmType == osmium::item_type::node)
-                {
-                    temp.itemType = data->second.osmType;
-                    temp.type = tag->second;
-                    boost::algorithm::to_lower(temp.type);
-                    temp.name = findName(tags);
-                    temp.id = data->first;
-                    m_Amenity.emplace_back(temp);
-                    m_AmenityType.insert(temp.type);
-                    break;
-                }
+                collectCatagory(bounds[part], bounds[part + 1], parts[part]);
+            });
+        }
+        for(auto it = workers.begin(); it != workers.end(); it ++)
+            it->join();
+    }
+
+    // merged in map order, the type ids are given here so they don't depend on the threads
+    size_t total = m_Amenity.size();
+    for(auto it = parts.begin(); it != parts.end(); it ++)
+        total += it->size();
+    m_Amenity.reserve(total);
+    for(auto part = parts.begin(); part != parts.end(); part ++)
+    {
+        for(auto it = part->begin(); it != part->end(); it ++)
+        {
+            it->typeId = getTypeId(it->type);
+            m_AmenityTypeBucket[it->typeId].emplace_back(m_Amenity.size());
+            m_Amenity.emplace_back(std::move(*it));
+        }
+    }
+}
+
+double modelData::distanceToWay(QPointF pos, idType id, const wayData &way)
+{
+    PointSpan points = m_Geometry.points(id);
+    if(way.isPolygon && GeometryStore::containsPoint(points, pos))
+        return 0;
+    return GeometryStore::distanceToLine(points, pos);
+}
+
+void modelData::buildSpatialIndex()
+{
+    clock_t start = clock();
+
+    // the relations are assembled first, the buffer of the store is then filled once
+    vector<MultipolygonArea> areas = assembleAreas();
+    float areaTime = (clock() - start + 0.0)/CLOCKS_PER_SEC;
+
+    // every node is projected once here, the scene and the tiles read the same points
+    size_t points = 0;
+    for(auto it = m_WayMap.begin(); it != m_WayMap.end(); it ++)
+        points += it->second.nodeRefList.size();
+    for(auto it = areas.begin(); it != areas.end(); it ++)
+        points += it->points.size();
+    m_Geometry.clear();
+    m_Geometry.reserve(m_WayMap.size() + areas.size(), points);
+
+    vector<RTree::Entry> entries;
+    entries.reserve(m_WayMap.size());
+    for(auto it = m_WayMap.begin(); it != m_WayMap.end(); it ++)
+    {
+        if(it->second.nodeRefList.empty())
+            continue;
+        for(auto node = it->second.nodeRefList.begin(); node != it->second.nodeRefList.end(); node ++)
+            m_Geometry.addPoint(projection(m_NodesLocation.get(*node)));
+        m_Geometry.finishWay(it->first, it->second.isPolygon);
+        RTree::Entry entry;
+        entry.box = m_Geometry.bounds(it->first);
+        entry.id = it->first;
+        entries.emplace_back(entry);
+    }
+    m_WayIndex.bulkLoad(entries);
+
+    m_AreaMap.clear();
+    for(auto it = areas.begin(); it != areas.end(); it ++)
+    {
+        auto point = it->points.begin();
+        for(auto ring = it->rings.begin(); ring != it->rings.end(); ring ++)
+        {
+            for(uint32_t i = 0; i < *ring; i ++, point ++)
+                m_Geometry.addPoint(*point);
+            m_Geometry.finishRing();
+        }
+        m_Geometry.finishWay(GeometryStore::areaKey(it->id), true);
+        m_AreaMap[it->id] = it->type;
+    }
+    std::cout << "multipolygon areas assembled: " << m_AreaMap.size() << ", cpu time: " << areaTime << "s" << std::endl;
+
+    float t = (clock() - start + 0.0)/CLOCKS_PER_SEC;
+    std::cout << "time used for building the spatial index of " << m_WayIndex.size() << " ways: " << t << "s" << std::endl;
+}
+
+// the "name" tag and the most telling tag of a feature, as shown to the user
+static void describe(const vector<tagPair> &tags, string &name, string &type)
+{
+    static const char *keys[] = {"amenity", "shop", "tourism", "leisure", "highway", "building", "landuse", "natural"};
+    size_t rank = sizeof(keys) / sizeof(keys[0]);
+    for(auto it = tags.begin(); it != tags.end(); it ++)
+    {
+        if(it->first == "name")
+            name = it->second;
+        for(size_t i = 0; i < rank; i ++)
+        {
+            if(it->first == keys[i])
+            {
+                rank = i;
+                type = it->first == "building" && it->second == "yes" ? "building" : it->second;
+                break;
+            }
+        }
+    }
+}
+
+void modelData::buildReverseGeocoder()
+{
+    clock_t start = clock();
+
+    m_Geocoder.clear();
+    for(auto it = m_NodeMap.begin(); it != m_NodeMap.end(); it ++)
+    {
+        string name, type;
+        describe(it->second.tagList, name, type);
+        if(!name.empty())
+            m_Geocoder.addPoi(it->first, name, type, projection(m_NodesLocation.get(it->first)));
+    }
+    for(auto it = m_WayMap.begin(); it != m_WayMap.end(); it ++)
+    {
+        if(it->second.nodeRefList.empty())
+            continue;
+        string name, type;
+        describe(it->second.tagList, name, type);
+        if(it->second.isPolygon)
+        {
+            m_Geocoder.addArea(it->first, name, type, m_Geometry.polygon(it->first));
+            if(!name.empty())
+                m_Geocoder.addPoi(it->first, name, type, m_Geometry.centroid(it->first));
+        }
+        else if(!name.empty())
+        {
+            const vector<tagPair> &tags = it->second.tagList;
+            bool highway = find_if(tags.begin(), tags.end(), [](const tagPair &tag)
+            {
+                return tag.first == "highway";
+            }) != tags.end();
+            if(highway)
+                m_Geocoder.addStreet(it->first, name, type, m_Geometry.polygon(it->first));
+        }
+    }
+    m_Geocoder.build();
+
+    float t = (clock() - start + 0.0)/CLOCKS_PER_SEC;
+    std::cout << "time used for building the reverse geocoder: " << t << "s (" << m_Geocoder.poiCount() << " places, "
+              << m_Geocoder.areaCount() << " areas, " << m_Geocoder.streetCount() << " streets)" << std::endl;
+}
+
+const ReverseGeocoder &modelData::getReverseGeocoder()
+{
+    return m_Geocoder;
+}
+
+static bool isRoad(const wayData &way)
+{
+    for(auto it = way.tagList.begin(); it != way.tagList.end(); it ++)
+    {
+        if(it->first == "highway")
+            return true;
+    }
+    return false;
+}
+
+// addr:street (addr:place for the places without street), addr:housenumber and addr:postcode
+static bool readAddress(const vector<tagPair> &tags, AddressIndex::Address &address)
+{
+    string place;
+    for(auto it = tags.begin(); it != tags.end(); it ++)
+    {
+        if(it->first.compare(0, 5, "addr:") != 0)
+            continue;
+        if(it->first == "addr:street")
+            address.street = it->second;
+        else if(it->first == "addr:place")
+            place = it->second;
+        else if(it->first == "addr:housenumber")
+            address.housenumber = it->second;
+        else if(it->first == "addr:postcode")
+            address.postcode = it->second;
+    }
+    if(address.street.empty())
+        address.street = place;
+    return !address.street.empty() && !address.housenumber.empty();
+}
+
+void modelData::buildAddressIndex()
+{
+    clock_t start = clock();
+
+    m_Addresses.clear();
+    for(auto it = m_NodeMap.begin(); it != m_NodeMap.end(); it ++)
+    {
+        AddressIndex::Address address;
+        if(!readAddress(it->second.tagList, address))
+            continue;
+        address.id = it->first;
+        address.position = projection(m_NodesLocation.get(it->first));
+        m_Addresses.addAddress(address);
+    }
+    for(auto it = m_WayMap.begin(); it != m_WayMap.end(); it ++)
+    {
+        if(it->second.nodeRefList.empty())
+            continue;
+        AddressIndex::Address address;
+        if(readAddress(it->second.tagList, address))
+        {
+            address.id = it->first;
+            address.position = getWayCentroid(it->first);
+            m_Addresses.addAddress(address);
+        }
+        else if(isRoad(it->second))
+        {
+            // the middle node, the center of the box can be far from a curved street
+            const vector<idType> &nodes = it->second.nodeRefList;
+            for(auto tag = it->second.tagList.begin(); tag != it->second.tagList.end(); tag ++)
+            {
+                if(tag->first == "name")
+                    m_Addresses.addStreet(tag->second, projection(m_NodesLocation.get(nodes[nodes.size() / 2])));
+            }
+        }
+    }
+
+    float t = (clock() - start + 0.0)/CLOCKS_PER_SEC;
+    std::cout << "time used for building the address index: " << t << "s (" << m_Addresses.addresses().size() << " addresses, "
+              << m_Addresses.streetCount() << " streets)" << std::endl;
+}
+
+const AddressIndex &modelData::getAddressIndex()
+{
+    return m_Addresses;
+}
+
+AddressIndex::Result modelData::geocodeAddress(const string &query)
+{
+    AddressIndex::Result result = m_Addresses.lookup(query);
+    if(result.found)
+        result.node = snapToRoad(result.position);
+    return result;
+}
+
+idType modelData::snapToRoad(QPointF pos)
+{
+    return snapToWay(pos, isRoad);
+}
+
+idType modelData::snapToRoad(QPointF pos, travelMode mode)
+{
+    return snapToWay(pos, [mode](const wayData &way) { return isRoutable(mode, way.tagList); });
+}
+
+idType modelData::snapToWay(QPointF pos, const function<bool(const wayData &)> &accept)
+{
+    // the box distance is a lower bound of the distance to any node of the way
+    idType best = 0;
+    double bestDistance2 = numeric_limits<double>::max();
+    m_WayIndex.visitNearest(pos, [&](idType id, double boxDistance2)
+    {
+        if(boxDistance2 > bestDistance2)
+            return false;
+        const wayData &way = m_WayMap.at(id);
+        if(!accept(way))
+            return true;
+        for(auto it = way.nodeRefList.begin(); it != way.nodeRefList.end(); it ++)
+        {
+            QPointF d = projection(m_NodesLocation.get(*it)) - pos;
+            double distance2 = QPointF::dotProduct(d, d);
+            if(distance2 < bestDistance2)
+            {
+                bestDistance2 = distance2;
+                best = *it;
             }
         }
+        return true;
+    });
+    return best;
+}
+
+vector<idType> modelData::searchWayInRect(const QRectF &rect)
+{
+    return m_WayIndex.search(rect);
+}
+
+idType modelData::searchPolygonAt(QPointF pos)
+{
+    vector<idType> candidates;
+    m_WayIndex.searchPoint(pos, candidates);
+
+    // same order as the scene: highest polygon type first, then the smallest area
+    idType best = 0;
+    polygonType bestType = residential;
+    double bestArea = 0;
+    for(auto it = candidates.begin(); it != candidates.end(); it ++)
+    {
+        auto way = m_WayMap.find(*it);
+        if(way == m_WayMap.end() || !way->second.isPolygon)
+            continue;
+        QRectF box = m_Geometry.bounds(*it);
+        double area = box.width() * box.height();
+        if(best != 0 && (way->second.pType < bestType || (way->second.pType == bestType && area >= bestArea)))
+            continue;
+        if(!GeometryStore::containsPoint(m_Geometry.points(*it), pos))
+            continue;
+        best = *it;
+        bestType = way->second.pType;
+        bestArea = area;
     }
+    return best;
+}
+
+vector<idType> modelData::searchNearestWay(QPointF pos, size_t k)
+{
+    // the box distance is a lower bound of the real distance, so the search can stop
+    // as soon as the next box is further than the k-th way found so far
+    vector<pair<double, idType>> best;
+    if(k == 0)
+        return vector<idType>();
+    m_WayIndex.visitNearest(pos, [&](idType id, double boxDistance2)
+    {
+        if(best.size() == k && boxDistance2 > best.back().first * best.back().first)
+            return false;
+        auto way = m_WayMap.find(id);
+        if(way == m_WayMap.end())
+            return true;
+        pair<double, idType> candidate(distanceToWay(pos, id, way->second), id);
+        best.insert(upper_bound(best.begin(), best.end(), candidate), candidate);
+        if(best.size() > k)
+            best.pop_back();
+        return true;
+    });
+
+    vector<idType> result;
+    for(auto it = best.begin(); it != best.end(); it ++)
+        result.emplace_back(it->second);
+    return result;
+}
+
+QRectF modelData::getWayBounds(idType id)
+{
+    return m_Geometry.bounds(id);
+}
+
+QPointF modelData::getWayCentroid(idType id)
+{
+    return m_Geometry.centroid(id);
+}
+
+const GeometryStore &modelData::getGeometry()
+{
+    return m_Geometry;
+}
+
+QRectF modelData::getBounds()
+{
+    return m_WayIndex.bounds();
 }
@@ -0,0 +1,84 @@
+#include "multipolygon.h"
+#include <unordered_map>
+#include <algorithm>
+
+vector<vector<idType>> joinRings(const vector<const vector<idType> *> &ways)
+{
+    // ends of the pieces not used yet, a way is found by the node it starts or ends with
+    unordered_multimap<idType, size_t> ends;
+    for(size_t i = 0; i < ways.size(); i ++)
+    {
+        if(ways[i]->size() < 2)
+            continue;
+        ends.emplace(ways[i]->front(), i);
+        ends.emplace(ways[i]->back(), i);
+    }
+    vector<bool> used(ways.size(), false);
+    auto take = [&](size_t i)
+    {
+        used[i] = true;
+        for(idType node : {ways[i]->front(), ways[i]->back()})
+        {
+            auto range = ends.equal_range(node);
+            for(auto it = range.first; it != range.second; it ++)
+            {
+                if(it->second == i)
+                {
+                    ends.erase(it);
+                    break;
+                }
+            }
+        }
+    };
+
+    vector<vector<idType>> rings;
+    for(size_t i = 0; i < ways.size(); i ++)
+    {
+        if(used[i] || ways[i]->size() < 2)
+            continue;
+        vector<idType> ring(*ways[i]);
+        take(i);
+        while(ring.front() != ring.back())
+        {
+            auto next = ends.find(ring.back());
+            if(next == ends.end())
+                break;
+            const vector<idType> &way = *ways[next->second];
+            take(next->second);
+            if(way.front() == ring.back())
+                ring.insert(ring.end(), way.begin() + 1, way.end());
+            else
+                ring.insert(ring.end(), way.rbegin() + 1, way.rend());
+        }
+        if(ring.front() == ring.back() && ring.size() >= 4)
+            rings.emplace_back(std::move(ring));
+    }
+    return rings;
+}
+
+double ringArea(const vector<QPointF> &ring)
+{
+    double area = 0;
+    for(size_t i = 0; i + 1 < ring.size(); i ++)
+    {
+        QPointF a = ring[i] - ring[0];
+        QPointF b = ring[i + 1] - ring[0];
+        area += a.x() * b.y() - b.x() * a.y();
+    }
+    return area / 2;
+}
+
+void appendRings(vector<QPointF> &points, vector<uint32_t> &rings, vector<vector<QPointF>> &outer, vector<vector<QPointF>> &inner)
+{
+    auto append = [&](vector<QPointF> &ring, bool positive)
+    {
+        if((ringArea(ring) > 0) != positive)
+            reverse(ring.begin(), ring.end());
+        points.insert(points.end(), ring.begin(), ring.end());
+        rings.push_back(ring.size());
+    };
+    for(auto it = outer.begin(); it != outer.end(); it ++)
+        append(*it, true);
+    for(auto it = inner.begin(); it != inner.end(); it ++)
+        append(*it, false);
+}
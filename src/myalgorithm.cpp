@@ -11,53 +11,98 @@ MyAlgorithm::MyAlgorithm()// Default constructor
   cout<<"\nDear User This Algorithm Needs Graph to Work with!\n";
 }
 //===========================================================================
-MyAlgorithm::MyAlgorithm(graph_t const& AnyGraph,GraphMap AnyGraphMap ,idType VSource2){
+MyAlgorithm::MyAlgorithm(graph_t const& AnyGraph,GraphMap const& AnyGraphMap ,vector<costType> const& AnyWeights,idType VSource2, searchQueue Kind){
+  MyGraph2 = AnyGraph;
+  Weights  = AnyWeights;
+  auto found = AnyGraphMap.find(VSource2);
+  if (found == AnyGraphMap.end()) {
+      cout<<"\nThe Source is not on the Graph...\n";
+      emptyFlag = 0;
+      src = 0;
+      return;
+    }
+  src      = found->second ;
+  run(Kind);
+}// End of Parameters Constructor
+//===========================================================================
+// the search itself, the same result with either queue
+void MyAlgorithm::run(searchQueue Kind){
   // starting a clock to measure time
   double duration;
   clock_t start, stop;
   start = clock();
   //===================================================
-  unsigned int VSource = AnyGraphMap.find(VSource2)->second;
-  MyGraph2 = AnyGraph;
-  src      = VSource ;
   predecessors.resize(num_vertices(MyGraph2));
   distances.resize(num_vertices(MyGraph2)) ;
+  edgePredecessors.resize(num_vertices(MyGraph2));
 
-  dijkstra_shortest_paths(MyGraph2, src,
-                          predecessor_map(make_iterator_property_map(predecessors.begin(), get(boost::vertex_index, MyGraph2)))
-                          .distance_map(boost::make_iterator_property_map(distances.begin(), get(boost::vertex_index, MyGraph2))));
+  if (Kind == RadixQueue)
+    radixDijkstra();
+  else
+    // the edge that reached each vertex is kept too, the route geometry is read from it
+    dijkstra_shortest_paths(MyGraph2, src,
+                            predecessor_map(make_iterator_property_map(predecessors.begin(), get(boost::vertex_index, MyGraph2)))
+                            .distance_map(boost::make_iterator_property_map(distances.begin(), get(boost::vertex_index, MyGraph2)))
+                            .weight_map(make_iterator_property_map(Weights.begin(), get(&EdgeInfo::index, MyGraph2)))
+                            .visitor(make_dijkstra_visitor(record_edge_predecessors(
+                                       make_iterator_property_map(edgePredecessors.begin(), get(boost::vertex_index, MyGraph2)), on_edge_relaxed()))));
   //=====================================================================
   stop = clock();
   duration = double(stop - start);
   //=====================================================================
   cout<<"\n Algorithm was running for: \t"<<(duration/CLOCKS_PER_SEC)<<endl;
-}// End of Parameters Constructor
+}
+//===========================================================================
+// Dijkstra on the integer costs with a radix heap, the predecessors are left like boost does:
+// a vertex not reached is its own predecessor and its distance is the largest cost
+void MyAlgorithm::radixDijkstra(){
+  const costType Infinity = numeric_limits<costType>::max();
+  for (unsigned int v = 0; v < predecessors.size(); v++) {
+      predecessors[v] = v;
+      distances[v] = Infinity;
+    }
+  Queue.clear();
+  distances[src] = 0;
+  Queue.push(0, src);
+  while (!Queue.empty()) {
+      pair<costType, unsigned int> Top = Queue.pop();
+      unsigned int u = Top.second;
+      // stale entry, the vertex was reached at a lower cost since
+      if (Top.first != distances[u]) continue;
+      graph_traits<graph_t>::out_edge_iterator e, end;
+      for (tie(e, end) = out_edges(u, MyGraph2); e != end; ++e) {
+          unsigned int v = target(*e, MyGraph2);
+          costType Weight = Weights[MyGraph2[*e].index];
+          // closed in the profile, and the sum is checked against overflow like closed_plus in boost
+          if (Weight == COST_INFINITE || Weight > Infinity - Top.first) continue;
+          costType Cost = Top.first + Weight;
+          if (Cost < distances[v]) {
+              distances[v] = Cost;
+              predecessors[v] = u;
+              edgePredecessors[v] = *e;
+              Queue.push(Cost, v);
+            }
+        }
+    }
+}
 //===========================================================================
 MyAlgorithm::~MyAlgorithm(){ //Destructur
 }
 //===========================================================================
 // Accessors
 // function to get ShortPath
-Path MyAlgorithm::getShortPath(GraphMap AnyGraphMap,idType destination2) {
+Path MyAlgorithm::getShortPath(GraphMap const& AnyGraphMap,idType destination2) {
   ResetShortPath();
   unsigned int destination;
   idType Source = 0;
-  GraphMap::iterator it;
-  destination = AnyGraphMap.find(destination2)->second;
-  while (destination != MyGraph2.null_vertex()) {
-// index to idType Look-up table
-      for (it = AnyGraphMap.begin(); it != AnyGraphMap.end(); it++)
-        {
-          if (it->second == destination)
-            setShortPath(it->first);
-        }
+  // a destination off the graph of the profile is unreachable
+  auto found = AnyGraphMap.find(destination2);
+  destination = found != AnyGraphMap.end() ? found->second : 0;
+  while (found != AnyGraphMap.end() && destination != MyGraph2.null_vertex()) {
+      // the OSM node is a property of the vertex
+      setShortPath(MyGraph2[destination].node);
       if (destination == src){
-          // index to idType Look-up table
-          for (it = AnyGraphMap.begin(); it != AnyGraphMap.end(); it++)
-            {
-              if (it->second == src)
-                Source = it->first;
-            }
+          Source = MyGraph2[src].node;
           cout<<" Source \t"<< Source <<endl;
           cout<<" Destination \t"<< destination2 <<endl;
           reverse(ShortPath.begin(),ShortPath.end());
@@ -76,6 +121,47 @@ Path MyAlgorithm::getShortPath(GraphMap AnyGraphMap,idType destination2) {
   return ShortPath;
   //throw std::runtime_error("Unreachable");
 }
+//===========================================================================
+// function to get the Route: the points, ways and lengths are properties of the graph,
+// read while walking back the predecessors
+RouteGeometry MyAlgorithm::getRoute(GraphMap const& AnyGraphMap,idType destination2) {
+  RouteGeometry Route;
+  auto found = AnyGraphMap.find(destination2);
+  if (!emptyFlag || found == AnyGraphMap.end())
+    return Route;
+  // Vertices from the destination back to the source
+  vector <unsigned int> Vertices;
+  unsigned int destination = found->second;
+  Vertices.push_back(destination);
+  while (destination != src) {
+      if (predecessors.at(destination) == destination)
+        return Route; // unreachable
+      destination = predecessors.at(destination);
+      Vertices.push_back(destination);
+    }
+  reverse(Vertices.begin(), Vertices.end());
+  //===================================================
+  Route.nodes.reserve(Vertices.size());
+  Route.points.reserve(Vertices.size());
+  Route.distance.reserve(Vertices.size());
+  Route.ways.reserve(Vertices.size() - 1);
+  Route.roads.reserve(Vertices.size() - 1);
+  for (size_t i = 0; i < Vertices.size(); i++) {
+      const VertexInfo &Info = MyGraph2[Vertices[i]];
+      Route.nodes.push_back(Info.node);
+      Route.points.push_back(Info.point);
+      if (i == 0) {
+          Route.distance.push_back(0);
+          continue;
+        }
+      // the edge from the previous vertex
+      const EdgeInfo &Segment = MyGraph2[edgePredecessors.at(Vertices[i])];
+      Route.distance.push_back(Route.distance.back() + Segment.length);
+      Route.ways.push_back(Segment.way);
+      Route.roads.push_back(Segment.road);
+    }
+  return Route;
+}
 
 // function to call the Graph
 graph_t MyAlgorithm::getGraph(){
@@ -85,6 +171,9 @@ graph_t MyAlgorithm::getGraph(){
 bool MyAlgorithm::getFlag(){
   return emptyFlag;
 }
+vector <costType> const& MyAlgorithm::getDistances() const {
+  return distances;
+}
 //===========================================================================
 // Mutators
 //function to inject node to Short Path
@@ -13,7 +13,7 @@ MyGraphBuilder::MyGraphBuilder() // default Constructor
   //==========================================================
 } // end of Default Constructor
 //===========================================================================
-MyGraphBuilder::MyGraphBuilder(Model YourModel){  // Parameters Constructor
+MyGraphBuilder::MyGraphBuilder(Model &YourModel){  // Parameters Constructor
 
   //==========================================================
   OurModel = &YourModel;
@@ -38,87 +38,87 @@ void MyGraphBuilder::generateGraph() {
   GraphMap BelalMap;
   //Iterators for looping the maps
   WayMap::iterator it;
-  //GraphMap::iterator ite;
-  // Counter of all Nodes in OSM File
-  unsigned int Nodecount = 0;
   // IdMap Index
   unsigned int IdMapIndex = 0;
-  //unsigned int NodesOfWayIndex =0;
   unsigned int NodesOfWayIndex; //define Index
   unsigned int Node1 = 0;
   unsigned int Node2 = 0;
   //===================================================
-  //===================================================
-  // counting My Nodes
-  for ( it = MyWayMap.begin(); it != MyWayMap.end(); it++ ){
-      // Loop The Nodes of Each way
-      auto &nodes = it->second.nodeRefList;
-      for (auto i1 = nodes.begin(), i2 = i1 + 1 ; i2 != nodes.end(); ++i1, ++i2) {
-          Nodecount++;
-        }// end of Inner Loop
-
-    }// end of Outer Loop
-  //---------------------------------------------------
-  // graph with node count vertices
-  MyGraph = graph_t(Nodecount);
+  // the graph grows with the edges, the vertices without any are added at the end
+  MyGraph = graph_t();
+  for(int m = 0; m < MODE_COUNT; m++) MyWeights[m].clear();
   idType VertexID = 0; // define Variable to Store Vertix Index
-  // define a map to store Nodes ID
-  //auto idmap = get(boost::vertex_name, MyGraph);
+  // vertex properties by vertex index, given to the graph once every vertex exists
+  vector<VertexInfo> Infos(1);
   int WayCounter = 0;
+  unsigned int EdgeIndex = 0;
   //===================================================
   // Loop the Whole Map of Ways
   for ( it = MyWayMap.begin(); it != MyWayMap.end(); it++ ){
+      // what each profile makes of the way, the ways none can take are left out
+      WayAccess Access[MODE_COUNT];
+      bool Routable = false;
+      for(int m = 0; m < MODE_COUNT; m++){
+          Access[m] = wayAccess(static_cast<travelMode>(m), it->second.tagList);
+          Routable = Routable || Access[m].forward || Access[m].backward;
+        }
+      if(!Routable) continue;
       WayCounter++;
       NodesOfWayIndex = 0; //reset Index
-      //define a vector of nodes with size of Way
-      vector<Vertex> WayNodes(it->second.nodeRefList.size());
+      // location of the previous node of the way
+      osmium::Location Previous;
       //======================================================
       // Loop The Nodes of Each way
       for(auto j = it->second.nodeRefList.begin(); j != it->second.nodeRefList.end(); ++j){
 
-          VertexID = it->second.nodeRefList.at(NodesOfWayIndex);
-          //declare Variable for Eucledean Distance
-          double dist = 0;
-          WayNodes[NodesOfWayIndex] = VertexID ;
+          VertexID = *j;
+          // each location is read once, for the vertex and for the edge to the previous node
+          osmium::Location Location = OurModel->getNodeLoaction(VertexID);
           //---------------------------------------------------------------------
-          // if the VertexId doesn't exist yet give back do the following
-          if(BelalMap.find(VertexID) == BelalMap.end()){
-              // assign idType values to the idmap
-              //idmap[IdMapIndex] = VertexID;
+          // if the VertexId doesn't exist yet give it the next index
+          auto Found = BelalMap.find(VertexID);
+          if(Found == BelalMap.end()){
               IdMapIndex++;
               // Fill BelalMap
               BelalMap.insert({VertexID,IdMapIndex});
-              if(NodesOfWayIndex == 0) Node1 = IdMapIndex;
-              else {
-                  Node2 = IdMapIndex ;
-                  dist = distance(WayNodes[NodesOfWayIndex - 1], WayNodes[NodesOfWayIndex]);
-                  add_edge(Node1, Node2,dist,MyGraph);
-                  add_edge(Node2, Node1,dist,MyGraph);
-                  Node1 = Node2 ;
-                } // end else
-            }//end of outer if
+              VertexInfo Info;
+              Info.node = VertexID;
+              Info.point = projection(Location);
+              Infos.push_back(Info);
+              Node2 = IdMapIndex;
+            }//end of if
           //--------------------------------------------------------------------
           //if the VertexId already exists give back it's Vertex number
-          else {
-              if(NodesOfWayIndex == 0) Node1 = BelalMap.find(VertexID)->second;
-              else {
-                  // Calculating Eucledan Distance Between Nodes
-                  dist = distance(WayNodes[NodesOfWayIndex - 1], WayNodes[NodesOfWayIndex]);
-                  Node2 = BelalMap.find(VertexID)->second;
-                  add_edge(Node1, Node2,dist,MyGraph);
-                  add_edge(Node2, Node1,dist,MyGraph);
-                  Node1 = Node2 ;
-                }// end of inner else
-            }//end of outer else
-
+          else Node2 = Found->second;
+          if(NodesOfWayIndex > 0){
+              EdgeInfo Info;
+              Info.length = distance(Previous, Location);
+              Info.way = it->first;
+              Info.road = it->second.rType;
+              // along the way, then against it, each with its weight in every profile
+              Info.index = EdgeIndex++;
+              add_edge(Node1, Node2, Info, MyGraph);
+              Info.index = EdgeIndex++;
+              add_edge(Node2, Node1, Info, MyGraph);
+              for(int m = 0; m < MODE_COUNT; m++){
+                  costType Cost = cost(Info.length, Access[m].speed);
+                  MyWeights[m].push_back(Access[m].forward ? Cost : COST_INFINITE);
+                  MyWeights[m].push_back(Access[m].backward ? Cost : COST_INFINITE);
+                }
+            }
+          Node1 = Node2;
+          Previous = Location;
           //======================================================
           // increase The indexs after iterating each node.
           NodesOfWayIndex++;
         }// end of Nodes of Way Loop
     }// end of Ways of Map Loop
+  // the nodes of one-node ways have no edge, their vertex may not exist yet
+  while(num_vertices(MyGraph) < Infos.size()) add_vertex(MyGraph);
+  for(unsigned int i = 1; i < Infos.size(); i++) MyGraph[i] = Infos[i];
   MyGraphMap = BelalMap ;
   //  cout<<"size of Belal Map is :\t"<<BelalMap.size()<<endl;
-  cout<<"\nCount of Ways is :\t"<<WayCounter<<endl;
+  cout<<"\nCount of Routable Ways is :\t"<<WayCounter<<endl;
   cout<<"Graph Was Built ..."<<endl;
   //=======================
   stop = clock();
@@ -128,20 +128,18 @@ void MyGraphBuilder::generateGraph() {
 }//end of Genrate Function
 
 //================================================================
-// Function to calculate Euclidean Distance between Vertices
+// Function to calculate the great circle Distance between Vertices, in meters
 double MyGraphBuilder::distance(Vertex Nod1_ID, Vertex Nod2_ID){
-  double dist = 0; // distance
-  auto  L1 = OurModel->getNodeLoaction(Nod1_ID) ; // get first location
-  auto  L2 = OurModel->getNodeLoaction(Nod2_ID) ; // get second location
-  //-------------------------------------------------
-  double x1 = L1.lat(); // first location latitude
-  double x2 = L2.lat(); // second location latitude
-  double y1 = L1.lon(); // first location longitude
-  double y2 = L2.lon(); // second location longitude
-  //-------------------------------------------------
-  dist = sqrt(pow((x1-x2),2)+pow((y1-y2),2));
-
-  return 1000000*dist;
+  return distance(OurModel->getNodeLoaction(Nod1_ID), OurModel->getNodeLoaction(Nod2_ID));
+}
+// same between two locations
+double MyGraphBuilder::distance(osmium::Location L1, osmium::Location L2){
+  return osmium::geom::haversine::distance(L1, L2);
+}
+// travel time rounded to the millisecond, speed in km/h
+costType MyGraphBuilder::cost(double meters, double speed){
+  if(speed <= 0) return COST_INFINITE;
+  return static_cast<costType>(llround(meters * 3600 / speed));
 }
 //================================================================
 // Accessors
@@ -149,6 +147,7 @@ graph_t const&  MyGraphBuilder::getGraph() const { return MyGraph; }
 graph_t&        MyGraphBuilder::getGraph()       { return MyGraph; }
 GraphMap const& MyGraphBuilder::getGraphMap() const { return MyGraphMap; }
 GraphMap        MyGraphBuilder::getGraphMap()       { return MyGraphMap; }
+vector<costType> const& MyGraphBuilder::getWeights(travelMode Mode) const { return MyWeights[Mode]; }
 //================================================================
 // Mutators
 void MyGraphBuilder::setGraph(graph_t YourGraph){
@@ -0,0 +1,209 @@
+#include "prefixindex.h"
+#include "textnormalize.h"
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+#include <cmath>
+#include <limits>
+
+void PrefixIndex::clear()
+{
+    m_terms.clear();
+    m_entries.clear();
+    m_positions.clear();
+    m_sparse.clear();
+}
+
+void PrefixIndex::add(const string &text, uint32_t doc, uint32_t weight)
+{
+    addTerm(text, doc, weight, nullptr, 0);
+}
+
+void PrefixIndex::add(const string &text, uint32_t doc, uint32_t weight, QPointF position)
+{
+    addTerm(text, doc, weight, &position, 1);
+}
+
+void PrefixIndex::add(const string &text, uint32_t doc, uint32_t weight, const vector<QPointF> &positions)
+{
+    addTerm(text, doc, weight, positions.data(), positions.size());
+}
+
+void PrefixIndex::addTerm(const string &text, uint32_t doc, uint32_t weight, const QPointF *positions, size_t count)
+{
+    Term term;
+    term.text = text;
+    term.key = normalizeText(text);
+    term.doc = doc;
+    term.weight = weight;
+    term.firstPosition = m_positions.size();
+    term.positionCount = count;
+    if(term.key.empty())
+        return;
+    m_positions.insert(m_positions.end(), positions, positions + count);
+
+    uint32_t id = m_terms.size();
+    m_terms.emplace_back(term);
+    const string &key = m_terms.back().key;
+    for(size_t i = 0; i < key.size(); i ++)
+    {
+        if(i == 0 || key[i - 1] == ' ')
+            m_entries.push_back(Entry{id, static_cast<uint32_t>(i)});
+    }
+}
+
+void PrefixIndex::build()
+{
+    sort(m_entries.begin(), m_entries.end(), [this](const Entry &a, const Entry &b)
+    {
+        return m_terms[a.term].key.compare(a.offset, string::npos, m_terms[b.term].key, b.offset, string::npos) < 0;
+    });
+
+    // level 0 is the entries themselves, level j covers 2^j entries
+    m_sparse.clear();
+    size_t n = m_entries.size();
+    if(n == 0)
+        return;
+    m_sparse.emplace_back(vector<uint32_t>(n));
+    for(size_t i = 0; i < n; i ++)
+        m_sparse[0][i] = i;
+    for(size_t j = 1; (size_t(1) << j) <= n; j ++)
+    {
+        const vector<uint32_t> &previous = m_sparse[j - 1];
+        vector<uint32_t> level(n - (size_t(1) << j) + 1);
+        size_t half = size_t(1) << (j - 1);
+        for(size_t i = 0; i < level.size(); i ++)
+        {
+            uint32_t a = previous[i];
+            uint32_t b = previous[i + half];
+            level[i] = m_terms[m_entries[a].term].weight >= m_terms[m_entries[b].term].weight ? a : b;
+        }
+        m_sparse.emplace_back(level);
+    }
+}
+
+void PrefixIndex::range(const string &key, size_t &first, size_t &last) const
+{
+    auto lower = lower_bound(m_entries.begin(), m_entries.end(), key, [this](const Entry &e, const string &k)
+    {
+        return m_terms[e.term].key.compare(e.offset, string::npos, k) < 0;
+    });
+    auto upper = upper_bound(lower, m_entries.end(), key, [this](const string &k, const Entry &e)
+    {
+        // only the first characters count, every entry starting with the key is equal to it
+        return m_terms[e.term].key.compare(e.offset, k.size(), k) > 0;
+    });
+    first = lower - m_entries.begin();
+    last = upper - m_entries.begin();
+}
+
+uint32_t PrefixIndex::best(size_t first, size_t last) const
+{
+    size_t level = 0;
+    while((size_t(2) << level) <= last - first)
+        level ++;
+    uint32_t a = m_sparse[level][first];
+    uint32_t b = m_sparse[level][last - (size_t(1) << level)];
+    return m_terms[m_entries[a].term].weight >= m_terms[m_entries[b].term].weight ? a : b;
+}
+
+vector<uint32_t> PrefixIndex::topTerms(const string &prefix, size_t k, size_t budget, bool distinct) const
+{
+    vector<uint32_t> result;
+    string key = normalizeText(prefix);
+    if(m_entries.empty() || k == 0)
+        return result;
+
+    size_t first, last;
+    range(key, first, last);
+    if(first >= last)
+        return result;
+
+    // best first split of the range: take the best entry, then look at both sides of it
+    typedef tuple<uint32_t, uint32_t, uint32_t, uint32_t> part;   // weight, best entry, first, last
+    priority_queue<part> parts;
+    auto push = [&](size_t f, size_t l)
+    {
+        if(f >= l)
+            return;
+        uint32_t b = best(f, l);
+        parts.push(part(m_terms[m_entries[b].term].weight, b, f, l));
+    };
+    push(first, last);
+
+    unordered_set<string> seen;
+    size_t examined = 0;
+    while(!parts.empty() && result.size() < k && examined < budget)
+    {
+        part top = parts.top();
+        parts.pop();
+        examined ++;
+        uint32_t entry = get<1>(top);
+        uint32_t term = m_entries[entry].term;
+        if(!distinct || seen.insert(m_terms[term].text).second)
+            result.emplace_back(term);
+        push(get<2>(top), entry);
+        push(entry + 1, get<3>(top));
+    }
+    return result;
+}
+
+PrefixIndex::Suggestion PrefixIndex::suggestion(uint32_t term) const
+{
+    Suggestion s;
+    s.text = m_terms[term].text;
+    s.doc = m_terms[term].doc;
+    s.weight = m_terms[term].weight;
+    s.distance = 0;
+    return s;
+}
+
+vector<PrefixIndex::Suggestion> PrefixIndex::complete(const string &prefix, size_t k, size_t budget) const
+{
+    vector<Suggestion> result;
+    vector<uint32_t> terms = topTerms(prefix, k, budget, true);
+    for(auto it = terms.begin(); it != terms.end(); it ++)
+        result.emplace_back(suggestion(*it));
+    return result;
+}
+
+vector<PrefixIndex::Suggestion> PrefixIndex::completeNear(const string &prefix, size_t k, QPointF center, size_t budget) const
+{
+    // take as many candidates as the budget allows, then keep the k closest
+    // the duplicates are removed after the sort so that the closest one stays
+    vector<Suggestion> result;
+    vector<uint32_t> terms = topTerms(prefix, budget, budget, false);
+    for(auto it = terms.begin(); it != terms.end(); it ++)
+    {
+        // a type is as close as the closest of its places
+        Suggestion s = suggestion(*it);
+        const Term &term = m_terms[*it];
+        double closest = numeric_limits<double>::infinity();
+        for(uint32_t i = term.firstPosition; i < term.firstPosition + term.positionCount; i ++)
+        {
+            QPointF d = m_positions[i] - center;
+            closest = min(closest, QPointF::dotProduct(d, d));
+        }
+        if(term.positionCount > 0)
+            s.distance = sqrt(closest);
+        result.emplace_back(s);
+    }
+    stable_sort(result.begin(), result.end(), [](const Suggestion &a, const Suggestion &b)
+    {
+        return a.distance < b.distance;
+    });
+    unordered_set<string> seen;
+    vector<Suggestion> distinct;
+    for(auto it = result.begin(); it != result.end() && distinct.size() < k; it ++)
+    {
+        if(seen.insert(it->text).second)
+            distinct.emplace_back(*it);
+    }
+    return distinct;
+}
+
+size_t PrefixIndex::size() const
+{
+    return m_entries.size();
+}
@@ -0,0 +1,45 @@
+#include <radixheap.h>
+//===============================================
+using namespace std;
+//===============================================
+
+RadixHeap::RadixHeap() : Last(0), Size(0) {}
+//===========================================================================
+int RadixHeap::bucketOf(uint32_t Key, uint32_t Last) {
+  return Key == Last ? 0 : 32 - __builtin_clz(Key ^ Last);
+}
+//===========================================================================
+void RadixHeap::push(uint32_t Key, unsigned int Value) {
+  Buckets[bucketOf(Key, Last)].emplace_back(Key, Value);
+  Size++;
+}
+//===========================================================================
+pair<uint32_t, unsigned int> RadixHeap::pop() {
+  if (Buckets[0].empty()) {
+      // the first bucket in use holds the new minimum, its entries are spread below it
+      int i = 1;
+      while (Buckets[i].empty()) i++;
+      uint32_t Minimum = Buckets[i][0].first;
+      for (auto it = Buckets[i].begin(); it != Buckets[i].end(); ++it)
+        if (it->first < Minimum) Minimum = it->first;
+      Last = Minimum;
+      for (auto it = Buckets[i].begin(); it != Buckets[i].end(); ++it)
+        Buckets[bucketOf(it->first, Last)].push_back(*it);
+      Buckets[i].clear();
+    }
+  pair<uint32_t, unsigned int> Top = Buckets[0].back();
+  Buckets[0].pop_back();
+  Size--;
+  return Top;
+}
+//===========================================================================
+bool RadixHeap::empty() const { return Size == 0; }
+
+size_t RadixHeap::size() const { return Size; }
+
+void RadixHeap::clear() {
+  for (int i = 0; i < BUCKETS; i++) Buckets[i].clear();
+  Last = 0;
+  Size = 0;
+}
+//===================================================================
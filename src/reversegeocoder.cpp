@@ -0,0 +1,196 @@
+#include "reversegeocoder.h"
+#include "projection.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+void ReverseGeocoder::clear()
+{
+    m_poiInfo.clear();
+    m_poiPositions.clear();
+    m_areaInfo.clear();
+    m_areaOutlines.clear();
+    m_streetInfo.clear();
+    m_streetLines.clear();
+    m_poiIndex.clear();
+    m_areaIndex.clear();
+    m_streetIndex.clear();
+}
+
+void ReverseGeocoder::addPoi(idType id, const string &name, const string &type, QPointF pos)
+{
+    m_poiInfo.push_back(Info{id, name, type});
+    m_poiPositions.emplace_back(pos);
+}
+
+void ReverseGeocoder::addArea(idType id, const string &name, const string &type, const QPolygonF &outline)
+{
+    if(outline.size() < 3)
+        return;
+    m_areaInfo.push_back(Info{id, name, type});
+    m_areaOutlines.emplace_back(outline);
+}
+
+void ReverseGeocoder::addStreet(idType id, const string &name, const string &type, const QPolygonF &line)
+{
+    if(line.isEmpty())
+        return;
+    m_streetInfo.push_back(Info{id, name, type});
+    m_streetLines.emplace_back(line);
+}
+
+void ReverseGeocoder::build()
+{
+    vector<RTree::Entry> entries(m_poiPositions.size());
+    for(size_t i = 0; i < m_poiPositions.size(); i ++)
+    {
+        entries[i].box = QRectF(m_poiPositions[i], m_poiPositions[i]);
+        entries[i].id = i;
+    }
+    m_poiIndex.bulkLoad(std::move(entries));
+
+    entries.resize(m_areaOutlines.size());
+    for(size_t i = 0; i < m_areaOutlines.size(); i ++)
+    {
+        entries[i].box = m_areaOutlines[i].boundingRect();
+        entries[i].id = i;
+    }
+    m_areaIndex.bulkLoad(std::move(entries));
+
+    entries.resize(m_streetLines.size());
+    for(size_t i = 0; i < m_streetLines.size(); i ++)
+    {
+        entries[i].box = m_streetLines[i].boundingRect();
+        entries[i].id = i;
+    }
+    m_streetIndex.bulkLoad(std::move(entries));
+}
+
+ReverseGeocoder::Feature ReverseGeocoder::feature(const Info &info, double distance)
+{
+    Feature f;
+    f.id = info.id;
+    f.name = info.name;
+    f.type = info.type;
+    f.distance = distance;
+    return f;
+}
+
+double ReverseGeocoder::distanceToLine(QPointF pos, const QPolygonF &line)
+{
+    if(line.size() == 1)
+    {
+        QPointF d = pos - line[0];
+        return sqrt(QPointF::dotProduct(d, d));
+    }
+    double best = numeric_limits<double>::max();
+    for(int i = 0; i + 1 < line.size(); i ++)
+    {
+        QPointF a = line[i];
+        QPointF ab = line[i + 1] - a;
+        QPointF ap = pos - a;
+        double length2 = QPointF::dotProduct(ab, ab);
+        double t = length2 > 0 ? QPointF::dotProduct(ap, ab) / length2 : 0;
+        t = max(0.0, min(1.0, t));
+        QPointF d = ap - ab * t;
+        best = min(best, QPointF::dotProduct(d, d));
+    }
+    return sqrt(best);
+}
+
+double ReverseGeocoder::groundScale(QPointF pos)
+{
+    // the scene y is minus the mercator y, see projection()
+    const double earthRadius = 6378137.0;
+    double lat = 2 * atan(exp(-pos.y() / earthRadius)) - M_PI / 2;
+    return cos(lat);
+}
+
+ReverseGeocoder::Result ReverseGeocoder::lookup(QPointF pos, double maxDistance) const
+{
+    Result result;
+    const double scale = groundScale(pos);
+    maxDistance /= scale;
+
+    // the points are their own boxes, the first one visited is the nearest
+    m_poiIndex.visitNearest(pos, maxDistance, [&](idType i, double distance2)
+    {
+        result.poi = feature(m_poiInfo[i], sqrt(distance2) * scale);
+        return false;
+    });
+
+    // the smallest area containing the point, a building rather than the district around it
+    vector<idType> candidates;
+    m_areaIndex.searchPoint(pos, candidates);
+    double bestArea = numeric_limits<double>::max();
+    for(auto it = candidates.begin(); it != candidates.end(); it ++)
+    {
+        const QPolygonF &outline = m_areaOutlines[*it];
+        QRectF box = outline.boundingRect();
+        double area = box.width() * box.height();
+        if(area < bestArea && outline.containsPoint(pos, Qt::OddEvenFill))
+        {
+            bestArea = area;
+            result.area = feature(m_areaInfo[*it], 0);
+        }
+    }
+
+    // the box distance is a lower bound of the distance to the line
+    double best = maxDistance;
+    m_streetIndex.visitNearest(pos, maxDistance, [&](idType i, double distance2)
+    {
+        if(sqrt(distance2) > best)
+            return false;
+        double distance = distanceToLine(pos, m_streetLines[i]);
+        if(distance <= best)
+        {
+            best = distance;
+            result.street = feature(m_streetInfo[i], distance * scale);
+        }
+        return true;
+    });
+    return result;
+}
+
+ReverseGeocoder::Result ReverseGeocoder::lookup(const osmium::Location &location, double maxDistance) const
+{
+    return lookup(projection(location), maxDistance);
+}
+
+vector<ReverseGeocoder::Result> ReverseGeocoder::lookup(const vector<QPointF> &positions, double maxDistance, unsigned threads) const
+{
+    vector<Result> results(positions.size());
+    if(threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    threads = min<size_t>(threads, max<size_t>(1, positions.size()));
+
+    // consecutive positions of a GPS log are close, so each thread takes a contiguous range
+    auto work = [&](size_t first, size_t last)
+    {
+        for(size_t i = first; i < last; i ++)
+            results[i] = lookup(positions[i], maxDistance);
+    };
+    size_t step = (positions.size() + threads - 1) / threads;
+    vector<thread> workers;
+    for(size_t first = step; first < positions.size(); first += step)
+        workers.emplace_back(work, first, min(first + step, positions.size()));
+    work(0, min(step, positions.size()));
+    for(auto it = workers.begin(); it != workers.end(); it ++)
+        it->join();
+    return results;
+}
+
+size_t ReverseGeocoder::poiCount() const
+{
+    return m_poiInfo.size();
+}
+
+size_t ReverseGeocoder::areaCount() const
+{
+    return m_areaInfo.size();
+}
+
+size_t ReverseGeocoder::streetCount() const
+{
+    return m_streetInfo.size();
+}
@@ -0,0 +1,52 @@
+#include <routegeometry.h>
+//===============================================
+using namespace std;
+//===============================================
+
+bool RouteGeometry::empty() const { return points.size() < 2; }
+
+double RouteGeometry::length() const { return distance.empty() ? 0 : distance.back(); }
+//===========================================================================
+// steps: a new one starts wherever the way changes
+vector<RouteGeometry::Step> RouteGeometry::steps() const {
+  vector<Step> result;
+  for (size_t i = 0; i < ways.size(); i++) {
+      if (result.empty() || result.back().way != ways[i])
+        result.push_back(Step{ways[i], roads[i], i, i + 1, 0});
+      result.back().last = i + 1;
+      result.back().length = distance[i + 1] - distance[result.back().first];
+    }
+  return result;
+}
+
+void RouteGeometry::clear() {
+  nodes.clear();
+  points.clear();
+  distance.clear();
+  ways.clear();
+  roads.clear();
+}
+//===========================================================================
+// JSON writer, the ids are written as numbers like in the OSM API
+void RouteGeometry::writeJson(ostream &out) const {
+  out << "{\"length\":" << length() << ",\"points\":[";
+  for (size_t i = 0; i < points.size(); i++) {
+      if (i > 0) out << ",";
+      out << "[" << points[i].x() << "," << points[i].y() << "," << distance[i] << "]";
+    }
+  out << "],\"nodes\":[";
+  for (size_t i = 0; i < nodes.size(); i++) {
+      if (i > 0) out << ",";
+      out << nodes[i];
+    }
+  out << "],\"steps\":[";
+  vector<Step> list = steps();
+  for (size_t i = 0; i < list.size(); i++) {
+      if (i > 0) out << ",";
+      out << "{\"way\":" << list[i].way << ",\"road\":" << static_cast<int>(list[i].road)
+          << ",\"first\":" << list[i].first << ",\"last\":" << list[i].last
+          << ",\"length\":" << list[i].length << "}";
+    }
+  out << "]}";
+}
+//===================================================================
@@ -0,0 +1,153 @@
+#include <routingprofile.h>
+#include <cstdlib>
+#include <map>
+//===============================================
+using namespace std;
+//===============================================
+
+// value of a tag, empty when the way doesn't have it
+static string tagValue(const vector<tagPair> &Tags, const string &Key) {
+  for (auto it = Tags.begin(); it != Tags.end(); ++it)
+    if (it->first == Key) return it->second;
+  return "";
+}
+// the first of the keys the way has, the most specific one comes first
+static string firstValue(const vector<tagPair> &Tags, const vector<string> &Keys) {
+  for (auto it = Keys.begin(); it != Keys.end(); ++it) {
+      string Value = tagValue(Tags, *it);
+      if (!Value.empty()) return Value;
+    }
+  return "";
+}
+
+static bool isYes(const string &Value) {
+  return Value == "yes" || Value == "true" || Value == "1" || Value == "designated" || Value == "permissive";
+}
+
+static bool isDenied(const string &Value) {
+  return Value == "no" || Value == "private" || Value == "agricultural" || Value == "forestry";
+}
+//===========================================================================
+// maxspeed in km/h, 0 when it is not a number ("none", "signals"...)
+static double parseSpeed(const string &Value) {
+  if (Value == "walk") return 5;
+  char *End = nullptr;
+  double Speed = strtod(Value.c_str(), &End);
+  if (End == Value.c_str()) return 0;
+  if (Value.find("mph") != string::npos) Speed *= 1.609;
+  return Speed;
+}
+//===========================================================================
+// default speeds by highway class, km/h, a class missing can't be taken
+static const map<string, double> CarSpeeds = {
+  {"motorway", 110}, {"motorway_link", 60}, {"trunk", 90}, {"trunk_link", 50},
+  {"primary", 70}, {"primary_link", 40}, {"secondary", 60}, {"secondary_link", 40},
+  {"tertiary", 50}, {"tertiary_link", 30}, {"unclassified", 40}, {"residential", 30},
+  {"living_street", 10}, {"service", 20}, {"road", 30}
+};
+static const map<string, double> BicycleSpeeds = {
+  {"trunk", 18}, {"trunk_link", 18}, {"primary", 18}, {"primary_link", 18},
+  {"secondary", 18}, {"secondary_link", 18}, {"tertiary", 18}, {"tertiary_link", 18},
+  {"unclassified", 16}, {"residential", 16}, {"living_street", 10}, {"service", 14},
+  {"road", 16}, {"cycleway", 18}, {"track", 12}, {"path", 12},
+  // only where bicycles are allowed, see wayAccess
+  {"footway", 8}, {"pedestrian", 8}
+};
+static const map<string, double> FootSpeeds = {
+  {"primary", 5}, {"primary_link", 5}, {"secondary", 5}, {"secondary_link", 5},
+  {"tertiary", 5}, {"tertiary_link", 5}, {"unclassified", 5}, {"residential", 5},
+  {"living_street", 5}, {"service", 5}, {"road", 5}, {"cycleway", 5}, {"track", 5},
+  {"path", 5}, {"footway", 5}, {"pedestrian", 5}, {"steps", 2},
+  // only where pedestrians are allowed, see wayAccess
+  {"trunk", 5}, {"trunk_link", 5}
+};
+//===========================================================================
+WayAccess wayAccess(travelMode Mode, const vector<tagPair> &Tags) {
+  WayAccess Closed = {false, false, 0};
+  string Highway = tagValue(Tags, "highway");
+  if (Highway.empty()) return Closed;
+
+  const map<string, double> &Speeds = Mode == CarMode ? CarSpeeds : Mode == BicycleMode ? BicycleSpeeds : FootSpeeds;
+  auto Found = Speeds.find(Highway);
+  if (Found == Speeds.end()) return Closed;
+  WayAccess Access = {true, true, Found->second};
+
+  //---------------------------------------------------
+  // access, the tag of the mode wins over the general ones
+  string Allowed;
+  if (Mode == CarMode) Allowed = firstValue(Tags, {"motorcar", "motor_vehicle", "vehicle", "access"});
+  else if (Mode == BicycleMode) Allowed = firstValue(Tags, {"bicycle", "vehicle", "access"});
+  else Allowed = firstValue(Tags, {"foot", "access"});
+  if (isDenied(Allowed)) return Closed;
+  // the classes a bicycle or a pedestrian takes only when it is said so
+  if (Mode == BicycleMode && (Highway == "footway" || Highway == "pedestrian") && !isYes(tagValue(Tags, "bicycle")))
+    return Closed;
+  if (Mode == FootMode && (Highway == "trunk" || Highway == "trunk_link") && !isYes(tagValue(Tags, "foot")))
+    return Closed;
+  if (Mode == BicycleMode && Allowed == "dismount") Access.speed = 5;
+
+  //---------------------------------------------------
+  // speed limit, a car goes at the limit, a bicycle never above it
+  double Limit = parseSpeed(tagValue(Tags, "maxspeed"));
+  if (Limit > 0) {
+      if (Mode == CarMode) Access.speed = Limit;
+      else if (Limit < Access.speed) Access.speed = Limit;
+    }
+
+  //---------------------------------------------------
+  // direction, pedestrians only follow oneway:foot
+  string Oneway = tagValue(Tags, "oneway");
+  if (Mode == BicycleMode) {
+      string Cycleway = tagValue(Tags, "cycleway");
+      if (tagValue(Tags, "oneway:bicycle") == "no" || Cycleway.compare(0, 8, "opposite") == 0) Oneway = "no";
+    }
+  else if (Mode == FootMode) Oneway = tagValue(Tags, "oneway:foot");
+  // implied by the roundabouts and the motorways
+  if (Oneway.empty() && Mode != FootMode
+      && (tagValue(Tags, "junction") == "roundabout" || Highway == "motorway" || Highway == "motorway_link"))
+    Oneway = "yes";
+  if (Oneway == "yes" || Oneway == "true" || Oneway == "1") Access.backward = false;
+  else if (Oneway == "-1" || Oneway == "reverse") Access.forward = false;
+  return Access;
+}
+//===========================================================================
+bool isRoutable(travelMode Mode, const vector<tagPair> &Tags) {
+  WayAccess Access = wayAccess(Mode, Tags);
+  return Access.forward || Access.backward;
+}
+//===========================================================================
+// the sharper the turn the longer, the slight bends of a road cost nothing
+unsigned int turnPenalty(travelMode Mode, double Degrees) {
+  if (Mode == FootMode || Degrees < 30) return 0;
+  if (Mode == BicycleMode) return static_cast<unsigned int>(Degrees / 180 * 4000);
+  // a car turning around waits for the traffic both ways
+  if (Degrees > 170) return 30000;
+  return static_cast<unsigned int>(Degrees / 180 * 8000);
+}
+//===========================================================================
+bool restrictionFor(travelMode Mode, const vector<tagPair> &Tags, string &Value) {
+  if (tagValue(Tags, "type") != "restriction") return false;
+  // the vehicles of the mode in the "except" list and in the restriction:<vehicle> keys
+  const char *Vehicle = Mode == CarMode ? "motorcar" : Mode == BicycleMode ? "bicycle" : "foot";
+  string Except = ";" + tagValue(Tags, "except") + ";";
+  if (Except.find(string(";") + Vehicle + ";") != string::npos) return false;
+  Value = tagValue(Tags, string("restriction:") + Vehicle);
+  // the plain restrictions are for the vehicles, not for the pedestrians
+  if (Value.empty() && Mode != FootMode) Value = tagValue(Tags, "restriction");
+  return Value.compare(0, 3, "no_") == 0 || Value.compare(0, 5, "only_") == 0;
+}
+//===========================================================================
+const char *modeName(travelMode Mode) {
+  return Mode == CarMode ? "car" : Mode == BicycleMode ? "bicycle" : "foot";
+}
+
+bool modeFromName(const string &Name, travelMode &Mode) {
+  for (int i = 0; i < MODE_COUNT; i++) {
+      if (Name == modeName(static_cast<travelMode>(i))) {
+          Mode = static_cast<travelMode>(i);
+          return true;
+        }
+    }
+  return false;
+}
+//===================================================================
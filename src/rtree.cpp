@@ -0,0 +1,226 @@
+#include "rtree.h"
+#include <algorithm>
+
+void RTree::bulkLoad(vector<RTree::Entry> entries)
+{
+    clear();
+    if(entries.empty())
+        return;
+
+    Box total = toBox(entries.front().box);
+    for(auto it = entries.begin(); it != entries.end(); it ++)
+        total.expand(toBox(it->box));
+
+    // map the center of every box on a 16 bits grid and sort along the Hilbert curve
+    const double width = total.maxX - total.minX;
+    const double height = total.maxY - total.minY;
+    vector<pair<uint32_t, uint32_t>> order(entries.size());
+    for(size_t i = 0; i < entries.size(); i ++)
+    {
+        QPointF center = entries[i].box.center();
+        uint32_t x = width > 0 ? static_cast<uint32_t>(0xFFFF * (center.x() - total.minX) / width) : 0;
+        uint32_t y = height > 0 ? static_cast<uint32_t>(0xFFFF * (center.y() - total.minY) / height) : 0;
+        order[i] = make_pair(hilbert(x, y), static_cast<uint32_t>(i));
+    }
+    sort(order.begin(), order.end());
+
+    m_itemBoxes.reserve(entries.size());
+    m_itemIds.reserve(entries.size());
+    for(auto it = order.begin(); it != order.end(); it ++)
+    {
+        m_itemBoxes.emplace_back(toBox(entries[it->second].box));
+        m_itemIds.emplace_back(entries[it->second].id);
+    }
+
+    // leaf level, NODE_SIZE consecutive items per node
+    for(uint32_t first = 0; first < m_itemBoxes.size(); first += NODE_SIZE)
+    {
+        Node node;
+        node.first = first;
+        node.last = min<uint32_t>(first + NODE_SIZE, m_itemBoxes.size());
+        node.leaf = true;
+        node.box = m_itemBoxes[first];
+        for(uint32_t i = first + 1; i < node.last; i ++)
+            node.box.expand(m_itemBoxes[i]);
+        m_nodes.emplace_back(node);
+    }
+
+    // upper levels until there is only the root left
+    uint32_t levelBegin = 0;
+    uint32_t levelEnd = m_nodes.size();
+    while(levelEnd - levelBegin > 1)
+    {
+        for(uint32_t first = levelBegin; first < levelEnd; first += NODE_SIZE)
+        {
+            Node node;
+            node.first = first;
+            node.last = min<uint32_t>(first + NODE_SIZE, levelEnd);
+            node.leaf = false;
+            node.box = m_nodes[first].box;
+            for(uint32_t i = first + 1; i < node.last; i ++)
+                node.box.expand(m_nodes[i].box);
+            m_nodes.emplace_back(node);
+        }
+        levelBegin = levelEnd;
+        levelEnd = m_nodes.size();
+    }
+}
+
+void RTree::clear()
+{
+    m_itemBoxes.clear();
+    m_itemIds.clear();
+    m_nodes.clear();
+}
+
+size_t RTree::size() const
+{
+    return m_itemIds.size();
+}
+
+bool RTree::empty() const
+{
+    return m_itemIds.empty();
+}
+
+QRectF RTree::bounds() const
+{
+    if(m_nodes.empty())
+        return QRectF();
+    const Box &box = m_nodes.back().box;
+    return QRectF(QPointF(box.minX, box.minY), QPointF(box.maxX, box.maxY));
+}
+
+void RTree::search(const QRectF &rect, vector<idType> &result) const
+{
+    if(m_nodes.empty())
+        return;
+
+    const Box query = toBox(rect);
+    vector<uint32_t> stack;
+    stack.emplace_back(m_nodes.size() - 1);
+    while(!stack.empty())
+    {
+        const Node &node = m_nodes[stack.back()];
+        stack.pop_back();
+        if(!node.box.intersects(query))
+            continue;
+        for(uint32_t i = node.first; i < node.last; i ++)
+        {
+            if(node.leaf)
+            {
+                if(m_itemBoxes[i].intersects(query))
+                    result.emplace_back(m_itemIds[i]);
+            }
+            else
+                stack.emplace_back(i);
+        }
+    }
+}
+
+vector<idType> RTree::search(const QRectF &rect) const
+{
+    vector<idType> result;
+    search(rect, result);
+    return result;
+}
+
+void RTree::searchPoint(QPointF pos, vector<idType> &result) const
+{
+    if(m_nodes.empty())
+        return;
+
+    const double x = pos.x();
+    const double y = pos.y();
+    vector<uint32_t> stack;
+    stack.emplace_back(m_nodes.size() - 1);
+    while(!stack.empty())
+    {
+        const Node &node = m_nodes[stack.back()];
+        stack.pop_back();
+        if(!node.box.contains(x, y))
+            continue;
+        for(uint32_t i = node.first; i < node.last; i ++)
+        {
+            if(node.leaf)
+            {
+                if(m_itemBoxes[i].contains(x, y))
+                    result.emplace_back(m_itemIds[i]);
+            }
+            else
+                stack.emplace_back(i);
+        }
+    }
+}
+
+vector<idType> RTree::nearest(QPointF pos, size_t k) const
+{
+    vector<idType> result;
+    if(k == 0)
+        return result;
+    visitNearest(pos, [&](idType id, double)
+    {
+        result.emplace_back(id);
+        return result.size() < k;
+    });
+    return result;
+}
+
+RTree::Box RTree::toBox(const QRectF &rect)
+{
+    Box box;
+    box.minX = min(rect.left(), rect.right());
+    box.maxX = max(rect.left(), rect.right());
+    box.minY = min(rect.top(), rect.bottom());
+    box.maxY = max(rect.top(), rect.bottom());
+    return box;
+}
+
+// position of (x, y) along a 16 bits Hilbert curve, branch-free version
+// taken from https://github.com/rawrunprotected/hilbert_curves (public domain)
+uint32_t RTree::hilbert(uint32_t x, uint32_t y)
+{
+    uint32_t a = x ^ y;
+    uint32_t b = 0xFFFF ^ a;
+    uint32_t c = 0xFFFF ^ (x | y);
+    uint32_t d = x & (y ^ 0xFFFF);
+
+    uint32_t A = a | (b >> 1);
+    uint32_t B = (a >> 1) ^ a;
+    uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+    uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+    a = A; b = B; c = C; d = D;
+    A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+    B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+    C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+    D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+    a = A; b = B; c = C; d = D;
+    A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+    B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+    C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+    D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+    a = A; b = B; c = C; d = D;
+    C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+    D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+    a = C ^ (C >> 1);
+    b = D ^ (D >> 1);
+
+    uint32_t i0 = x ^ y;
+    uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+    i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+    i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+    i0 = (i0 | (i0 << 2)) & 0x33333333;
+    i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+    i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+    i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+    i1 = (i1 | (i1 << 2)) & 0x33333333;
+    i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+    return (i1 << 1) | i0;
+}
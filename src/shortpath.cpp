@@ -6,17 +6,57 @@ ShortPath::ShortPath()
   cout << "Dear User careful, This is Empty Path !" << endl;
 }
 // Parameters Constructor
-ShortPath::ShortPath(idType Source1, idType Destination1, Model mModel)
+ShortPath::ShortPath(idType Source1, idType Destination1, Model mModel, travelMode mMode, bool Turns)
 {
-  setSource(Source1);
-  setDestination(Destination1);
+  Mode = mMode;
   setModel(mModel);
-  MyGraphBuilder builder(getModel());
+  // places and addresses are often off the roads, or on roads the mode can't take
+  setSource(snapNode(Source1));
+  setDestination(snapNode(Destination1));
+  // the builder keeps a pointer to the model, it must not be a temporary copy
+  MyGraphBuilder builder(OurModel);
   builder.generateGraph();
-  MyAlgorithm algo(builder.getGraph(), builder.getGraphMap(), Source_ID);
+  if (Turns)
+  {
+    TurnGraph turns;
+    turns.build(builder.getGraph(), builder.getGraphMap(), OurModel);
+    findRoute(builder, builder.getWeights(Mode), &turns);
+  }
+  else
+    findRoute(builder, builder.getWeights(Mode), nullptr);
+}
+// Parameters Constructor, the graph is not built again
+ShortPath::ShortPath(idType Source1, idType Destination1, Model mModel, MyGraphBuilder const& builder,
+                     WeightSet const& weights, TurnGraph const* turns, travelMode mMode)
+{
+  Mode = mMode;
+  setModel(mModel);
+  setSource(snapNode(Source1));
+  setDestination(snapNode(Destination1));
+  findRoute(builder, weights.weights[Mode], turns);
+}
+//----------------------------------------------------------------
+// Search
+void ShortPath::findRoute(MyGraphBuilder const& builder, vector<costType> const& weights, TurnGraph const* turns)
+{
+  GraphMap const& TheMap = builder.getGraphMap();
+  if (turns != nullptr)
+  {
+    TurnAlgorithm algo(*turns, weights, Mode);
+    if (algo.run(TheMap, Source_ID, Destination_ID) != COST_INFINITE)
+    {
+      setMyPath(algo.getShortPath());
+      myroute = algo.getRoute();
+    }
+    else
+      cout << "\nThis Node is Unreachable...\n";
+    return;
+  }
+  MyAlgorithm algo(builder.getGraph(), TheMap, weights, Source_ID);
   if (algo.getFlag())
   {
-    setMyPath(algo.getShortPath(builder.getGraphMap(), Destination_ID));
+    setMyPath(algo.getShortPath(TheMap, Destination_ID));
+    myroute = algo.getRoute(TheMap, Destination_ID);
   }
   else
     cout << "please enter valid node\t" << endl;
@@ -26,7 +66,9 @@ ShortPath::~ShortPath() {} // Destructor
 Model ShortPath::getModel() { return OurModel; }
 idType ShortPath::getSource() { return Source_ID; }
 idType ShortPath::getDestination() { return Destination_ID; }
+travelMode ShortPath::getMode() { return Mode; }
 Path ShortPath::getYourPath() { return mypath; }
+RouteGeometry const& ShortPath::getYourRoute() const { return myroute; }
 //----------------------------------------------------------------
 // Mutator
 void ShortPath::setMyPath(Path ThePath) { mypath = ThePath; }
@@ -34,6 +76,13 @@ void ShortPath::setSource(idType Src) { Source_ID = Src; }
 void ShortPath::setDestination(idType Des) { Destination_ID = Des; }
 void ShortPath::setModel(Model YourModel) { OurModel = YourModel; }
 //---------------------------------------------------------------------
+// Snapping to the roads of the mode
+idType ShortPath::snapNode(idType Node)
+{
+  idType Snapped = OurModel.snapToRoad(projection(OurModel.getNodeLoaction(Node)), Mode);
+  return Snapped != 0 ? Snapped : Node;
+}
+//---------------------------------------------------------------------
 // Print Function
 void ShortPath::printMyPath()
 {
@@ -0,0 +1,196 @@
+#include "simplify.h"
+#include <cmath>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+
+// the levels cover the zoom range of MapView (MAX_SCALE to MIN_SCALE): from 4 m, a quarter
+// of a pixel at the closest zoom, to 1 km, a tenth of a pixel at the farthest
+#define LOD_BASE_TOLERANCE 4.0
+#define LOD_LEVELS 6
+
+// read by the tile workers while the GUI thread sets it
+static atomic<bool> s_lodEnabled(true);
+
+// squared distance from p to the segment ab
+static double segmentDistance2(QPointF p, QPointF a, QPointF b)
+{
+    QPointF ab = b - a;
+    QPointF ap = p - a;
+    double length2 = QPointF::dotProduct(ab, ab);
+    double t = length2 > 0 ? QPointF::dotProduct(ap, ab) / length2 : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    QPointF d = ap - ab * t;
+    return QPointF::dotProduct(d, d);
+}
+
+QPolygonF simplifyDouglasPeucker(const QPolygonF &line, double tolerance, bool closed)
+{
+    PointSpan span;
+    span.data = line.constData();
+    span.size = line.size();
+    return simplifyDouglasPeucker(span, tolerance, closed);
+}
+
+QPolygonF simplifyDouglasPeucker(PointSpan points, double tolerance, bool closed)
+{
+    const QPointF *line = points.data;
+    int n = points.size;
+    if(n <= 2 || tolerance <= 0)
+    {
+        QPolygonF copy;
+        for(int i = 0; i < n; i ++)
+            copy << line[i];
+        return copy;
+    }
+
+    // explicit stack of [first, last] ranges instead of recursion, long coastlines are deep
+    vector<bool> keep(n, false);
+    keep[0] = true;
+    keep[n - 1] = true;
+    vector<pair<int, int>> stack;
+    const double tolerance2 = tolerance * tolerance;
+
+    // a ring starts and ends on the same point, split it at its farthest vertex first
+    int split = n - 1;
+    if(closed)
+    {
+        double farthest = -1;
+        for(int i = 1; i < n - 1; i ++)
+        {
+            QPointF d = line[i] - line[0];
+            double distance2 = QPointF::dotProduct(d, d);
+            if(distance2 > farthest)
+            {
+                farthest = distance2;
+                split = i;
+            }
+        }
+        keep[split] = true;
+        stack.emplace_back(split, n - 1);
+    }
+    stack.emplace_back(0, split);
+
+    while(!stack.empty())
+    {
+        int first = stack.back().first;
+        int last = stack.back().second;
+        stack.pop_back();
+        double farthest = 0;
+        int index = -1;
+        for(int i = first + 1; i < last; i ++)
+        {
+            double distance2 = segmentDistance2(line[i], line[first], line[last]);
+            if(distance2 > farthest)
+            {
+                farthest = distance2;
+                index = i;
+            }
+        }
+        if(index >= 0 && farthest > tolerance2)
+        {
+            keep[index] = true;
+            stack.emplace_back(first, index);
+            stack.emplace_back(index, last);
+        }
+    }
+
+    QPolygonF result;
+    for(int i = 0; i < n; i ++)
+    {
+        if(keep[i])
+            result << line[i];
+    }
+    // a ring reduced to a segment would not be drawn at all
+    if(closed && result.size() < 4)
+        return QPolygonF();
+    return result;
+}
+
+void LevelOfDetail::build(const QPolygonF &line, bool closed)
+{
+    m_copy = line;
+    simplify(closed);
+}
+
+void LevelOfDetail::build(PointSpan line, bool closed)
+{
+    m_copy = QPolygonF();
+    m_full = line;
+    simplify(closed);
+}
+
+void LevelOfDetail::simplify(bool closed)
+{
+    m_levels.clear();
+    PointSpan previous = at(0);
+    double tolerance = LOD_BASE_TOLERANCE;
+    for(int k = 1; k < LOD_LEVELS; k ++, tolerance *= 4)
+    {
+        QPolygonF simplified = simplifyDouglasPeucker(previous, tolerance, closed);
+        // nothing more to remove, the coarser levels would be the same
+        if(simplified.size() == previous.size)
+            break;
+        m_levels.emplace_back(simplified);
+        if(simplified.isEmpty())
+            break;
+        previous = at(m_levels.size());
+    }
+}
+
+PointSpan LevelOfDetail::level(qreal lod) const
+{
+    return at(levelIndex(lod));
+}
+
+PointSpan LevelOfDetail::at(size_t k) const
+{
+    const QPolygonF *polygon = nullptr;
+    if(k > 0 && !m_levels.empty())
+        polygon = &m_levels[min(k, m_levels.size()) - 1];
+    else if(!m_copy.isEmpty())
+        polygon = &m_copy;
+    else
+        return m_full;
+    PointSpan span;
+    span.data = polygon->constData();
+    span.size = polygon->size();
+    return span;
+}
+
+size_t LevelOfDetail::levelIndex(qreal lod)
+{
+    if(!s_lodEnabled || lod <= 0)
+        return 0;
+    // half a pixel in scene units
+    double error = 0.5 / lod;
+    size_t k = 0;
+    while(k + 1 < LOD_LEVELS && tolerance(k + 1) <= error)
+        k ++;
+    return k;
+}
+
+double LevelOfDetail::tolerance(size_t k)
+{
+    return k == 0 ? 0 : LOD_BASE_TOLERANCE * pow(4.0, double(k - 1));
+}
+
+PointSpan LevelOfDetail::full() const
+{
+    return at(0);
+}
+
+size_t LevelOfDetail::levelCount() const
+{
+    return at(0).size == 0 ? 0 : m_levels.size() + 1;
+}
+
+void LevelOfDetail::setEnabled(bool enabled)
+{
+    s_lodEnabled = enabled;
+}
+
+bool LevelOfDetail::isEnabled()
+{
+    return s_lodEnabled;
+}
@@ -0,0 +1,76 @@
+#include "textnormalize.h"
+
+// folding of U+00C0 to U+00FF, encoded as 0xC3 0x80 to 0xC3 0xBF in UTF-8
+static const char *latin1Fold[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c",    // À Á Â Ã Ä Å Æ Ç
+    "e", "e", "e", "e", "i", "i", "i", "i",     // È É Ê Ë Ì Í Î Ï
+    "d", "n", "o", "o", "o", "o", "o", " ",     // Ð Ñ Ò Ó Ô Õ Ö ×
+    "o", "u", "u", "u", "u", "y", "th", "ss",   // Ø Ù Ú Û Ü Ý Þ ß
+    "a", "a", "a", "a", "a", "a", "ae", "c",    // à á â ã ä å æ ç
+    "e", "e", "e", "e", "i", "i", "i", "i",     // è é ê ë ì í î ï
+    "d", "n", "o", "o", "o", "o", "o", " ",     // ð ñ ò ó ô õ ö ÷
+    "o", "u", "u", "u", "u", "y", "th", "y"     // ø ù ú û ü ý þ ÿ
+};
+
+static void appendFolded(std::string &out, const char *folded)
+{
+    for(; *folded != '\0'; folded ++)
+    {
+        // never start with a space or put two in a row
+        if(*folded == ' ' && (out.empty() || out.back() == ' '))
+            continue;
+        out.push_back(*folded);
+    }
+}
+
+std::string normalizeText(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for(size_t i = 0; i < text.size(); i ++)
+    {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        unsigned char next = i + 1 < text.size() ? static_cast<unsigned char>(text[i + 1]) : 0;
+        if(c < 0x80)
+        {
+            if(c >= 'A' && c <= 'Z')
+                out.push_back(static_cast<char>(c - 'A' + 'a'));
+            else if((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+                out.push_back(static_cast<char>(c));
+            else
+                appendFolded(out, " ");
+        }
+        else if(c == 0xC3 && next >= 0x80 && next <= 0xBF)
+        {
+            appendFolded(out, latin1Fold[next - 0x80]);
+            i ++;
+        }
+        else if(c == 0xC5 && (next == 0x92 || next == 0x93))   // Œ œ
+        {
+            appendFolded(out, "oe");
+            i ++;
+        }
+        else if(c == 0xC5 && next == 0xB8)                     // Ÿ
+        {
+            appendFolded(out, "y");
+            i ++;
+        }
+        else if(c == 0xE2 && next == 0x80 && i + 2 < text.size())
+        {
+            // typographic quotes and dashes (U+2010 to U+201F)
+            unsigned char last = static_cast<unsigned char>(text[i + 2]);
+            if(last >= 0x90 && last <= 0x9F)
+            {
+                appendFolded(out, " ");
+                i += 2;
+            }
+            else
+                out.push_back(static_cast<char>(c));
+        }
+        else
+            out.push_back(static_cast<char>(c));
+    }
+    if(!out.empty() && out.back() == ' ')
+        out.pop_back();
+    return out;
+}
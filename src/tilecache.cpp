@@ -0,0 +1,350 @@
+#include "tilecache.h"
+#include "renderitem.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QDir>
+#include <algorithm>
+#include <cmath>
+
+// the web mercator square, in scene units
+static const double WORLD_SIZE = 2 * M_PI * 6378137.0;
+
+TileCache::TileCache(size_t memoryLimit, unsigned threads)
+{
+    m_memoryLimit = memoryLimit;
+    m_memory = 0;
+    // hardware_concurrency() is 0 when it is not known
+    unsigned hc = thread::hardware_concurrency();
+    m_threadCount = threads != 0 ? threads : (hc > 1 ? hc - 1 : 1);
+    m_stop = false;
+    m_busy = 0;
+}
+
+TileCache::~TileCache()
+{
+    stopWorkers();
+}
+
+void TileCache::clear()
+{
+    stopWorkers();
+    m_shapes.clear();
+    m_index.clear();
+    m_lru.clear();
+    m_tiles.clear();
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_queue.clear();
+        m_rendering.clear();
+    }
+    m_memory = 0;
+    m_idle.notify_all();
+}
+
+void TileCache::build(Model &model)
+{
+    clear();
+    const map<idType, wayData> wayMap = model.getWayMap();
+    const map<idType, polygonType> areaMap = model.getAreaMap();
+    const GeometryStore &geometry = model.getGeometry();
+    m_shapes.reserve(wayMap.size() + areaMap.size());
+    for(auto it = wayMap.begin(); it != wayMap.end(); it ++)
+    {
+        const wayData &way = it->second;
+        PointSpan points = geometry.points(it->first);
+        if(points.size == 0)
+            continue;
+
+        Shape shape;
+        shape.closed = way.isPolygon;
+        if(way.isPolygon)
+        {
+            shape.z = way.pType;
+            shape.color = getPolygonColor(way.pType);
+            shape.width = 0;
+        }
+        else
+        {
+            shape.z = leisure + static_cast<int>(way.rType) * 0.1;
+            shape.color = getPathColor(way.rType);
+            shape.width = getPathWidth(way.rType) + 3.0;
+        }
+        shape.bound = geometry.bounds(it->first);
+        shape.lod.build(points, shape.closed);
+        shape.rings = 1;
+        m_shapes.emplace_back(std::move(shape));
+    }
+
+    // areas of the multipolygon relations, a shape per ring simplified on its own, the rings
+    // of an area follow each other and are filled odd-even together
+    for(auto it = areaMap.begin(); it != areaMap.end(); it ++)
+    {
+        idType key = GeometryStore::areaKey(it->first);
+        vector<PointSpan> rings = geometry.rings(key);
+        for(size_t i = 0; i < rings.size(); i ++)
+        {
+            Shape shape;
+            shape.closed = true;
+            shape.z = it->second;
+            shape.color = getPolygonColor(it->second);
+            shape.width = 0;
+            shape.bound = geometry.bounds(key);
+            shape.lod.build(rings[i], true);
+            shape.rings = i == 0 ? rings.size() : 0;
+            m_shapes.emplace_back(std::move(shape));
+        }
+    }
+
+    vector<RTree::Entry> entries;
+    entries.reserve(m_shapes.size());
+    for(size_t i = 0; i < m_shapes.size(); i ++)
+    {
+        if(m_shapes[i].rings == 0)
+            continue;
+        qreal margin = m_shapes[i].width / 2;
+        RTree::Entry entry;
+        entry.box = m_shapes[i].bound.adjusted(-margin, -margin, margin, margin);
+        entry.id = i;
+        entries.emplace_back(entry);
+    }
+    m_index.bulkLoad(std::move(entries));
+    startWorkers();
+}
+
+void TileCache::setDiskCache(const QString &dir)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_diskCache = dir;
+}
+
+QImage TileCache::tile(const TileKey &key)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_tiles.find(key);
+    if(it == m_tiles.end())
+        return QImage();
+    m_lru.splice(m_lru.begin(), m_lru, it->second.position);
+    return it->second.image;
+}
+
+void TileCache::request(const QRectF &view, qreal scale)
+{
+    int z = zoomFor(scale);
+    vector<TileKey> visible = tilesIn(view, z);
+    double side = tileRect(TileKey{z, 0, 0}).width();
+    vector<TileKey> around = tilesIn(view.adjusted(-side, -side, side, side), z);
+
+    lock_guard<mutex> lock(m_mutex);
+    m_queue.clear();
+    unordered_set<TileKey, TileKeyHash> queued;
+    auto push = [&](const TileKey &key)
+    {
+        if(m_tiles.find(key) == m_tiles.end() && m_rendering.find(key) == m_rendering.end() && queued.insert(key).second)
+            m_queue.push_back(key);
+    };
+    for(auto it = visible.begin(); it != visible.end(); it ++)
+        push(*it);
+    for(auto it = around.begin(); it != around.end(); it ++)
+        push(*it);
+    if(!m_queue.empty())
+        m_wake.notify_all();
+}
+
+QImage TileCache::render(const TileKey &key) const
+{
+    QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+    image.fill(QColor(230, 230, 230));
+    QRectF rect = tileRect(key);
+    qreal lod = TILE_SIZE / rect.width();
+
+    // wide roads of the next tiles overlap this one, the boxes of the index include the pen
+    vector<idType> ids = m_index.search(rect);
+    sort(ids.begin(), ids.end(), [this](idType a, idType b)
+    {
+        return m_shapes[a].z < m_shapes[b].z || (m_shapes[a].z == m_shapes[b].z && a < b);
+    });
+
+    QPainter painter(&image);
+    painter.scale(lod, lod);
+    painter.translate(-rect.topLeft());
+    size_t k = LevelOfDetail::levelIndex(lod);
+    for(auto it = ids.begin(); it != ids.end(); it ++)
+    {
+        const Shape &shape = m_shapes[*it];
+        qreal extent = max(shape.bound.width(), shape.bound.height()) * lod;
+        if(shape.closed)
+        {
+            if(LevelOfDetail::isEnabled() && extent < MIN_POLYGON_PIXELS)
+                continue;
+            painter.setPen(QPen());
+            painter.setBrush(shape.color);
+            if(shape.rings == 1)
+            {
+                PointSpan outline = shape.lod.at(k);
+                painter.drawPolygon(outline.data, outline.size, Qt::OddEvenFill);
+                continue;
+            }
+            // a subpath per ring, as WayBatch draws the areas
+            QPainterPath area;
+            area.setFillRule(Qt::OddEvenFill);
+            for(size_t r = *it; r < *it + shape.rings; r ++)
+            {
+                PointSpan outline = m_shapes[r].lod.at(k);
+                if(outline.size == 0)
+                    continue;
+                area.moveTo(outline.data[0]);
+                for(int i = 1; i < outline.size; i ++)
+                    area.lineTo(outline.data[i]);
+                area.closeSubpath();
+            }
+            painter.drawPath(area);
+        }
+        else
+        {
+            if(LevelOfDetail::isEnabled() && extent < MIN_ROAD_PIXELS)
+                continue;
+            QPen pen(shape.color);
+            pen.setWidthF(shape.width);
+            pen.setCapStyle(Qt::RoundCap);
+            painter.setPen(pen);
+            painter.setBrush(Qt::NoBrush);
+            PointSpan line = shape.lod.at(k);
+            painter.drawPolyline(line.data, line.size);
+        }
+    }
+    painter.end();
+    return image;
+}
+
+void TileCache::waitForIdle()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_queue.empty() && m_busy == 0; });
+}
+
+size_t TileCache::memoryUsed()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_memory;
+}
+
+size_t TileCache::tileCount()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_tiles.size();
+}
+
+int TileCache::zoomFor(qreal scale)
+{
+    // the first zoom whose tiles have at least as many pixels per scene unit as the view,
+    // the tiles are then drawn shrunk rather than blurred
+    if(scale <= 0)
+        return 0;
+    int z = static_cast<int>(ceil(log2(scale * WORLD_SIZE / TILE_SIZE)));
+    return max(0, min(MAX_TILE_ZOOM, z));
+}
+
+QRectF TileCache::tileRect(const TileKey &key)
+{
+    // the scene y is minus the mercator y, so the north edge of the world is at -WORLD_SIZE / 2
+    double side = WORLD_SIZE / (1 << key.z);
+    return QRectF(-WORLD_SIZE / 2 + key.x * side, -WORLD_SIZE / 2 + key.y * side, side, side);
+}
+
+vector<TileKey> TileCache::tilesIn(const QRectF &rect, int z)
+{
+    vector<TileKey> keys;
+    int count = 1 << z;
+    double side = WORLD_SIZE / count;
+    int left = max(0, static_cast<int>(floor((rect.left() + WORLD_SIZE / 2) / side)));
+    int right = min(count - 1, static_cast<int>(floor((rect.right() + WORLD_SIZE / 2) / side)));
+    int top = max(0, static_cast<int>(floor((rect.top() + WORLD_SIZE / 2) / side)));
+    int bottom = min(count - 1, static_cast<int>(floor((rect.bottom() + WORLD_SIZE / 2) / side)));
+    for(int y = top; y <= bottom; y ++)
+    {
+        for(int x = left; x <= right; x ++)
+            keys.push_back(TileKey{z, x, y});
+    }
+    return keys;
+}
+
+void TileCache::startWorkers()
+{
+    m_stop = false;
+    for(unsigned i = 0; i < m_threadCount; i ++)
+        m_workers.emplace_back(&TileCache::work, this);
+}
+
+void TileCache::stopWorkers()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_wake.notify_all();
+    for(auto it = m_workers.begin(); it != m_workers.end(); it ++)
+        it->join();
+    m_workers.clear();
+    // the queue was dropped, a thread waiting for the cache to be idle goes on
+    m_idle.notify_all();
+}
+
+void TileCache::work()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while(true)
+    {
+        m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if(m_stop)
+            return;
+        TileKey key = m_queue.front();
+        m_queue.pop_front();
+        m_rendering.insert(key);
+        m_busy ++;
+        QString path = m_diskCache.isEmpty() ? QString() : diskPath(key);
+        lock.unlock();
+
+        QImage image;
+        if(path.isEmpty() || !image.load(path))
+        {
+            image = render(key);
+            if(!path.isEmpty())
+            {
+                QDir().mkpath(path.left(path.lastIndexOf('/')));
+                image.save(path);
+            }
+        }
+
+        lock.lock();
+        insert(key, image);
+        m_rendering.erase(key);
+        m_busy --;
+        if(m_queue.empty() && m_busy == 0)
+            m_idle.notify_all();
+        lock.unlock();
+        emit tileReady(key.z, key.x, key.y);
+        lock.lock();
+    }
+}
+
+void TileCache::insert(const TileKey &key, const QImage &image)
+{
+    if(m_tiles.find(key) != m_tiles.end())
+        return;
+    m_lru.push_front(key);
+    m_tiles[key] = Entry{image, m_lru.begin()};
+    m_memory += image.sizeInBytes();
+    while(m_memory > m_memoryLimit && m_lru.size() > 1)
+    {
+        auto last = m_tiles.find(m_lru.back());
+        m_memory -= last->second.image.sizeInBytes();
+        m_tiles.erase(last);
+        m_lru.pop_back();
+    }
+}
+
+QString TileCache::diskPath(const TileKey &key) const
+{
+    return QString("%1/%2/%3/%4.png").arg(m_diskCache).arg(key.z).arg(key.x).arg(key.y);
+}
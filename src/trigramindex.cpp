@@ -0,0 +1,77 @@
+#include "trigramindex.h"
+#include <algorithm>
+
+TrigramIndex::TrigramIndex()
+{
+    m_docCount = 0;
+}
+
+uint32_t TrigramIndex::trigram(const string &text, size_t pos)
+{
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16)
+         | (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8)
+         | static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+    m_docCount = 0;
+}
+
+void TrigramIndex::add(uint32_t doc, const string &text)
+{
+    if(doc + 1 > m_docCount)
+        m_docCount = doc + 1;
+    for(size_t i = 0; i + 3 <= text.size(); i ++)
+    {
+        vector<uint32_t> &posting = m_postings[trigram(text, i)];
+        // ids come in increasing order, so a duplicate can only be the last one
+        if(posting.empty() || posting.back() != doc)
+            posting.emplace_back(doc);
+    }
+}
+
+bool TrigramIndex::candidates(const string &query, vector<uint32_t> &result) const
+{
+    result.clear();
+    if(query.size() < 3)
+        return false;
+
+    vector<const vector<uint32_t> *> lists;
+    for(size_t i = 0; i + 3 <= query.size(); i ++)
+    {
+        auto it = m_postings.find(trigram(query, i));
+        if(it == m_postings.end())
+            return true;    // one trigram is never seen, nothing can match
+        lists.emplace_back(&it->second);
+    }
+
+    // intersect from the shortest list, the result can only get smaller
+    // (the pointer as second key puts the repeated trigrams next to each other)
+    sort(lists.begin(), lists.end(), [](const vector<uint32_t> *a, const vector<uint32_t> *b)
+    {
+        return a->size() < b->size() || (a->size() == b->size() && a < b);
+    });
+    lists.erase(unique(lists.begin(), lists.end()), lists.end());
+
+    result = *lists.front();
+    vector<uint32_t> merged;
+    for(size_t i = 1; i < lists.size() && !result.empty(); i ++)
+    {
+        merged.clear();
+        set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(), back_inserter(merged));
+        result.swap(merged);
+    }
+    return true;
+}
+
+size_t TrigramIndex::trigramCount() const
+{
+    return m_postings.size();
+}
+
+size_t TrigramIndex::documentCount() const
+{
+    return m_docCount;
+}
@@ -0,0 +1,120 @@
+#include <turnalgorithm.h>
+#include <algorithm>
+//===============================================
+using namespace std;
+using namespace boost;
+//===============================================
+
+const unsigned int TurnAlgorithm::NoEdge;
+//===========================================================================
+TurnAlgorithm::TurnAlgorithm(TurnGraph const& AnyTurns, vector<costType> const& AnyWeights, travelMode AnyMode)
+  : Turns(&AnyTurns), Weights(&AnyWeights), Mode(AnyMode), Last(NoEdge), Source(0), Reached(false), Settled(0) {}
+//===========================================================================
+costType TurnAlgorithm::run(GraphMap const& AnyGraphMap, idType Source2, idType Destination2) {
+  graph_t const& Graph = Turns->getGraph();
+  vector <costType> const& Weight = *Weights;
+  Last = NoEdge;
+  Reached = false;
+  Settled = 0;
+  auto FoundSource = AnyGraphMap.find(Source2);
+  auto FoundDestination = AnyGraphMap.find(Destination2);
+  if (FoundSource == AnyGraphMap.end() || (Destination2 != 0 && FoundDestination == AnyGraphMap.end()))
+    return COST_INFINITE;
+  Source = FoundSource->second;
+  unsigned int Target = Destination2 != 0 ? FoundDestination->second : UINT32_MAX;
+  if (Source == Target) {
+      Reached = true;
+      return 0;
+    }
+  //===================================================
+  distances.assign(Turns->getEdgeCount(), COST_INFINITE);
+  predecessors.assign(Turns->getEdgeCount(), NoEdge);
+  Queue.clear();
+  // the first edges have no turn before them
+  graph_traits<graph_t>::out_edge_iterator e, end;
+  for (tie(e, end) = out_edges(Source, Graph); e != end; ++e) {
+      unsigned int Index = Graph[*e].index;
+      if (Weight[Index] == COST_INFINITE || Weight[Index] >= distances[Index]) continue;
+      distances[Index] = Weight[Index];
+      Queue.push(Weight[Index], Index);
+    }
+  costType Best = COST_INFINITE;
+  while (!Queue.empty()) {
+      pair<costType, unsigned int> Top = Queue.pop();
+      unsigned int From = Top.second;
+      // stale entry, the edge was reached at a lower cost since
+      if (Top.first != distances[From]) continue;
+      Settled++;
+      unsigned int Via = target(Turns->getEdge(From), Graph);
+      // the first edge into the destination popped is the best route
+      if (Via == Target) {
+          Last = From;
+          Reached = true;
+          Best = Top.first;
+          break;
+        }
+      for (tie(e, end) = out_edges(Via, Graph); e != end; ++e) {
+          unsigned int To = Graph[*e].index;
+          if (Weight[To] == COST_INFINITE || Turns->isForbidden(Mode, From, To)) continue;
+          // the sum is checked against overflow like in MyAlgorithm
+          costType Step = Weight[To] + Turns->turnCost(Mode, From, To);
+          if (Step < Weight[To] || Step > COST_INFINITE - Top.first) continue;
+          costType Cost = Top.first + Step;
+          if (Cost < distances[To]) {
+              distances[To] = Cost;
+              predecessors[To] = From;
+              Queue.push(Cost, To);
+            }
+        }
+    }
+  return Best;
+}
+//===========================================================================
+// Accessors
+Path TurnAlgorithm::getShortPath() const {
+  RouteGeometry Route = getRoute();
+  return Route.nodes;
+}
+//===========================================================================
+// the edges of the route from the last one back, then their points and properties
+RouteGeometry TurnAlgorithm::getRoute() const {
+  RouteGeometry Route;
+  graph_t const& Graph = Turns->getGraph();
+  if (!Reached)
+    return Route;
+  if (Last == NoEdge) {
+      // the source is the destination
+      Route.nodes.push_back(Graph[Source].node);
+      Route.points.push_back(Graph[Source].point);
+      Route.distance.push_back(0);
+      return Route;
+    }
+  vector <unsigned int> Edges;
+  for (unsigned int Index = Last; Index != NoEdge; Index = predecessors[Index])
+    Edges.push_back(Index);
+  reverse(Edges.begin(), Edges.end());
+  //===================================================
+  Route.nodes.reserve(Edges.size() + 1);
+  Route.points.reserve(Edges.size() + 1);
+  Route.distance.reserve(Edges.size() + 1);
+  Route.ways.reserve(Edges.size());
+  Route.roads.reserve(Edges.size());
+  VertexInfo const& First = Graph[source(Turns->getEdge(Edges[0]), Graph)];
+  Route.nodes.push_back(First.node);
+  Route.points.push_back(First.point);
+  Route.distance.push_back(0);
+  for (auto it = Edges.begin(); it != Edges.end(); ++it) {
+      Edge const& Segment = Turns->getEdge(*it);
+      VertexInfo const& Info = Graph[target(Segment, Graph)];
+      EdgeInfo const& Properties = Graph[Segment];
+      Route.nodes.push_back(Info.node);
+      Route.points.push_back(Info.point);
+      Route.distance.push_back(Route.distance.back() + Properties.length);
+      Route.ways.push_back(Properties.way);
+      Route.roads.push_back(Properties.road);
+    }
+  return Route;
+}
+
+size_t TurnAlgorithm::getSettledCount() const { return Settled; }
+//===================================================================
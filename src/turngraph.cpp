@@ -0,0 +1,120 @@
+#include <turngraph.h>
+#include <algorithm>
+#include <math.h>
+//===============================================
+using namespace std;
+using namespace boost;
+//===============================================
+
+TurnGraph::TurnGraph() : Graph(nullptr), Unsupported(0) {}
+//================================================================
+// Builder
+//================================================================
+void TurnGraph::build(graph_t const& AnyGraph, GraphMap const& AnyGraphMap, Model &AnyModel) {
+  Graph = &AnyGraph;
+  Unsupported = 0;
+  Edges.assign(num_edges(AnyGraph), Edge());
+  Bearing.assign(num_edges(AnyGraph), 0);
+  graph_traits<graph_t>::edge_iterator e, end;
+  for (tie(e, end) = edges(AnyGraph); e != end; ++e) {
+      unsigned int Index = AnyGraph[*e].index;
+      Edges[Index] = *e;
+      QPointF d = AnyGraph[target(*e, AnyGraph)].point - AnyGraph[source(*e, AnyGraph)].point;
+      Bearing[Index] = static_cast<float>(atan2(d.y(), d.x()));
+    }
+  //---------------------------------------------------
+  // the restrictions, each mode reads them with its own exceptions
+  const map<idType, relationData> Relations = AnyModel.getRelationMap();
+  for (int m = 0; m < MODE_COUNT; m++) {
+      Forbidden[m].clear();
+      Restricted[m].assign(Edges.size(), false);
+      for (auto it = Relations.begin(); it != Relations.end(); ++it) {
+          string Value;
+          if (restrictionFor(static_cast<travelMode>(m), it->second.tagList, Value))
+            addRestriction(static_cast<travelMode>(m), AnyGraphMap, it->second, Value);
+        }
+      sort(Forbidden[m].begin(), Forbidden[m].end());
+      Forbidden[m].erase(unique(Forbidden[m].begin(), Forbidden[m].end()), Forbidden[m].end());
+      Forbidden[m].shrink_to_fit();
+    }
+  cout<<"\nTurn Restrictions : \t"<<Forbidden[CarMode].size()<<" forbidden car turns, "<<Unsupported<<" unsupported"<<endl;
+}
+//================================================================
+// a restriction with a via node: the turns from the edges of the from way into the via node,
+// to the edges of the to way out of it (no_*) or to every other edge out of it (only_*)
+void TurnGraph::addRestriction(travelMode Mode, GraphMap const& AnyGraphMap, relationData const& Relation, string const& Value) {
+  idType From = 0, Via = 0, To = 0;
+  for (auto it = Relation.memberList.begin(); it != Relation.memberList.end(); ++it) {
+      if (it->role == "from" && it->type == osmium::item_type::way) From = it->ref;
+      else if (it->role == "to" && it->type == osmium::item_type::way) To = it->ref;
+      else if (it->role == "via" && it->type == osmium::item_type::node) Via = it->ref;
+      else if (it->role == "via") {
+          // via ways are left out
+          if (Mode == CarMode) Unsupported++;
+          return;
+        }
+    }
+  auto Found = AnyGraphMap.find(Via);
+  if (From == 0 || To == 0 || Found == AnyGraphMap.end()) {
+      if (Mode == CarMode) Unsupported++;
+      return;
+    }
+  bool Only = Value.compare(0, 5, "only_") == 0;
+  // the edges into the vertex are the reverse of the edges out of it
+  vector <unsigned int> Into, Out;
+  graph_traits<graph_t>::out_edge_iterator e, end;
+  for (tie(e, end) = out_edges(Found->second, *Graph); e != end; ++e) {
+      EdgeInfo const& Info = (*Graph)[*e];
+      if (Info.way == From) Into.push_back(Info.index ^ 1);
+      if ((Info.way == To) != Only) Out.push_back(Info.index);
+    }
+  for (auto i = Into.begin(); i != Into.end(); ++i) {
+      for (auto o = Out.begin(); o != Out.end(); ++o) {
+          // from and to the same way (no_u_turn): the via node in the middle of the way has both
+          // directions in each list, only the turn back along the edge itself is meant
+          if (From == To && !Only && *o != (*i ^ 1)) continue;
+          Forbidden[Mode].emplace_back(*i, *o);
+          Restricted[Mode][*i] = true;
+        }
+    }
+}
+//================================================================
+// Accessors
+graph_t const& TurnGraph::getGraph() const { return *Graph; }
+Edge const& TurnGraph::getEdge(unsigned int Index) const { return Edges[Index]; }
+size_t TurnGraph::getEdgeCount() const { return Edges.size(); }
+size_t TurnGraph::getRestrictionCount(travelMode Mode) const { return Forbidden[Mode].size(); }
+size_t TurnGraph::getUnsupportedCount() const { return Unsupported; }
+
+bool TurnGraph::isForbidden(travelMode Mode, unsigned int From, unsigned int To) const {
+  // most edges have no restriction, the list is only searched for the others
+  if (!Restricted[Mode][From]) return false;
+  return binary_search(Forbidden[Mode].begin(), Forbidden[Mode].end(), make_pair(From, To));
+}
+
+costType TurnGraph::turnCost(travelMode Mode, unsigned int From, unsigned int To) const {
+  double Angle = fabs(Bearing[To] - Bearing[From]);
+  if (Angle > M_PI) Angle = 2 * M_PI - Angle;
+  // back along the same segment, whatever the points say
+  if ((From ^ 1) == To) Angle = M_PI;
+  return turnPenalty(Mode, Angle * 180 / M_PI);
+}
+
+size_t TurnGraph::memoryUsed() const {
+  size_t Bytes = Edges.capacity() * sizeof(Edge) + Bearing.capacity() * sizeof(float);
+  for (int m = 0; m < MODE_COUNT; m++)
+    Bytes += Forbidden[m].capacity() * sizeof(pair<unsigned int, unsigned int>) + Restricted[m].size() / 8;
+  return Bytes;
+}
+
+size_t TurnGraph::getTurnCount() const {
+  // every edge into a vertex turns into every edge out of it, the in-degree is the out-degree
+  size_t Turns = 0;
+  graph_traits<graph_t>::vertex_iterator v, end;
+  for (tie(v, end) = vertices(*Graph); v != end; ++v) {
+      size_t Degree = out_degree(*v, *Graph);
+      Turns += Degree * Degree;
+    }
+  return Turns;
+}
+//================================================================
@@ -0,0 +1,179 @@
+#include <weightoverlay.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+//===============================================
+using namespace std;
+using namespace boost;
+//===============================================
+
+WeightOverlay::WeightOverlay() : Unknown(0) {
+  Front = std::make_shared<Buffer>();
+}
+//================================================================
+// way -> edges index, built once with the graph
+//================================================================
+void WeightOverlay::build(MyGraphBuilder const& Builder) {
+  lock_guard<mutex> lock(Writer);
+  graph_t const& Graph = Builder.getGraph();
+  vector <pair<idType, unsigned int>> Pairs;
+  Pairs.reserve(num_edges(Graph));
+  graph_traits<graph_t>::edge_iterator e, end;
+  for (tie(e, end) = edges(Graph); e != end; ++e)
+    Pairs.emplace_back(Graph[*e].way, Graph[*e].index);
+  sort(Pairs.begin(), Pairs.end());
+
+  Ways.clear();
+  First.clear();
+  WayEdges.clear();
+  WayEdges.reserve(Pairs.size());
+  for (auto it = Pairs.begin(); it != Pairs.end(); ++it) {
+      if (Ways.empty() || Ways.back() != it->first) {
+          Ways.push_back(it->first);
+          First.push_back(WayEdges.size());
+        }
+      WayEdges.push_back(it->second);
+    }
+  First.push_back(WayEdges.size());
+  //---------------------------------------------------
+  std::shared_ptr<Buffer> Weights = std::make_shared<Buffer>();
+  Weights->set.version = 0;
+  for (int m = 0; m < MODE_COUNT; m++) {
+      Base[m] = Builder.getWeights(static_cast<travelMode>(m));
+      Weights->set.weights[m] = Base[m];
+    }
+  {
+    lock_guard<mutex> published(Publish);
+    Front = Weights;
+  }
+  Back.reset();
+  Stale.clear();
+  Unknown = 0;
+}
+//================================================================
+// the set is counted under the lock that publishes, a set replaced meanwhile gets no new reader
+std::shared_ptr<const WeightSet> WeightOverlay::snapshot() const {
+  lock_guard<mutex> published(Publish);
+  std::shared_ptr<Buffer> Current = Front;
+  Current->readers.fetch_add(1, memory_order_relaxed);
+  // the deleter keeps the buffer alive, and releases the reads of the query to the writer
+  return std::shared_ptr<const WeightSet>(&Current->set, [Current](const WeightSet*) {
+    Current->readers.fetch_sub(1, memory_order_release);
+  });
+}
+//================================================================
+// Updates
+//================================================================
+size_t WeightOverlay::apply(vector<WeightUpdate> const& Updates) {
+  lock_guard<mutex> lock(Writer);
+  std::shared_ptr<Buffer> Current;
+  {
+    lock_guard<mutex> published(Publish);
+    Current = Front;
+  }
+  // the back set catches up with the front one, on the edges of the previous apply only
+  // it is no longer published, so once its count is 0 no query reads it anymore
+  if (!Back || Back->readers.load(memory_order_acquire) != 0) {
+      Back = std::make_shared<Buffer>();
+      Back->set = Current->set;
+    }
+  else {
+      for (auto e = Stale.begin(); e != Stale.end(); ++e)
+        for (int m = 0; m < MODE_COUNT; m++)
+          Back->set.weights[m][*e] = Current->set.weights[m][*e];
+    }
+  Stale.clear();
+  //---------------------------------------------------
+  size_t Applied = 0;
+  Unknown = 0;
+  for (auto it = Updates.begin(); it != Updates.end(); ++it) {
+      size_t Count = 0;
+      unsigned int const* Edges = getWayEdges(it->way, Count);
+      if (Edges == nullptr) {
+          Unknown++;
+          continue;
+        }
+      for (size_t i = 0; i < Count; i++) {
+          unsigned int Index = Edges[i];
+          for (int m = 0; m < MODE_COUNT; m++) {
+              costType Weight = Base[m][Index];
+              // what a profile can't take stays closed
+              if (Weight != COST_INFINITE) {
+                  // clamped before rounding, a huge factor must not wrap to a free road
+                  double Scaled = min<double>(Weight * it->factor, COST_INFINITE - 1);
+                  Weight = it->closed ? COST_INFINITE : static_cast<costType>(llround(Scaled));
+                }
+              Back->set.weights[m][Index] = Weight;
+            }
+          Stale.push_back(Index);
+        }
+      Applied++;
+    }
+  //---------------------------------------------------
+  // publish, the previous version is the next one written
+  Back->set.version = Current->set.version + 1;
+  {
+    lock_guard<mutex> published(Publish);
+    Front = Back;
+  }
+  Back = Current;
+  return Applied;
+}
+//================================================================
+bool WeightOverlay::parseLine(string const& Line, WeightUpdate &Update) {
+  istringstream Stream(Line.substr(0, Line.find('#')));
+  string Value;
+  if (!(Stream >> Update.way >> Value)) return false;
+  Update.closed = Value == "closed";
+  Update.factor = 1;
+  if (Update.closed || Value == "open") return true;
+  char *End = nullptr;
+  Update.factor = strtod(Value.c_str(), &End);
+  return *End == '\0' && std::isfinite(Update.factor) && Update.factor > 0;
+}
+
+size_t WeightOverlay::load(istream &Stream) {
+  vector <WeightUpdate> Updates;
+  string Line;
+  size_t Errors = 0;
+  while (getline(Stream, Line)) {
+      WeightUpdate Update;
+      if (parseLine(Line, Update)) Updates.push_back(Update);
+      else if (Line.find_first_not_of(" \t\r") != string::npos && Line[Line.find_first_not_of(" \t\r")] != '#') Errors++;
+    }
+  size_t Applied = apply(Updates);
+  cout<<"\nWeight Updates : \t"<<Applied<<" applied, "<<Unknown<<" unknown ways, "<<Errors<<" malformed lines"<<endl;
+  return Applied;
+}
+
+bool WeightOverlay::loadFile(string const& Path) {
+  ifstream Stream(Path);
+  if (!Stream) return false;
+  load(Stream);
+  return true;
+}
+//================================================================
+void WeightOverlay::reset() {
+  vector <WeightUpdate> Updates;
+  Updates.reserve(Ways.size());
+  for (auto it = Ways.begin(); it != Ways.end(); ++it)
+    Updates.push_back(WeightUpdate{*it, 1, false});
+  apply(Updates);
+}
+//================================================================
+// Accessors
+size_t WeightOverlay::getUnknownCount() const { return Unknown; }
+size_t WeightOverlay::getWayCount() const { return Ways.size(); }
+
+unsigned int const* WeightOverlay::getWayEdges(idType Way, size_t &Count) const {
+  auto Found = lower_bound(Ways.begin(), Ways.end(), Way);
+  if (Found == Ways.end() || *Found != Way) {
+      Count = 0;
+      return nullptr;
+    }
+  size_t i = Found - Ways.begin();
+  Count = First[i + 1] - First[i];
+  return WayEdges.data() + First[i];
+}
+//================================================================